@@ -14,6 +14,7 @@
 
 #include <unistd.h>
 #include <cstdlib>
+#include <cstring>
 
 #include "dabc/logging.h"
 
@@ -23,6 +24,7 @@
 #include "dabc/Buffer.h"
 #include "dabc/BuffersQueue.h"
 #include "dabc/Manager.h"
+#include "dabc/Configuration.h"
 #include "dabc/timing.h"
 #include "dabc/statistic.h"
 #include "dabc/MemoryPool.h"
@@ -1374,3 +1376,381 @@ extern "C" void RunLockTest()
    if (cnt > 0)
       DOUT0("Time for 1000000 locks is %7.6f  per lock %7.6f ns", spent, spent/cnt*1e6);
 }
+
+class RefCopyRunnable : public dabc::Runnable {
+   public:
+      dabc::Reference fRef;
+      long fCnt{0};
+
+      RefCopyRunnable(const dabc::Reference &ref, long cnt) : dabc::Runnable(), fRef(ref), fCnt(cnt) {}
+
+      void* MainLoop() override
+      {
+         for (long n = 0; n < fCnt; n++) {
+            dabc::Reference ref1(fRef);
+            dabc::Reference ref2 = ref1;
+         }
+         return nullptr;
+      }
+};
+
+extern "C" void RunRefTest()
+{
+   // measure reference copies on same object from several threads,
+   // each loop iteration makes two copies and two releases
+
+   const long cnt = 2000000;
+
+   dabc::Reference obj(new dabc::Object(nullptr, "RefTestObj", 0));
+   dabc::Reference autoobj(new dabc::Object(nullptr, "RefTestAutoObj", 0));
+   autoobj.SetAutoDestroy(true);
+
+   for (int kind = 0; kind < 2; kind++)
+      for (int nthrds = 1; nthrds <= 8; nthrds *= 2) {
+         std::vector<dabc::PosixThread*> thrds;
+         std::vector<RefCopyRunnable*> runs;
+
+         dabc::TimeStamp tm1 = dabc::Now();
+
+         for (int n = 0; n < nthrds; n++) {
+            runs.push_back(new RefCopyRunnable(kind == 0 ? obj : autoobj, cnt));
+            thrds.push_back(new dabc::PosixThread());
+            thrds.back()->Start(runs.back());
+         }
+
+         for (int n = 0; n < nthrds; n++) {
+            thrds[n]->Join();
+            delete thrds[n];
+            delete runs[n];
+         }
+
+         double spent = tm1.SpentTillNow();
+
+         DOUT0("%s object threads %d reference copies %5.2f M/s total",
+               (kind == 0 ? "normal" : "autodestroy"), nthrds, spent > 0 ? 2.*cnt*nthrds/spent*1e-6 : 0.);
+      }
+
+   DOUT0("Reference counters after test %u %u", obj.NumReferences(), autoobj.NumReferences());
+
+   obj.Destroy();
+   autoobj.Destroy();
+}
+
+class TimeoutTestWorker : public dabc::Worker {
+   public:
+      long fCalls{0};
+      double fLate{0.};
+      dabc::TimeStamp fExpected;
+
+      TimeoutTestWorker(const std::string &name) : dabc::Worker(nullptr, name) {}
+
+      double NextTimeout()
+      {
+         double tmout = 0.01 + 0.99*rand()/RAND_MAX;
+         fExpected = dabc::Now() + tmout;
+         return tmout;
+      }
+
+      double ProcessTimeout(double) override
+      {
+         double late = dabc::Now() - fExpected;
+         if (late > 0) fLate += late;
+         fCalls++;
+         return NextTimeout();
+      }
+};
+
+extern "C" void RunTimeoutsTest()
+{
+   // many workers in same thread with random timeouts,
+   // measures overhead of timeouts scheduling in the thread
+
+   const int number = 1000;
+
+   std::vector<dabc::WorkerRef> workers;
+
+   dabc::ThreadRef thrd = dabc::mgr.CreateThread("TimeoutsThread");
+
+   for (int n = 0; n < number; n++) {
+      TimeoutTestWorker *w = new TimeoutTestWorker(dabc::format("TmoutWorker%d", n));
+      workers.emplace_back(w);
+      w->AssignToThread(thrd);
+      w->ActivateTimeout(w->NextTimeout());
+   }
+
+   dabc::CpuStatistic cpu;
+   cpu.Reset();
+
+   dabc::TimeStamp tm1 = dabc::Now();
+
+   dabc::mgr.Sleep(5, "Timeouts");
+
+   cpu.Measure();
+
+   double spent = tm1.SpentTillNow();
+
+   long calls = 0;
+   double late = 0.;
+
+   for (int n = 0; n < number; n++) {
+      TimeoutTestWorker *w = dynamic_cast<TimeoutTestWorker *>(workers[n]());
+      calls += w->fCalls;
+      late += w->fLate;
+   }
+
+   DOUT0("Workers %d timeouts %ld rate %5.1f k/s average delay %5.3f ms CPU = %5.1f",
+         number, calls, calls/spent*1e-3, calls > 0 ? late/calls*1e3 : 0., cpu.CPUutil()*100.);
+
+   for (int n = 0; n < number; n++)
+      workers[n].Destroy();
+
+   thrd.Destroy();
+}
+
+
+extern "C" void RunCommandFieldsTest()
+{
+   // measures throughput of command fields access,
+   // typical pattern - create command, set several fields, read them back
+
+   const int number = 200000;
+
+   long sum = 0;
+
+   dabc::SmallObjects::Statistic stat0 = dabc::SmallObjects::GetStatistic();
+
+   dabc::TimeStamp tm1 = dabc::Now();
+
+   for (int n = 0; n < number; n++) {
+      dabc::Command cmd("TestFieldsCmd");
+      cmd.SetInt("Number", n);
+      cmd.SetStr("Kind", "test");
+      cmd.SetDouble("Value", 1.5);
+      cmd.SetBool("Flag", true);
+      cmd.SetUInt("Mask", 0x55);
+      cmd.SetPriority(dabc::Worker::priorityMaximum);
+      cmd.SetResult(dabc::cmd_true);
+      sum += cmd.GetInt("Number") + cmd.GetStr("Kind").length() + (long) cmd.GetDouble("Value") +
+             (cmd.GetBool("Flag") ? 1 : 0) + cmd.GetUInt("Mask") + cmd.GetResult() + cmd.GetInt("Missing", 1);
+   }
+
+   double spent1 = tm1.SpentTillNow();
+
+   // same fields access, but without command creation
+   dabc::Command cmd("TestFieldsCmd");
+   const std::string name1 = "Number", name2 = "Value", name3 = "Flag", name4 = "Missing";
+
+   dabc::TimeStamp tm2 = dabc::Now();
+
+   for (int n = 0; n < number; n++) {
+      cmd.SetInt(name1, n);
+      cmd.SetDouble(name2, 1.5);
+      cmd.SetBool(name3, true);
+      sum += cmd.GetInt(name1) + (long) cmd.GetDouble(name2) + (cmd.GetBool(name3) ? 1 : 0) + cmd.GetInt(name4, 1);
+   }
+
+   double spent2 = tm2.SpentTillNow();
+
+   // many fields in the record, typical for hierarchy items and parameters
+   const int nfields = 50;
+   std::vector<std::string> names;
+   dabc::Command big("TestBigCmd");
+   for (int n = 0; n < nfields; n++) {
+      names.emplace_back(dabc::format("field%02d", n));
+      big.SetInt(names.back(), n);
+   }
+
+   dabc::TimeStamp tm3 = dabc::Now();
+
+   for (int n = 0; n < number; n++)
+      sum += big.GetInt(names[n % nfields]);
+
+   double spent3 = tm3.SpentTillNow();
+
+   dabc::TimeStamp tm4 = dabc::Now();
+
+   const int nclone = number/20;
+   for (int n = 0; n < nclone; n++) {
+      dabc::RecordFieldsMap *map = big.GetObject()->Fields().Clone();
+      sum += map->NumFields() + map->StoreSize();
+      delete map;
+   }
+
+   double spent4 = tm4.SpentTillNow();
+
+   dabc::SmallObjects::Statistic stat = dabc::SmallObjects::GetStatistic();
+
+   DOUT0("Command create/set/get %5.3f us, 4 set/get %5.3f us, get of %d fields %5.3f us, clone+size %5.3f us (sum %ld)",
+         spent1/number*1e6, spent2/number*1e6, nfields, spent3/number*1e6, spent4/nclone*1e6, sum);
+
+   DOUT0("Small objects keep %u allocated %lu reused %lu released %lu freed %lu",
+         dabc::SmallObjects::GetMaxKeep(),
+         (long unsigned) (stat.allocated - stat0.allocated), (long unsigned) (stat.reused - stat0.reused),
+         (long unsigned) (stat.released - stat0.released), (long unsigned) (stat.freed - stat0.freed));
+}
+
+static bool CompareCommands(dabc::Command &cmd1, dabc::Command &cmd2)
+{
+   if (!cmd2.IsName(cmd1.GetName())) return false;
+
+   unsigned num = cmd1.NumFields(), cnt = 0;
+   for (unsigned n = 0; n < num; n++) {
+      std::string name = cmd1.FieldName(n);
+      if (name[0] == '#') continue;
+      cnt++;
+      if (!cmd2.HasField(name) || (cmd1.GetField(name).AsJson() != cmd2.GetField(name).AsJson())) {
+         EOUT("Field %s differ %s %s", name.c_str(), cmd1.GetField(name).AsJson().c_str(), cmd2.GetField(name).AsJson().c_str());
+         return false;
+      }
+   }
+
+   return cnt == cmd2.NumFields();
+}
+
+extern "C" void RunCommandSerialTest()
+{
+   // round-trip of all kinds of fields in both binary encodings
+   // and throughput of command store/restore, as done in command channel
+
+   dabc::Command cmd("TestSerialCmd");
+   cmd.SetBool("bool", true);
+   cmd.SetInt("int", -1234567);
+   cmd.SetField("int64", (int64_t) -0x123456789LL);
+   cmd.SetUInt("uint", 0xfffffff0);
+   cmd.SetDouble("double", -1.25e-7);
+   cmd.SetStr("str", "some string value");
+   cmd.SetStr("empty", "");
+   cmd.SetField("datime", dabc::DateTime().GetNow());
+   cmd.SetField("arrint", std::vector<int64_t>({ -5, 0, 7, 1LL << 40 }));
+   cmd.SetField("arruint", std::vector<uint64_t>({ 0, 127, 128, 0xffffffffffffffffLLU }));
+   cmd.SetField("arrdouble", std::vector<double>({ 1.5, -2.5, 1e100 }));
+   cmd.SetField("arrstr", std::vector<std::string>({ "first", "", "third" }));
+   cmd.SetField("nullfield", dabc::RecordField());
+   cmd.SetField("#hidden", 5);
+   cmd.SetReceiver("dabc://node:1237/some/item");
+   cmd.SetTimeout(5.);
+   dabc::Buffer buf = dabc::Buffer::CreateBuffer(100);
+   memset(buf.SegmentPtr(), 0x5a, 100);
+   cmd.SetField("buffer", buf);
+
+   for (unsigned version = dabc::storeversion_Aligned; version <= dabc::storeversion_Compact; version++) {
+      dabc::Buffer data = cmd.SaveToBuffer(version);
+      dabc::Command res;
+      bool ok = res.ReadFromBuffer(data, version) && CompareCommands(cmd, res);
+      DOUT0("Encoding %u round-trip %s size %u", version, ok ? "ok" : "FAILURE", (unsigned) data.GetTotalSize());
+
+      // truncated data should be rejected
+      if (data.GetTotalSize() > 20) {
+         dabc::Command res2;
+         data.SetTotalSize(data.GetTotalSize() - 5);
+         if (version == dabc::storeversion_Compact)
+            DOUT0("Encoding %u truncated data %s", version, res2.ReadFromBuffer(data, version) ? "FAILURE" : "rejected");
+      }
+   }
+
+   // typical command, used by master to request hierarchy or statistic from remote node
+   dabc::Command typical("GetBinary");
+   typical.SetStr("Item", "/bnet/Builder0/Stat");
+   typical.SetStr("Kind", "hierarchy");
+   typical.SetUInt("version", 12345);
+   typical.SetInt("history", 0);
+   typical.SetBool("compact", true);
+   typical.SetUInt("__send_cmdid__", 17);
+   typical.SetReceiver("dabc://builder0:12345/bnet/Builder0");
+   typical.SetTimeout(10.);
+
+   const int number = 200000;
+
+   for (unsigned version = dabc::storeversion_Aligned; version <= dabc::storeversion_Compact; version++) {
+      long sum = 0;
+      dabc::TimeStamp tm1 = dabc::Now();
+      for (int n = 0; n < number; n++) {
+         dabc::Buffer data = typical.SaveToBuffer(version);
+         sum += data.GetTotalSize();
+      }
+      double spent1 = tm1.SpentTillNow();
+
+      dabc::Buffer data = typical.SaveToBuffer(version);
+      dabc::TimeStamp tm2 = dabc::Now();
+      for (int n = 0; n < number; n++) {
+         dabc::Command res;
+         res.ReadFromBuffer(data, version);
+         sum += res.NumFields();
+      }
+      double spent2 = tm2.SpentTillNow();
+
+      DOUT0("Encoding %u size %u bytes store %5.3f us restore %5.3f us (sum %ld)",
+            version, (unsigned) data.GetTotalSize(), spent1/number*1e6, spent2/number*1e6, sum);
+   }
+}
+
+class CmdChannelTestWorker : public dabc::Worker {
+   public:
+      dabc::Command fMain;
+      int fNumber{0};
+      int fReplied{0};
+      int fFailed{0};
+
+      CmdChannelTestWorker(const std::string &name) : dabc::Worker(nullptr, name) {}
+
+      int ExecuteCommand(dabc::Command cmd) override
+      {
+         if (cmd.IsName("SendPings")) {
+            fMain = cmd;
+            fNumber = cmd.GetInt("number");
+            fReplied = fFailed = 0;
+            std::string receiver = cmd.GetStr("receiver");
+            // all commands submitted at once, replies can come in any order
+            for (int n = 0; n < fNumber; n++) {
+               dabc::Command ping("Ping");
+               ping.SetReceiver(receiver);
+               ping.SetTimeout(10.);
+               dabc::mgr.Submit(Assign(ping));
+            }
+            return dabc::cmd_postponed;
+         }
+
+         return dabc::Worker::ExecuteCommand(cmd);
+      }
+
+      bool ReplyCommand(dabc::Command cmd) override
+      {
+         if (cmd.GetResult() == dabc::cmd_true) fReplied++; else fFailed++;
+         if (fReplied + fFailed == fNumber)
+            fMain.Reply(fFailed == 0 ? dabc::cmd_true : dabc::cmd_false);
+         return true;
+      }
+};
+
+extern "C" void RunCommandChannelTest()
+{
+   // fan-out of many commands to remote node via command channel
+   // remote node should run with <control value="true"/> and port, specified with <User><CmdNode value="host:port"/></User>
+   // client itself also requires <control value="true"/>
+
+   std::string node = dabc::mgr()->cfg()->GetUserPar("CmdNode", "localhost:12345");
+   int number = dabc::mgr()->cfg()->GetUserParInt("CmdNumber", 1000);
+
+   dabc::ThreadRef thrd = dabc::mgr.CreateThread("CmdTestThread");
+
+   dabc::WorkerRef worker = new CmdChannelTestWorker("CmdChannelTest");
+   worker()->AssignToThread(thrd);
+
+   for (int loop = 0; loop < 6; loop++) {
+      // first loop establish connection
+      int cnt = (loop == 0) ? 1 : number;
+
+      dabc::Command cmd("SendPings");
+      cmd.SetStr("receiver", dabc::format("dabc://%s", node.c_str()));
+      cmd.SetInt("number", cnt);
+
+      dabc::TimeStamp tm = dabc::Now();
+      int res = worker.Execute(cmd, 30.);
+      double spent = tm.SpentTillNow();
+
+      DOUT0("Node %s commands %d res %d time %7.3f ms rate %7.1f k/s", node.c_str(), cnt, res, spent*1e3, spent > 0 ? cnt/spent*1e-3 : 0.);
+   }
+
+   worker.Destroy();
+   thrd.Destroy();
+}
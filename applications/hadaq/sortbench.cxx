@@ -0,0 +1,172 @@
+// Benchmark of hadaq subevents sorting
+// Synthetic TRB subevents are produced in buffers with trigger numbers shuffled
+// inside window. Subevents are sorted either by std::sort of all kept records
+// on each buffer (as done before by hadaq::SorterModule) or with hadaq::SubeventsQueue
+// and copied into output buffer in trigger order.
+//
+// Usage: hadaq-sortbench [num_subevents] [shuffle_window] [subevents_per_buffer] [ring_size]
+
+#include "hadaq/SorterModule.h"
+
+#include "dabc/timing.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+typedef hadaq::SubeventsQueue::Rec Rec;
+
+const uint32_t TrigRange = 0x1000000;
+
+static int Diff(uint32_t trig1, uint32_t trig2)
+{
+   int res = (int) (trig2) - trig1;
+   if (res > ((int) TrigRange)/2) return res - TrigRange;
+   if (res < ((int) TrigRange)/-2) return res + TrigRange;
+   return res;
+}
+
+struct SortComp {
+   bool operator() (const Rec &l, const Rec &r) const { return Diff(l.trig, r.trig) > 0; }
+};
+
+struct Output {
+   std::vector<char> mem;
+   unsigned pos;
+   uint32_t last;
+   unsigned gaps, errors;
+   uint64_t cnt;
+
+   Output() : mem(1 << 20), pos(0), last(0xffffffff), gaps(0), errors(0), cnt(0) {}
+
+   /** returns true if subevent must wait for next buffers */
+   bool Wait(const Rec &rec, unsigned nextbuf, bool flush)
+   {
+      if ((last == 0xffffffff) || (Diff(last, rec.trig) == 1)) return false;
+      return !flush && (rec.buf + 2 > nextbuf);
+   }
+
+   void Copy(const Rec &rec)
+   {
+      if (last != 0xffffffff) {
+         int diff = Diff(last, rec.trig);
+         if (diff < 1) errors++; else if (diff > 1) gaps++;
+      }
+      if (pos + rec.sz > mem.size()) pos = 0;
+      memcpy(mem.data() + pos, rec.subevnt, rec.sz);
+      pos += rec.sz;
+      last = rec.trig;
+      cnt++;
+   }
+};
+
+int main(int argc, char** argv)
+{
+   unsigned numsub = argc > 1 ? atoi(argv[1]) : 1000000;
+   unsigned window = argc > 2 ? atoi(argv[2]) : 64;
+   unsigned perbuf = argc > 3 ? atoi(argv[3]) : 500;
+   unsigned ringsize = argc > 4 ? atoi(argv[4]) : 1024;
+   if (window < 1) window = 1;
+   if (perbuf < 1) perbuf = 1;
+
+   // shuffle trigger numbers inside the window
+   std::vector<uint32_t> trigs(numsub);
+   for (unsigned n = 0; n < numsub; n++)
+      trigs[n] = (n + 0x1000) % TrigRange;
+   srand(1234);
+   for (unsigned n = 0; n < numsub; n += window) {
+      unsigned len = (numsub - n < window) ? numsub - n : window;
+      for (unsigned k = len - 1; k > 0; k--)
+         std::swap(trigs[n+k], trigs[n + rand() % (k+1)]);
+   }
+
+   // produce buffers with TRB3 subevents, scan them with hadaq::ReadIterator
+   unsigned numbufs = (numsub + perbuf - 1) / perbuf;
+   std::vector<std::vector<char> > mem(numbufs);
+   std::vector<std::vector<Rec> > recs(numbufs);
+   hadaq::ReadIterator iter;
+   iter.SetIndexing();
+
+   for (unsigned nbuf = 0; nbuf < numbufs; nbuf++) {
+      unsigned first = nbuf*perbuf, last = first + perbuf;
+      if (last > numsub) last = numsub;
+      mem[nbuf].resize((last - first) * (sizeof(hadaq::RawSubevent) + 32*4 + 8));
+      unsigned pos = 0;
+      for (unsigned n = first; n < last; n++) {
+         unsigned nwords = 4 + trigs[n] % 29;
+         hadaq::RawSubevent *sub = (hadaq::RawSubevent *) (mem[nbuf].data() + pos);
+         sub->SetSize(sizeof(hadaq::RawSubevent) + nwords*4);
+         sub->SetDecoding(0x00020001);
+         sub->SetId(0x8000 + nbuf % 4);
+         sub->SetTrigNr((trigs[n] << 8) | (trigs[n] & 0xff));
+         for (unsigned k = 0; k < nwords; k++)
+            *sub->GetDataPtr(k) = k + n;
+         pos += sub->GetPaddedSize();
+      }
+
+      dabc::Buffer buf = dabc::Buffer::CreateBuffer(mem[nbuf].data(), pos, false);
+      buf.SetTypeId(hadaq::mbt_HadaqSubevents);
+
+      iter.Reset(buf);
+      while (iter.NextSubeventsBlock())
+         while (iter.NextSubEvent()) {
+            const hadaq::SubeventInfo &info = iter.subevnt_info();
+            Rec rec;
+            rec.subevnt = info.subevnt;
+            rec.trig = (info.trignr >> 8) & (TrigRange-1);
+            rec.buf = nbuf;
+            rec.sz = info.GetPaddedSize();
+            recs[nbuf].push_back(rec);
+         }
+      iter.Close();
+   }
+
+   printf("Subevents %u in %u buffers, shuffle window %u, ring size %u\n", numsub, numbufs, window, ringsize);
+
+   for (int kind = 0; kind < 2; kind++) {
+      Output out;
+      dabc::TimeStamp tm;
+      tm.GetNow();
+
+      if (kind == 0) {
+         // sort of all kept records after every buffer, used records removed from the front
+         std::vector<Rec> subs;
+         subs.reserve(1024);
+         for (unsigned nbuf = 0; nbuf <= numbufs; nbuf++) {
+            bool flush = (nbuf == numbufs);
+            if (!flush) {
+               subs.insert(subs.end(), recs[nbuf].begin(), recs[nbuf].end());
+               std::sort(subs.begin(), subs.end(), SortComp());
+            }
+            unsigned cnt = 0;
+            while ((cnt < subs.size()) && !out.Wait(subs[cnt], nbuf+1, flush))
+               out.Copy(subs[cnt++]);
+            subs.erase(subs.begin(), subs.begin() + cnt);
+         }
+      } else {
+         // records pushed into the queue, only ready records are taken out
+         hadaq::SubeventsQueue queue(TrigRange, ringsize);
+         queue.reserve(1024);
+         for (unsigned nbuf = 0; nbuf <= numbufs; nbuf++) {
+            bool flush = (nbuf == numbufs);
+            if (!flush)
+               for (unsigned n = 0; n < recs[nbuf].size(); n++)
+                  queue.push(recs[nbuf][n]);
+            while (!queue.empty() && !out.Wait(queue.top(), nbuf+1, flush)) {
+               out.Copy(queue.top());
+               queue.pop();
+            }
+         }
+      }
+
+      double spent = tm.SpentTillNow();
+
+      printf("%s  time %7.3f s  rate %6.2f MSub/s  copied %lu gaps %u errors %u\n",
+             kind == 0 ? "std::sort" : "queue    ", spent, spent > 0 ? numsub*1e-6/spent : 0.,
+             (long unsigned) out.cnt, out.gaps, out.errors);
+   }
+
+   return 0;
+}
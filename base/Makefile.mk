@@ -20,6 +20,7 @@ BASE_SOCKET_O     = $(filter $(BLD_DIR)/$(DABC_BASEDIRS)/Socket%, $(BASE_O))
 BASE_CORE_O       = $(filter-out $(BASE_SOCKET_O), $(BASE_O))
 
 DABC_BASESUB_S    = $(DABC_BASEDIRS)/threads.$(SrcSuf) \
+                    $(DABC_BASEDIRS)/SmallObjects.$(SrcSuf) \
                     $(DABC_BASEDIRS)/timing.$(SrcSuf) \
                     $(DABC_BASEDIRS)/logging.$(SrcSuf) \
                     $(DABC_BASEDIRS)/string.$(SrcSuf) \
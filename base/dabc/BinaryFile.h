@@ -45,6 +45,15 @@ namespace dabc {
          virtual size_t fwrite(const void* ptr, size_t sz, size_t nmemb, Handle f)
            { return ((f==0) || (ptr==0)) ? 0 : ::fwrite(ptr, sz, nmemb, (FILE*) f); }
 
+         /** Write several memory pieces one after another, returns true when all data are written.
+          * Default implementation calls fwrite() for each piece */
+         virtual bool fwritev(const void* const* ptrs, const size_t* sizes, unsigned num, Handle f)
+         {
+            for (unsigned n = 0; n < num; n++)
+               if ((sizes[n] > 0) && (fwrite(ptrs[n], sizes[n], 1, f) != 1)) return false;
+            return true;
+         }
+
          virtual size_t fread(void* ptr, size_t sz, size_t nmemb, Handle f)
            { return ((f==0) || (ptr==0)) ? 0 : ::fread(ptr, sz, nmemb, (FILE*) f); }
 
@@ -73,6 +82,50 @@ namespace dabc {
 
    // ==============================================================================
 
+   /** \brief File interface, which uses POSIX descriptors instead of stdio
+    *
+    * \ingroup dabc_all_classes
+    *
+    * Multi-segment data written with single pwritev() call, avoiding copy into libc buffer.
+    * Optionally file opened with O_DIRECT - data with same alignment in memory as file position
+    * written directly, unaligned rest is collected in aligned staging buffer. File space can be
+    * preallocated with fallocate() in large portions */
+
+   class PosixFileInterface : public FileInterface {
+      protected:
+         bool     fDirect;      ///< use O_DIRECT for writing
+         uint64_t fPrealloc;    ///< size of preallocation portion, 0 - disabled
+
+      public:
+
+         enum { DirectAlign = 4096, StageSize = 0x400000 };
+
+         PosixFileInterface(bool direct = false, uint64_t prealloc = 0) :
+            FileInterface(),
+            fDirect(direct),
+            fPrealloc(prealloc)
+         {
+         }
+
+         virtual Handle fopen(const char* fname, const char* mode, const char* = nullptr);
+
+         virtual void fclose(Handle f);
+
+         virtual size_t fwrite(const void* ptr, size_t sz, size_t nmemb, Handle f);
+
+         virtual bool fwritev(const void* const* ptrs, const size_t* sizes, unsigned num, Handle f);
+
+         virtual size_t fread(void* ptr, size_t sz, size_t nmemb, Handle f);
+
+         virtual bool feof(Handle f);
+
+         virtual bool fflush(Handle f);
+
+         virtual bool fseek(Handle f, long int offset, bool relative = true);
+   };
+
+   // ==============================================================================
+
    /** \brief Base class for file writing/reading in DABC
     *
     * \ingroup dabc_all_classes
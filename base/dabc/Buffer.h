@@ -164,6 +164,9 @@ namespace dabc {
       /** Returns number of segment in buffer */
       unsigned NumSegments() const { return null() ? 0 : GetObject()->fNumSegments; }
 
+      /** Returns maximal number of segments, which can be stored in the buffer */
+      unsigned SegmentsCapacity() const { return null() ? 0 : GetObject()->fCapacity; }
+
       MemSegment* Segments() const { return null() ? 0 : GetObject()->fSegm; }
 
       /** Returns id of the segment, no any boundary checks */
@@ -249,6 +252,16 @@ namespace dabc {
        * \returns false if operation failed, otherwise true */
       bool Insert(BufferSize_t pos, Buffer& src, bool moverefs = true);
 
+      /** \brief Append reference on the part of other buffer without copying data.
+       *
+       * Segments, covered by len bytes starting from ptr position, are added to the segments list.
+       * Piece which continues last segment of the buffer in the same memory is merged with it.
+       * Works only with memory from the same pool, empty buffer (see \ref MakeEmpty) takes pool from source.
+       * \param[in] ptr       position in the source buffer
+       * \param[in] len       number of bytes to reference
+       * \returns false when memory belongs to other pool or segments list is full, buffer is not changed then */
+      bool AppendRef(const Pointer& ptr, BufferSize_t len);
+
       /** \brief Convert content of the buffer into std::string */
       std::string AsStdString();
 
@@ -314,6 +327,10 @@ namespace dabc {
       /** This static method create Buffer instance, which contains pointer on specified peace of memory
        * Therefore it can be used in standalone case */
       static Buffer CreateBuffer(const void* ptr, unsigned size, bool owner = false, bool makecopy = false) throw();
+
+      /** This static method create Buffer instance for external memory, which lifetime managed by owner object
+       * Owner will be referenced until last buffer with such memory is released */
+      static Buffer CreateBuffer(const void* ptr, unsigned size, const Reference& owner) throw();
    };
 
 };
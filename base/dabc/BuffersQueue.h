@@ -25,6 +25,7 @@
 #endif
 
 #include <vector>
+#include <atomic>
 
 namespace dabc {
 
@@ -105,6 +106,108 @@ namespace dabc {
 
    };
 
+// _________________________________________________________________________
+
+/** \brief Lock-free ring of buffers for single producer and single consumer
+ *
+ * \ingroup dabc_all_classes
+ *
+ *  Only one thread may call PushBuffer() and only one (other) thread may call PopBuffer().
+ *  Head and tail indexes are placed in different cache lines, each side keeps
+ *  cached copy of other index to avoid touching foreign cache line on every operation.
+ *  Size(), Full() and Empty() can be used from both sides, Item() and TotalBuffersSize()
+ *  only from consumer side.
+ */
+
+   class BuffersRing {
+
+      protected:
+         enum { CacheLine = 64 };
+
+         std::vector<dabc::Buffer> vect;   ///< capacity+1 slots, one always empty
+
+         char pad0[CacheLine];
+         std::atomic<unsigned> tail;       ///< next slot to write, changed by producer
+         unsigned cached_head;             ///< producer copy of head
+         char pad1[CacheLine];
+         std::atomic<unsigned> head;       ///< next slot to read, changed by consumer
+         unsigned cached_tail;             ///< consumer copy of tail
+         char pad2[CacheLine];
+
+         inline unsigned next(unsigned pos) const { return (pos + 1 == vect.size()) ? 0 : pos + 1; }
+
+      public:
+         BuffersRing(unsigned capacity) :
+            vect(capacity + 1),
+            tail(0),
+            cached_head(0),
+            head(0),
+            cached_tail(0)
+         {
+         }
+
+         virtual ~BuffersRing() { Cleanup(); }
+
+         /** Producer side. Index stored with full barrier, that consumer signaling state can be checked afterwards */
+         bool PushBuffer(Buffer& buf)
+         {
+            unsigned pos = tail.load(std::memory_order_relaxed), nxt = next(pos);
+            if (nxt == cached_head) {
+               cached_head = head.load(std::memory_order_acquire);
+               if (nxt == cached_head) return false;
+            }
+            vect[pos] << buf;
+            tail.store(nxt, std::memory_order_seq_cst);
+            return true;
+         }
+
+         /** Consumer side. Index stored with full barrier, that producer signaling state can be checked afterwards */
+         bool PopBuffer(Buffer& buf)
+         {
+            unsigned pos = head.load(std::memory_order_relaxed);
+            if (pos == cached_tail) {
+               cached_tail = tail.load(std::memory_order_acquire);
+               if (pos == cached_tail) return false;
+            }
+            buf << vect[pos];
+            head.store(next(pos), std::memory_order_seq_cst);
+            return true;
+         }
+
+         unsigned Size() const
+         {
+            unsigned t = tail.load(), h = head.load();
+            return (t >= h) ? t - h : t + vect.size() - h;
+         }
+
+         unsigned Capacity() const { return vect.size() - 1; }
+
+         bool Full() const { return Size() == Capacity(); }
+
+         bool Empty() const { return tail.load() == head.load(); }
+
+         /** Release all buffers, should be called when no producer or consumer active */
+         void Cleanup();
+
+         Buffer Item(unsigned n) const
+         {
+            unsigned pos = head.load(std::memory_order_relaxed) + n;
+            if (pos >= vect.size()) pos -= vect.size();
+            return vect[pos];
+         }
+
+         BufferSize_t TotalBuffersSize() const
+         {
+            BufferSize_t sum = 0;
+            unsigned pos = head.load(std::memory_order_relaxed), last = tail.load(std::memory_order_acquire);
+            while (pos != last) {
+               sum += vect[pos].GetTotalSize();
+               pos = next(pos);
+            }
+            return sum;
+         }
+   };
+
 }
 
 
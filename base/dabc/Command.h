@@ -74,7 +74,7 @@ namespace dabc {
             }
          };
 
-         std::list<CallerRec> fCallers;     ///< list of callers
+         std::list<CallerRec, SmallObjectsAllocator<CallerRec>> fCallers;     ///< list of callers
          TimeStamp            fTimeout;     ///< absolute time when timeout will be expired
          bool                 fCanceled;    ///< indicate if command was canceled ant not need to be executed further
 
@@ -72,6 +72,7 @@ namespace dabc {
          QueueRecsList     fList;
          EKind             fKind;
          uint32_t          fIdCounter;
+         unsigned          fKindCnt[kindPostponed+1]; ///< number of entries of each kind, avoids search when kind is not there
 
       public:
          /** Normal constructor */
@@ -37,6 +37,7 @@ namespace dabc {
    extern const char* xmlThreadAttr;
    extern const char* xmlUseacknAttr;
    extern const char* xmlOptionalAttr;
+   extern const char* xmlBatchAttr;
    extern const char* xmlPoolAttr;
    extern const char* xmlTimeoutAttr;
    extern const char* xmlAutoAttr;
@@ -75,6 +76,7 @@ namespace dabc {
    extern const char* xmlNormalMainThrd;
    extern const char* xmlAffinity;
    extern const char* xmlThreadsLayout;
+   extern const char* xmlSmallObjects;
    extern const char* xmlTaskset;
    extern const char* xmlLDPATH;
    extern const char* xmlUserLib;
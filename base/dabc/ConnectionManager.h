@@ -40,6 +40,8 @@ namespace dabc {
 
        void SetUseAcknDirectly(bool on) { SetAllowedField(xmlUseacknAttr); SetUseAckn(on); }
 
+       void SetBatchSizeDirectly(unsigned sz) { SetAllowedField(xmlBatchAttr); SetBatchSize(sz); }
+
        void SetConnTimeoutDirectly(double tm) { SetAllowedField(xmlTimeoutAttr); SetConnTimeout(tm); }
 
        std::string GetServerId() const { GET_PAR_FIELD(fServerId,"") }
@@ -217,6 +217,9 @@ namespace dabc {
       /** Use of acknowledge in protocol */
       bool GetUseAckn() const { return GetField(xmlUseacknAttr).AsBool(false); }
 
+      /** Maximal number of buffers, which can be combined in single send operation, 0 - no batching */
+      unsigned GetBatchSize() const { return GetField(xmlBatchAttr).AsUInt(0); }
+
       /** time required to establish connection, if expired connection will be switched to "failed" state */
       double GetConnTimeout() const { return GetField(xmlTimeoutAttr).AsDouble(10.); }
 
@@ -231,6 +234,8 @@ namespace dabc {
 
       void SetUseAckn(bool on = true) { SetField(xmlUseacknAttr, on); }
 
+      void SetBatchSize(unsigned sz) { SetField(xmlBatchAttr, sz); }
+
       void SetConnTimeout(double tm) { SetField(xmlTimeoutAttr, tm); }
 
       void SetConnThread(const std::string &name) { SetField(xmlThreadAttr, name); }
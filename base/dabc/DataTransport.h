@@ -47,6 +47,8 @@ namespace dabc {
    };
 
 
+   class OutputAsyncWriter;
+
    class InputTransport : public Transport {
 
       // enum EDataEvents { evCallBack = evntModuleLast };
@@ -169,9 +171,13 @@ namespace dabc {
          Buffer          fCurrentBuf;     //!< currently used buffer
          bool            fStopRequested;  //!< if true transport will be stopped when next suitable state is achieved
          double          fRetryPeriod;    //!< if retry option enabled, transport will try to reinit output
+         OutputAsyncWriter* fWriter;      //!< writer thread, used when several buffers should be written asynchronously
 
          void SetDataOutput(DataOutput* out, bool owner);
 
+         /** Process input buffer when output is written by separate thread */
+         bool ProcessAsyncRecv(unsigned port);
+
          void CloseOutput();
 
          /** Returns true if state consider to be suitable to stop transport */
@@ -34,6 +34,9 @@ namespace dabc {
     *
     * \ingroup dabc_all_classes
     *
+    * When modules run in different threads, buffers are transferred via lock-free
+    * \ref dabc::BuffersRing, mutex only used to deliver events to the modules.
+    * Otherwise \ref dabc::BuffersQueue is used, protected by object mutex when required.
     */
 
 
@@ -45,26 +48,27 @@ namespace dabc {
       protected:
 
          BuffersQueue fQueue;
+         BuffersRing* fRing;         ///< lock-free ring, used instead of fQueue between two threads
          bool fWithMutex;
 
          WorkerRef fOut;
          unsigned fOutId;
          int fOutSignKind;
-         unsigned fSignalOut;
+         std::atomic<unsigned> fSignalOut;
 
          WorkerRef fInp;
          unsigned fInpId;
          int fInpSignKind;
-         unsigned fSignalInp;
+         std::atomic<unsigned> fSignalInp;
 
-         unsigned fConnected;
+         std::atomic<unsigned> fConnected;
 
          bool fBlockWhenUnconnected; ///< should queue block when input port not connected, default false
          bool fBlockWhenConnected;   ///< should queue block when input port connected, default true
 
          enum { MaskInp = 0x1, MaskOut = 0x2, MaskConn = 0x3 };
 
-         LocalTransport(unsigned capacity, bool withmutex);
+         LocalTransport(unsigned capacity, bool withmutex, bool lockfree = false);
 
          virtual ~LocalTransport();
 
@@ -76,6 +80,15 @@ namespace dabc {
 
          void CleanupQueue();
 
+         bool SendLockFree(Buffer& buf);
+
+         bool RecvLockFree(Buffer& buf);
+
+         void ConfirmLockFree(bool fromoutputport);
+
+         /** Change signal state from 3 to specified value, returns true if event should be produced */
+         static bool SwitchSignal(std::atomic<unsigned> &sig, int kind);
+
          bool IsConnected() const
          {
             LockGuard lock(QueueMutex());
@@ -85,6 +98,11 @@ namespace dabc {
          /** How many buffers can be add to the queue */
          unsigned NumCanSend() const
          {
+            if (fRing) {
+               unsigned sz = fRing->Size();
+               if (sz < fRing->Capacity()) return fRing->Capacity() - sz;
+               return (fConnected == MaskConn) || fBlockWhenUnconnected ? 0 : 1;
+            }
             LockGuard lock(QueueMutex());
             if (!fQueue.Full()) return fQueue.Capacity() - fQueue.Size();
             // when queue is full and transport in non-blocking state, one buffer can be add (oldest will be lost)
@@ -98,7 +116,7 @@ namespace dabc {
 
          bool Send(Buffer& buf);
 
-         bool CanRecv() const { LockGuard lock(QueueMutex()); return !fQueue.Empty(); }
+         bool CanRecv() const { if (fRing) return !fRing->Empty(); LockGuard lock(QueueMutex()); return !fQueue.Empty(); }
 
          bool Recv(Buffer& buf);
 
@@ -109,15 +127,16 @@ namespace dabc {
          inline void EnableMutex() { fWithMutex = true; }
 
          // no need for mutex - capacity is not changed until destructor call
-         unsigned Capacity() const { LockGuard lock(QueueMutex()); return fQueue.Capacity(); }
+         unsigned Capacity() const { if (fRing) return fRing->Capacity(); LockGuard lock(QueueMutex()); return fQueue.Capacity(); }
 
-         unsigned Size() const { LockGuard lock(QueueMutex()); return fQueue.Size(); }
+         unsigned Size() const { if (fRing) return fRing->Size(); LockGuard lock(QueueMutex()); return fQueue.Size(); }
 
-         BufferSize_t TotalBuffersSize() const { LockGuard lock(QueueMutex()); return fQueue.TotalBuffersSize(); }
+         // with lock-free ring only input port is allowed to access queue items
+         BufferSize_t TotalBuffersSize() const { if (fRing) return fRing->TotalBuffersSize(); LockGuard lock(QueueMutex()); return fQueue.TotalBuffersSize(); }
 
-         unsigned Full() const { LockGuard lock(QueueMutex()); return fQueue.Full(); }
+         unsigned Full() const { if (fRing) return fRing->Full(); LockGuard lock(QueueMutex()); return fQueue.Full(); }
 
-         Buffer Item(unsigned indx) const { LockGuard lock(QueueMutex()); return fQueue.Item(indx); }
+         Buffer Item(unsigned indx) const { if (fRing) return fRing->Item(indx); LockGuard lock(QueueMutex()); return fQueue.Item(indx); }
 
          void Disconnect(bool isinp, bool witherr = false);
 
@@ -0,0 +1,82 @@
+// $Id$
+
+/************************************************************
+ * The Data Acquisition Backbone Core (DABC)                *
+ ************************************************************
+ * Copyright (C) 2009 -                                     *
+ * GSI Helmholtzzentrum fuer Schwerionenforschung GmbH      *
+ * Planckstr. 1, 64291 Darmstadt, Germany                   *
+ * Contact:  http://dabc.gsi.de                             *
+ ************************************************************
+ * This software can be used under the GPL license          *
+ * agreements as stated in LICENSE.txt file                 *
+ * which is part of the distribution.                       *
+ ************************************************************/
+
+#ifndef DABC_MappedFile
+#define DABC_MappedFile
+
+#ifndef DABC_Buffer
+#include "dabc/Buffer.h"
+#endif
+
+namespace dabc {
+
+   /** \brief Read-only access to a file via memory-mapped windows
+    *
+    * \ingroup dabc_all_classes
+    *
+    * File is mapped piece by piece into windows of configured size.
+    * Buffers, produced with \ref MappedFile::Take method, point directly into the mapped memory
+    * and keep reference on the window object - mapping is released when last such buffer disappears.
+    * Data portion, which does not fit into rest of current window, is mapped again in the next
+    * window, therefore data block (event) never split between two windows.
+    * Next window is announced to the kernel in advance to let readahead work in background.
+    */
+
+   class MappedFile {
+      protected:
+         int        fFd;            ///< file descriptor
+         uint64_t   fFileSize;      ///< total file size
+         uint64_t   fWindowSize;    ///< configured window size
+         Reference  fWindow;        ///< object, which owns current mapping
+         char*      fWindowPtr;     ///< begin of current mapping
+         uint64_t   fWindowPos;     ///< file offset of current mapping
+         uint64_t   fWindowLen;     ///< length of current mapping
+         uint64_t   fPos;           ///< current read position in the file
+         unsigned   fNumWindows;    ///< number of created windows
+
+         bool MapWindow(uint64_t len);
+
+      public:
+         MappedFile();
+         ~MappedFile() { Close(); }
+
+         bool Open(const char* fname, uint64_t window);
+         void Close();
+
+         bool isOpened() const { return fFd >= 0; }
+         bool eof() const { return fPos >= fFileSize; }
+
+         uint64_t FileSize() const { return fFileSize; }
+         uint64_t Position() const { return fPos; }
+         unsigned NumWindows() const { return fNumWindows; }
+
+         /** Returns number of bytes after current position which are already mapped */
+         uint64_t Mapped() const { return fWindowLen + fWindowPos - fPos; }
+
+         /** Ensure that len bytes starting from current position are mapped
+          * Returns pointer on the data or nullptr when not possible */
+         const char* Map(uint64_t len);
+
+         /** Shift current position, data should be mapped before */
+         void Skip(uint64_t len) { fPos += len; }
+
+         /** Produce buffer which points to len bytes from current position, position is shifted
+          * Data should be mapped before with \ref Map method */
+         Buffer Take(uint64_t len);
+   };
+
+}
+
+#endif
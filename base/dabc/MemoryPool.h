@@ -24,6 +24,7 @@ namespace dabc {
 
    class Mutex;
    class MemoryBlock;
+   struct MemoryMagazine;
    class MemoryPoolRef;
 
    /** \brief Memory pool
@@ -56,6 +57,20 @@ namespace dabc {
 
          unsigned                  fAlignment;      ///< alignment boundary for memory
 
+         unsigned                  fCacheSize;      ///< size of per-thread cache of free buffers, 0 - disabled
+
+         std::atomic<MemoryBlock*> fCacheMem;       ///< memory block, which can be accessed via per-thread caches without pool mutex
+
+         uint64_t                  fCacheReclaims;  ///< number of times when buffers were collected from all threads caches
+
+         uint64_t                  fHugePageSize;   ///< requested huge page size, 0 - normal allocation
+
+         int                       fNumaNode;       ///< NUMA node for memory, -1 - no binding, -2 - node of allocating thread
+
+         std::vector<BufferSize_t> fClassSizes;     ///< buffer sizes of additional size classes
+
+         std::vector<unsigned>     fClassNumbers;   ///< number of buffers in additional size classes
+
          std::vector<RequesterReq> fReqests;        ///< configuration for each output
 
          Queue<unsigned, true>    fPending;    ///< queue with requester indexes which are waiting release of the memory
@@ -81,6 +96,15 @@ namespace dabc {
          /** Central method, which reserves memory from pool and fill structures of buffer */
          Buffer _TakeBuffer(BufferSize_t size, bool except, bool reserve_memory = true);
 
+         /** Take single buffer from cache of current thread, returns empty buffer when not possible */
+         Buffer TakeCachedBuffer(BufferSize_t size);
+
+         /** Return free buffer into cache of current thread, flush part of the cache when it is full */
+         void ReleaseCachedBuffer(MemoryBlock* mem, unsigned id);
+
+         /** Move all buffers from threads caches back to pool, used when pool runs out of memory */
+         bool ReclaimThreadCaches();
+
          /** Method to allocate memory for the pool, mutex should be locked */
          bool _Allocate(BufferSize_t bufsize = 0, unsigned number = 0) throw();
 
@@ -119,6 +143,8 @@ namespace dabc {
 
          bool RecheckRequests(bool from_recv = false);
 
+         virtual void BuildFieldsMap(RecordFieldsMap* cont);
+
       public:
 
          MemoryPool(const std::string &name, bool withmanager = false);
@@ -136,6 +162,20 @@ namespace dabc {
          /** Set alignment of allocated memory */
          bool SetAlignment(unsigned align);
 
+         /** Set size of per-thread cache of free buffers.
+          * When non-zero, single buffers taken and released without locking of pool mutex */
+         bool SetThreadCache(unsigned size);
+
+         /** Configure placement of pool memory.
+          * \param hugepage - huge page size (2M or 1G), 0 - standard allocation
+          * \param numanode - NUMA node for memory, -1 - no binding, -2 - node of calling thread
+          * If huge pages cannot be provided by system, transparent huge pages are used */
+         bool SetMemoryPlacement(uint64_t hugepage, int numanode);
+
+         /** Add size class - buffers of other size, allocated together with main buffers.
+          * TakeBuffer() uses smallest class, which can provide requested size */
+         bool AddSizeClass(BufferSize_t bufsize, unsigned number);
+
          /** Allocates memory for the memory pool and creates references.
           * Only can be called for empty memory pool.
           * If no values are specified, requested values, configured by modules are used.
@@ -210,8 +210,14 @@ namespace dabc {
 
 
          // TODO: move to respective module classes
-         bool CanSendToAllOutputs(bool exclude_disconnected = true) const;
-         void SendToAllOutputs(Buffer& buf);
+         bool CanSendToAllOutputs(bool exclude_disconnected = true) const
+           { return CanSendToOutputs(0, NumOutputs(), exclude_disconnected); }
+         void SendToAllOutputs(Buffer& buf) { SendToOutputs(0, NumOutputs(), buf); }
+
+         /** Same as \ref CanSendToAllOutputs, but only for num outputs starting from first */
+         bool CanSendToOutputs(unsigned first, unsigned num, bool exclude_disconnected = true) const;
+         /** Same as \ref SendToAllOutputs, but only for num outputs starting from first */
+         void SendToOutputs(unsigned first, unsigned num, Buffer& buf);
 
 
          void ProduceInputEvent(unsigned indx = 0, unsigned cnt = 1);
@@ -71,12 +71,22 @@ namespace dabc {
             uint32_t typid;
             uint32_t size;
          };
+
+         /** Entry of batch table, send after header with netot_Batch kind.
+          * In such header typid is number of entries and size is table size in bytes.
+          * Data of all entries follows the table, small buffers are taken from inline data */
+         struct NetworkBatchEntry {
+            uint32_t kind;
+            uint32_t typid;
+            uint32_t size;
+         };
       #pragma pack()
 
          enum ENetworkOperTypes {
             netot_Send     = 0x001U,
             netot_Recv     = 0x002U,
-            netot_HdrSend  = 0x004U // use to send only network header without any additional data
+            netot_HdrSend  = 0x004U, // use to send only network header without any additional data
+            netot_Batch    = 0x008U  // header of several records, combined in one send operation
          };
 
       protected:
@@ -87,6 +97,7 @@ namespace dabc {
          uint32_t      fTransportId;
 
          bool          fUseAckn;
+         unsigned      fBatchSize;             // maximal number of records, combined in one send operation
          unsigned      fInputQueueCapacity;    // capacity of input queue
          unsigned      fOutputQueueCapacity;   // capacity of output queue
 
@@ -133,11 +144,16 @@ namespace dabc {
          virtual const char* ClassName() const { return "NetworkTransport"; }
 
          NetworkTransport(dabc::Command cmd, const PortRef& inpport, const PortRef& outport,
-                          bool useackn, WorkerAddon* addon);
+                          bool useackn, WorkerAddon* addon, unsigned batchsize = 0);
          virtual ~NetworkTransport();
 
          unsigned GetFullHeaderSize() const { return fFullHeaderSize; }
 
+         unsigned GetInlineDataSize() const { return fInlineDataSize; }
+
+         /** \brief Maximal number of records, which can be send together, 0 or 1 - no batching */
+         unsigned GetBatchSize() const { return fBatchSize; }
+
          /** \brief Provides name of memory pool, used by transport
           *
           * We made method public to use in some other places -
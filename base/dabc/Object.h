@@ -16,6 +16,8 @@
 #ifndef DABC_Object
 #define DABC_Object
 
+#include <atomic>
+
 #ifndef DABC_defines
 #include "dabc/defines.h"
 #endif
@@ -60,6 +62,10 @@ namespace dabc {
    extern const char* xmlNumBuffers;
    extern const char* xmlNumSegments;
    extern const char* xmlAlignment;
+   extern const char* xmlThreadCache;
+   extern const char* xmlHugePages;
+   extern const char* xmlNumaNode;
+   extern const char* xmlSizeClasses;
    extern const char* xmlShowInfo;
 
    extern const char* xmlNumInputs;
@@ -145,6 +151,9 @@ namespace dabc {
          /** \brief Decrements reference counter, return true if object must be destroyed */
          bool DecReference(bool ask_to_destroy, bool do_decrement = true, bool from_thread = false);
 
+         /** \brief Recalculates fObjectFastDec, must be called with locked mutex */
+         void _UpdateFastDec();
+
          /** \brief Returns object state value */
          inline EState GetState() const { return (EState) (fObjectFlags & flStateMask); }
 
@@ -176,7 +185,8 @@ namespace dabc {
          Reference          fObjectParent;   ///< reference on the parent object
          std::string        fObjectName;     ///< object name
          Mutex*             fObjectMutex;    ///< mutex protects all private property of the object
-         int                fObjectRefCnt;   ///< accounts how many references existing on the object, __thread safe__
+         std::atomic<int>   fObjectRefCnt;   ///< accounts how many references existing on the object, __thread safe__
+         std::atomic<bool>  fObjectFastDec;  ///< true when DecReference may skip mutex while counter stays above 1
          ReferencesVector*  fObjectChilds;   ///< list of the child objects
          int                fObjectBlock;    ///< counter for blocking calls, as long as non-zero, non of child can be removed
 
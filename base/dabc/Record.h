@@ -24,6 +24,10 @@
 #include "dabc/Buffer.h"
 #endif
 
+#ifndef DABC_SmallObjects
+#include "dabc/SmallObjects.h"
+#endif
+
 #include <vector>
 #include <map>
 
@@ -94,6 +98,18 @@ namespace dabc {
 
          /** \brief Restore string from the stream */
          bool read_str(std::string& str);
+
+         /** \brief Store unsigned integer with variable length, 7 bits in each byte */
+         bool write_varint(uint64_t v);
+
+         /** \brief Restore unsigned integer with variable length */
+         bool read_varint(uint64_t& v);
+
+         /** \brief Store string as varint length and characters, without padding */
+         bool write_vstr(const char* str, uint64_t len) { return write_varint(len) && write(str, len); }
+
+         /** \brief Restore string, stored with write_vstr */
+         bool read_vstr(std::string& str);
    };
 
    // ===================================================================================
@@ -163,6 +179,14 @@ namespace dabc {
 
    // ===================================================================================
 
+   /** \brief Versions of binary record encoding, used in Record::SaveToBuffer and Record::ReadFromBuffer */
+   enum EStoreVersion {
+      storeversion_Aligned = 0,   ///< original encoding, all entries 8-byte aligned with explicit sizes
+      storeversion_Compact = 1    ///< compact encoding, variable-length integers without padding
+   };
+
+   // ===================================================================================
+
 
    enum HStoreMask {
       storemask_Compact =    0x03,   // 0..3 level of compactness
@@ -365,6 +389,9 @@ namespace dabc {
          uint64_t StoreSize();
          bool Stream(iostream& s);
 
+         /** \brief Stream field in compact encoding, see dabc::storeversion_Compact */
+         bool StreamCompact(iostream& s);
+
          static bool NeedJsonReformat(const std::string &str);
          static std::string JsonReformat(const std::string &str);
 
@@ -373,32 +400,91 @@ namespace dabc {
 
    class RecordFieldsMap {
       protected:
-         typedef std::map<std::string, dabc::RecordField> FieldsMap;
+         /** \brief Field together with its interned name */
+         struct FieldEntry {
+            const std::string *name;   ///< name from global atoms table, shared by all maps
+            uint32_t           hash;   ///< hash value of the name
+            RecordField        field;  ///< field itself
+
+            FieldEntry(const std::string *_name, uint32_t _hash) : name(_name), hash(_hash), field() {}
+
+            static void *operator new(size_t sz) { return SmallObjects::Allocate(sz); }
+            static void operator delete(void *ptr, size_t sz) { SmallObjects::Release(ptr, sz); }
+         };
+
+         typedef std::vector<FieldEntry*, SmallObjectsAllocator<FieldEntry*>> FieldsVector;
+
+         /** \brief Slot of open-addressing index */
+         struct IndexSlot {
+            uint32_t hash;             ///< hash value of the name
+            int32_t  pos;              ///< position in fFields, -1 for empty slot
+         };
+
+         enum { LinearSearchLimit = 8 };        ///< maps with less fields searched without index
 
-         FieldsMap fMap;
+         FieldsVector             fFields;      ///< all fields, order is not defined
+         std::vector<IndexSlot>   fIndex;       ///< hash index with linear probing, size is power of 2, empty for small maps
+         mutable FieldsVector     fSorted;      ///< fields sorted by name, used for I/O
+         mutable bool             fSortedValid; ///< true when fSorted corresponds to fFields
 
          bool   fChanged;               ///< true when field was removed
 
-         void clear() { fMap.clear(); }
+         void clear();
 
          static bool match_prefix(const std::string &name, const std::string &prefix);
 
+         /** \brief Hash function for field names */
+         static uint32_t name_hash(const std::string &name);
+
+         /** \brief Returns unique instance of the name from global atoms table */
+         static const std::string *intern(const std::string &name, uint32_t hash);
+
+         /** \brief Returns position of field in fFields or -1 */
+         int find(const std::string &name, uint32_t hash) const;
+
+         /** \brief Returns index slot, which points on specified position */
+         unsigned find_slot(uint32_t hash, int pos) const;
+
+         /** \brief Create new field, name should not exist */
+         FieldEntry *insert(const std::string &name, uint32_t hash);
+
+         /** \brief Remove field at specified position */
+         void remove_at(int pos);
+
+         /** \brief Rebuild index with new size */
+         void rehash(unsigned size);
+
+         /** \brief Returns fields sorted by name */
+         const FieldsVector &sorted() const;
+
+         RecordFieldsMap(const RecordFieldsMap&) = delete;
+         RecordFieldsMap& operator=(const RecordFieldsMap&) = delete;
+
       public:
 
          RecordFieldsMap();
          virtual ~RecordFieldsMap();
 
+         static void *operator new(size_t sz) { return SmallObjects::Allocate(sz); }
+         static void operator delete(void *ptr, size_t sz) { SmallObjects::Release(ptr, sz); }
+
          uint64_t StoreSize(const std::string &nameprefix = "");
          bool Stream(iostream& s, const std::string &nameprefix = "");
 
+         /** \brief Stream all fields in compact encoding, see dabc::storeversion_Compact */
+         bool StreamCompact(iostream& s);
+
          bool HasField(const std::string &name) const;
          bool RemoveField(const std::string &name);
 
-         unsigned NumFields() const { return fMap.size(); }
+         unsigned NumFields() const { return fFields.size(); }
          std::string FieldName(unsigned n) const;
 
-         /** \brief Direct access to the fields */
-         RecordField& Field(const std::string &name) { return fMap[name]; }
+         /** \brief Direct access to the fields, field created when not exists */
+         RecordField& Field(const std::string &name);
+
+         /** \brief Returns pointer on the field or nullptr when field not exists */
+         const RecordField *FindField(const std::string &name) const;
 
          /** Save all field in json format */
          bool SaveTo(HStore& res);
@@ -470,7 +556,7 @@ namespace dabc {
             { return Fields().FieldName(cnt); }
 
          virtual RecordField GetField(const std::string &name) const
-            { return Fields().Field(name); }
+            { const RecordField *fld = Fields().FindField(name); return fld ? *fld : RecordField(); }
 
          virtual bool SetField(const std::string &name, const RecordField& v)
             { return Fields().Field(name).SetValue(v); }
@@ -481,6 +567,10 @@ namespace dabc {
 
          virtual ~RecordContainer();
 
+         /** Containers (commands first of all) allocated from per-thread free lists */
+         static void *operator new(size_t sz) { return SmallObjects::Allocate(sz); }
+         static void operator delete(void *ptr, size_t sz) { SmallObjects::Release(ptr, sz); }
+
          virtual const char* ClassName() const { return "Record"; }
 
          virtual void Print(int lvl = 0);
@@ -542,9 +632,14 @@ namespace dabc {
 
       bool Stream(iostream &s);
 
-      dabc::Buffer SaveToBuffer();
+      /** \brief Stream record in compact encoding, starts with version byte */
+      bool StreamCompact(iostream &s);
+
+      /** \brief Store record in binary form, see dabc::EStoreVersion for possible versions */
+      dabc::Buffer SaveToBuffer(unsigned version = storeversion_Aligned);
 
-      bool ReadFromBuffer(const dabc::Buffer &buf);
+      /** \brief Restore record from binary data, version should be the same as used in SaveToBuffer */
+      bool ReadFromBuffer(const dabc::Buffer &buf, unsigned version = storeversion_Aligned);
 
       virtual void CreateRecord(const std::string &name);
 
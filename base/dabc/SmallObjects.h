@@ -0,0 +1,79 @@
+// $Id$
+
+/************************************************************
+ * The Data Acquisition Backbone Core (DABC)                *
+ ************************************************************
+ * Copyright (C) 2009 -                                     *
+ * GSI Helmholtzzentrum fuer Schwerionenforschung GmbH      *
+ * Planckstr. 1, 64291 Darmstadt, Germany                   *
+ * Contact:  http://dabc.gsi.de                             *
+ ************************************************************
+ * This software can be used under the GPL license          *
+ * agreements as stated in LICENSE.txt file                 *
+ * which is part of the distribution.                       *
+ ************************************************************/
+
+#ifndef DABC_SmallObjects
+#define DABC_SmallObjects
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dabc {
+
+   /** \brief Per-thread free lists for small short-living objects
+    *
+    * \ingroup dabc_all_classes
+    *
+    * Blocks up to \ref SmallObjects::MaxSize bytes are grouped in size classes of 16 bytes.
+    * Released block is kept in free list of current thread and reused by next allocation of
+    * same size class in that thread, which avoids malloc/free for commands and record fields.
+    * Block can be released in other thread than it was allocated - it just goes to other list.
+    * Number of blocks kept per size class is limited, extra blocks are returned to the heap.
+    * Limit configured with "smallobjects" parameter in `<Run>` section, 0 disables free lists.
+    */
+
+   class SmallObjects {
+      public:
+         enum { ClassSize = 16, NumClasses = 16, MaxSize = ClassSize*NumClasses };
+
+         struct Statistic {
+            uint64_t allocated{0};   ///< blocks taken from the heap
+            uint64_t reused{0};      ///< blocks taken from the free lists
+            uint64_t released{0};    ///< blocks returned to the free lists
+            uint64_t freed{0};       ///< blocks returned to the heap
+         };
+
+         static void *Allocate(size_t sz);
+         static void Release(void *ptr, size_t sz);
+
+         /** Set maximal number of blocks, kept by each thread in each size class */
+         static void SetMaxKeep(unsigned num);
+         static unsigned GetMaxKeep();
+
+         /** Sum of counters from all threads */
+         static Statistic GetStatistic();
+   };
+
+   // ===========================================================================
+
+   /** \brief Allocator for STL containers, which uses \ref SmallObjects free lists */
+
+   template<class T>
+   class SmallObjectsAllocator {
+      public:
+         typedef T value_type;
+
+         SmallObjectsAllocator() {}
+         template<class U> SmallObjectsAllocator(const SmallObjectsAllocator<U> &) {}
+
+         T *allocate(size_t n) { return (T *) SmallObjects::Allocate(n*sizeof(T)); }
+         void deallocate(T *p, size_t n) { SmallObjects::Release(p, n*sizeof(T)); }
+
+         template<class U> bool operator==(const SmallObjectsAllocator<U> &) const { return true; }
+         template<class U> bool operator!=(const SmallObjectsAllocator<U> &) const { return false; }
+   };
+
+}
+
+#endif
@@ -20,6 +20,10 @@
 #include "dabc/SocketThread.h"
 #endif
 
+#include <sys/uio.h>
+
+#include <vector>
+
 namespace dabc {
 
 
@@ -64,7 +68,12 @@ namespace dabc {
          };
 
          enum {
-            headerDabc = 123707321
+            MaxSendBatch = 64             ///< maximal number of commands, sent with single operation
+         };
+
+         enum {
+            headerDabc = 123707321,        ///< packet with command in dabc::storeversion_Aligned encoding
+            headerDabcCompact = 123707322  ///< packet with command in dabc::storeversion_Compact encoding
          };
 
          enum ECmdDataKindNew {
@@ -82,13 +91,6 @@ namespace dabc {
             stFailure      ///< failure is detected and connection will be close
          };
 
-         enum ERecvState {
-            recvInit,     // receiver  ready to accept new command
-            recvHeader,   // command is assigned and executing
-            recvDevConnect, // special case of socket device connect via command channel
-            recvData      // command is sends back, one need to release command only when it is replied
-         };
-
          std::string        fRemoteHostName;    ///<  host name and port number
          double             fReconnectPeriod;   ///<  interval how often reconnect will be tried
 
@@ -96,19 +98,27 @@ namespace dabc {
 
          EState             fState;             ///< current state of the worker
 
-         SocketCmdPacket    fSendHdr;           ///< header for send command
-         dabc::Buffer       fSendBuf;           ///< content of transported command
-         dabc::Buffer       fSendRawData;       ///< raw data, which should be send with command
+         /** \brief Command prepared for sending */
+         struct SendRec {
+            SocketCmdPacket hdr;                ///< header for send command
+            dabc::Buffer    buf;                ///< content of transported command
+            dabc::Buffer    raw;                ///< raw data, which should be send with command
+         };
+
+         std::vector<SendRec> fSendRecs;        ///< commands in current send operation
+         unsigned           fSendRecsNum;       ///< number of used entries in fSendRecs
+         std::vector<struct iovec> fSendIOV;    ///< gather list for send operation
          bool               fSendingActive;     ///< indicate if currently send active
-         SocketCmdPacket    fRecvHdr;           ///< buffer for receiving header
-         char*              fRecvBuf;           ///< raw buffer for receiving command
+         bool               fSendActivated;     ///< activate event was fired to send queued commands
+         unsigned           fSendVersion;       ///< encoding of sent commands, negotiated with remote side
+         SocketCmdPacket    fRecvHdr;           ///< header of currently processed packet
+         char*              fRecvBuf;           ///< raw buffer for receiving packets, can contain several packets at once
          unsigned           fRecvBufSize;       ///< currently allocated size of recv buffer
+         unsigned           fRecvFill;          ///< number of bytes received in recv buffer
 
          CommandsQueue      fSendQueue;         ///< queue to keep commands which should be send
          CommandsQueue      fWaitQueue;         ///< commands which should be replied from remote
 
-         ERecvState         fRecvState;         ///< state that happens with receiver (server)
-
          // these are fields, used to manage information about remote node
          bool               fRemoteObserver;   ///< if true, channel automatically used to update information from remote
          std::string        fRemoteName;       ///< name of connection, appeared in the browser
@@ -132,16 +142,23 @@ namespace dabc {
          bool EnsureRecvBuffer(unsigned strsize);
 
          /** \brief Method called, when complete packet (header + raw data) is received */
-         void ProcessRecvPacket();
+         void ProcessRecvPacket(const char* data);
 
-         /** \brief Submit command to send queue, if queue is empty start sending immediately */
+         /** \brief Process all complete packets in the recv buffer */
+         void ProcessRecvData();
+
+         /** \brief Start receiving of next portion of data, many packets can be read at once */
+         void StartRecvData();
+
+         /** \brief Submit command to send queue, sending is started with activate event.
+          * Therefore all commands submitted until event is processed are sent together */
          void AddCommand(dabc::Command cmd, bool asreply = false);
 
-         /** \brief Send submitted commands to remote */
+         /** \brief Send submitted commands to remote, several commands combined in one send operation */
          void SendSubmittedCommands();
 
-         /** Send next command to the remote */
-         void SendCommand(dabc::Command cmd, bool asreply = false);
+         /** \brief Encode command and add it to the next send operation */
+         void PrepareCommand(dabc::Command cmd, bool asreply = false);
 
          /** \brief Called when connection must be closed due to the error */
          void CloseClient(bool iserr = false, const char* msg = 0);
@@ -151,6 +168,9 @@ namespace dabc {
 
          bool ExecuteCommandByItself(Command cmd);
 
+         /** \brief Request remote side to accept compact commands encoding */
+         void RequestCompactEncoding();
+
       public:
          SocketCommandClient(Reference parent, const std::string &name,
                              SocketAddon* addon, bool debug_mode = false,
@@ -44,6 +44,7 @@ namespace dabc {
          int                    fBindPort;   // selected port number
          std::string            fCmdChannelId; // server id of command channel, which will redirect sockets
          bool                   fDebugMode;   // debug mode
+         unsigned               fZeroCopy;    // minimal buffer size for zero-copy send, 0 - disabled
 
          virtual double ProcessTimeout(double last_diff);
 
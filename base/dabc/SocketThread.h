@@ -24,9 +24,15 @@
 #include "dabc/Worker.h"
 #endif
 
+#ifndef DABC_Buffer
+#include "dabc/Buffer.h"
+#endif
+
 #include <netdb.h>
+#include <deque>
 
 struct pollfd;
+struct epoll_event;
 
 // #define SOCKET_PROFILING
 
@@ -58,19 +64,48 @@ namespace dabc {
          int           fSocket;                 ///< socket handle
          bool          fDoingInput;             ///< true if input data are expected
          bool          fDoingOutput;            ///< true if data need to be send
+         bool          fDoingErrQueue;          ///< true if notifications from socket error queue are expected
          int           fIOPriority;             ///< priority of socket I/O events, default 1
          bool          fDeliverEventsToWorker;  ///< if true, completion events will be delivered to the worker
          bool          fDeleteWorkerOnClose;    ///< if true, worker will be deleted when socket closed or socket in error
+         SocketThread* fEpollThrd;              ///< thread with epoll backend, which should be informed about interest changes
+         unsigned      fEpollIndx;              ///< worker index in the epoll thread
 
          virtual void ProcessEvent(const EventId&);
 
+         /** \brief Inform thread with epoll backend that socket interest was changed */
+         void InterestChanged();
+
+         /** \brief Indicates that socket was read (or written) until operation would block.
+          * In edge-triggered epoll mode it allows to enable input/output again without system call */
+         void SocketWouldBlock(bool input);
+
          /** \brief Call method to indicate that object wants to read data from the socket.
           * When it will be possible, worker get evntSocketRead event */
-         inline void SetDoingInput(bool on = true) { fDoingInput = on; }
+         inline void SetDoingInput(bool on = true)
+         {
+            if (fDoingInput == on) return;
+            fDoingInput = on;
+            if (fEpollThrd) InterestChanged();
+         }
 
          /** \brief Call method to indicate that worker wants to write data to the socket.
           * When it will be possible, worker get evntSocketWrite event */
-         inline void SetDoingOutput(bool on = true) { fDoingOutput = on; }
+         inline void SetDoingOutput(bool on = true)
+         {
+            if (fDoingOutput == on) return;
+            fDoingOutput = on;
+            if (fEpollThrd) InterestChanged();
+         }
+
+         /** \brief Call method to indicate that worker waits for messages in socket error queue.
+          * \details Used for completions of zero-copy send, worker get evntSocketErrQueue event */
+         inline void SetDoingErrQueue(bool on = true)
+         {
+            if (fDoingErrQueue == on) return;
+            fDoingErrQueue = on;
+            if (fEpollThrd) InterestChanged();
+         }
 
          /** Generic error handler. Also invoked when socket is closed (msg==0) */
          virtual void OnSocketError(int msg, const std::string &info);
@@ -91,6 +126,7 @@ namespace dabc {
             evntSocketWrite,
             evntSocketError,
             evntSocketStartConnect,
+            evntSocketErrQueue,    ///< message in socket error queue, used for zero-copy send completions
             evntSocketLast,        ///< from this event number one can add more socket system events
             evntSocketRecvInfo  = Worker::evntFirstSystem,   ///< event delivered to worker when read is completed
             evntSocketSendInfo,                     ///< event delivered to worker when write is completed
@@ -110,6 +146,7 @@ namespace dabc {
 
          inline bool IsDoingInput() const { return fDoingInput; }
          inline bool IsDoingOutput() const { return fDoingOutput; }
+         inline bool IsDoingErrQueue() const { return fDoingErrQueue; }
 
          void CloseSocket();
          void SetSocket(int fd);
@@ -163,6 +200,21 @@ namespace dabc {
          unsigned      fRecvIOVNumber;  ///< number of elements in current recv operation
          struct sockaddr_in fRecvAddr;  ///< source address of last receive operation
          unsigned      fLastRecvSize;   ///< size of last recv operation
+         bool          fRecvAnySize;    ///< current recv operation completed when any data received
+
+         // zero-copy send
+         struct ZeroCopyRec {
+            Buffer   buf;                  ///< buffer, which memory still used by the kernel
+            uint32_t last;                 ///< id of last zero-copy sendmsg() call with the buffer
+         };
+
+         unsigned      fZeroCopyMin;    ///< minimal buffer size for zero-copy send, 0 - disabled
+         unsigned      fSendZCFirst;    ///< first element in send IOV which is sent with MSG_ZEROCOPY
+         Buffer        fSendZCBuf;      ///< buffer of current zero-copy send operation
+         uint32_t      fZCCounter;      ///< number of zero-copy sendmsg() calls, kernel uses same numbering in completions
+         uint32_t      fZCStart;        ///< counter value when current send operation was started
+         uint32_t      fZCDone;         ///< all zero-copy calls before this id are completed by the kernel
+         std::deque<ZeroCopyRec> fZCPending; ///< buffers, which memory is still used by the kernel
 
 #ifdef SOCKET_PROFILING
          long           fSendOper;
@@ -197,15 +249,21 @@ namespace dabc {
             if (IsDeliverEventsToWorker()) FireWorkerEvent(evntSocketRecvInfo);
          }
 
+         /** \brief Keep buffer of completed zero-copy send until kernel confirms that memory is released */
+         void FinishZeroCopySend();
+
+         /** \brief Read zero-copy completions from socket error queue and release buffers */
+         void ProcessZeroCopyCompl();
+
          /** \brief Method provide address of last receive operation */
          struct sockaddr_in& GetRecvAddr() { return fRecvAddr; }
 
+      public:
+
          /** \brief Method return size of last buffer read from socket. Useful
-          * only for datagram sockets, which can reads complete packet at once  */
+          * for datagram sockets, which can reads complete packet at once, and with StartRecvAny() */
          unsigned GetRecvSize() const { return fLastRecvSize; }
 
-      public:
-
          /** \brief Constructor of SocketIOAddon class */
          SocketIOAddon(int fd = 0, bool isdatagram = false, bool usemsg = true);
 
@@ -223,12 +281,36 @@ namespace dabc {
 
          bool StartRecvHdr(void* hdr, unsigned hdrsize, void* buf, size_t size);
 
+         /** \brief Start receive, which is completed when any data read from the socket.
+          * \details Allows to read many small messages at once, received size provided by GetRecvSize() */
+         bool StartRecvAny(void* buf, size_t size);
+
          bool StartSend(const Buffer& buf);
          bool StartRecv(Buffer& buf, BufferSize_t datasize);
 
+         /** \brief Start send of several memory pieces with single operation.
+          * \details io vector is copied, memory itself should be preserved until send is completed */
+         bool StartSendV(const struct iovec* iov, unsigned num);
+
+         /** \brief Start receive of several memory pieces with single operation.
+          * \details io vector is copied, operation completed when all pieces are filled */
+         bool StartRecvV(const struct iovec* iov, unsigned num);
+
          bool StartNetRecv(void* hdr, unsigned hdrsize, Buffer& buf, BufferSize_t datasize);
          bool StartNetSend(void* hdr, unsigned hdrsize, const Buffer& buf);
 
+         /** \brief Enable MSG_ZEROCOPY send for buffers with size bigger than minsize.
+          * \details Only for stream sockets on Linux, returns false when not supported - normal send is used then.
+          * Buffer is kept by the addon until kernel signals completion via socket error queue.
+          * Only data of dabc::Buffer are sent with zero-copy, header of StartNetSend() is always copied */
+         bool SetZeroCopy(unsigned minsize);
+
+         /** \brief Returns true if zero-copy send is enabled */
+         bool IsZeroCopy() const { return fZeroCopyMin > 0; }
+
+         /** \brief Number of buffers still used by the kernel after zero-copy send */
+         unsigned NumZeroCopyPending() const { return fZCPending.size(); }
+
          /** \brief Method should be used to cancel all running I/O operation of the socket.
           * Should be used for instance when worker want to be deleted */
          void CancelIOOperations();
@@ -350,9 +432,18 @@ namespace dabc {
     * \ingroup dabc_core_classes
     * \ingroup dabc_all_classes
     *
+    * By default poll() is used to wait for socket events, which requires to rebuild
+    * list of file descriptors before each wait. With "poll" thread parameter equal to "epoll"
+    * or "epollet" epoll backend in level- or edge-triggered mode is used (Linux only).
+    * Then socket is registered once and only changes of addons interest are
+    * submitted to the kernel. In edge-triggered mode socket registration is never changed,
+    * but addons must read/write socket until EAGAIN, otherwise next event can be delayed.
     */
 
    class SocketThread : public Thread {
+
+      friend class SocketAddon;
+
       protected:
          enum ESocketEvents {
             evntEnableCheck = evntLastThrd+1,  ///< event to enable again checking sockets for new events
@@ -364,6 +455,17 @@ namespace dabc {
              uint32_t  indx; ///< index for dereference of processor from ufds structure
          };
 
+         struct EpollRec {
+            SocketAddon* addon;    ///< addon, registered for the worker index
+            int          fd;       ///< socket handle, registered in epoll
+            uint32_t     mask;     ///< events mask, registered in epoll
+            uint32_t     ready;    ///< events reported by epoll, but not yet delivered to addon
+            uint32_t     fired;    ///< events delivered to addon, which may not consume all data (edge-triggered mode)
+            bool         changed;  ///< true when record is in list of changed records
+
+            EpollRec() : addon(nullptr), fd(-1), mask(0), ready(0), fired(0), changed(false) {}
+         };
+
          int            fPipe[2];         ///< array with i/o pipes handles
          long           fPipeFired;       ///< indicate if something was written in pipe
          bool           fWaitFire;        ///< indicates if pipe firing is awaited
@@ -375,16 +477,48 @@ namespace dabc {
          bool           fCheckNewEvents;  ///< flag indicate if sockets should be checked for new events even if there are already events in the queue
          int            fBalanceCnt;      ///< counter for balancing of input events
 
+         int            fEpoll;           ///< epoll handle, -1 when poll() is used
+         bool           fEpollEdge;       ///< use edge-triggered mode of epoll
+         unsigned       f_sizeevnts;      ///< size of allocated epoll events array
+         epoll_event   *f_evnts;          ///< events array for epoll_wait call
+         std::vector<EpollRec> fEpollRecs;    ///< epoll records for each worker
+         std::vector<unsigned> fEpollChanged; ///< workers indexes where socket interest was changed
+         std::vector<unsigned> fEpollPending; ///< workers indexes which have pending events (edge-triggered mode)
+
 #ifdef SOCKET_PROFILING
          long           fWaitCalls;
          long           fWaitDone;
          long           fPipeCalled;
+         long           fCtlCalls;
          double         fWaitTime;
          double         fFillTime;
 #endif
 
          virtual bool WaitEvent(EventId&, double tmout);
 
+         /** \brief Check sockets and wait for events, called from \ref WaitEvent */
+         bool WaitSocketEvent(EventId&, double tmout);
+
+         /** \brief Mark epoll record as changed, will be applied before next wait */
+         inline void EpollMarkChanged(unsigned indx)
+         {
+            if ((indx >= fEpollRecs.size()) || fEpollRecs[indx].changed) return;
+            fEpollRecs[indx].changed = true;
+            fEpollChanged.push_back(indx);
+         }
+
+         /** \brief Remove addon socket from epoll, called before socket is closed or taken */
+         void EpollRemoveSocket(unsigned indx);
+
+         /** \brief Submit accumulated interest changes to epoll */
+         void EpollApplyChanges();
+
+         /** \brief Push events for the worker, reported by epoll. Should be called under thread mutex */
+         bool _EpollDeliver(unsigned indx);
+
+         /** \brief Wait for events with epoll_wait, called from \ref WaitEvent */
+         bool EpollWaitEvent(EventId&, double tmout);
+
          virtual void _Fire(const EventId& evnt, int nq);
 
          virtual void WorkersSetChanged();
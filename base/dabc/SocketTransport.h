@@ -24,6 +24,8 @@
 #include "dabc/NetworkTransport.h"
 #endif
 
+#include <vector>
+
 namespace dabc {
 
    /** \brief Specific implementation of network transport for socket
@@ -40,11 +42,19 @@ namespace dabc {
          char*       fHeaders;
          RecIdsQueue fSendQueue;
          RecIdsQueue fRecvQueue;
-         int         fRecvStatus;  ///< 0 - idle, 1 - header, 2 - front buffer from recv queue
+         int         fRecvStatus;  ///< 0 - idle, 1 - header, 2 - front buffer from recv queue, 3 - batch table, 4 - batch data, 5 - batch waits for records
          uint32_t    fRecvRecid;   ///< if of the record, used for data receiving (status != 0)
-         int         fSendStatus;  ///< 0 - idle, 1 - sending
+         int         fSendStatus;  ///< 0 - idle, 1 - sending, 2 - sending batch
          uint32_t    fSendRecid;   ///< id of the active send record
 
+         std::vector<uint32_t> fSendBatch;     ///< records in current batch send operation
+         std::vector<char>     fSendBatchHdr;  ///< header and table of batch send operation
+         std::vector<NetworkTransport::NetworkBatchEntry> fRecvTable; ///< table of currently received batch
+         unsigned              fRecvBatchIndx; ///< next entry of received batch, which should get record
+         bool                  fRecvHdrRec;    ///< record used for batch header not yet assigned to the entry
+         std::vector<uint32_t> fRecvBatch;     ///< records in current batch recv operation
+         std::vector<struct iovec> fBatchIOV;  ///< io vector to build batch operations
+
          std::string fMcastAddr;   ///< mcast address
 
          virtual long Notify(const std::string&, int);
@@ -54,6 +64,13 @@ namespace dabc {
 
          virtual void OnSocketError(int msg, const std::string &info);
 
+         /** \brief Combine several queued records in one send operation */
+         bool StartBatchSend(NetworkTransport* tr);
+
+         /** \brief Start receiving data of batch entries into available records.
+          * \returns 0 - error or no records, 1 - recv started, 2 - no data to receive, can be completed immediately */
+         int StartBatchRecv(NetworkTransport* tr);
+
       public:
          SocketNetworkInetrface(int fd, bool datagram = false);
          virtual ~SocketNetworkInetrface();
@@ -197,35 +197,41 @@ namespace dabc {
                return false;
             }
 
-            bool CheckNextProcess(const TimeStamp& now, double& min_tmout, double& last_diff)
-            {
-               if (next_fire.null()) return false;
-
-               double dist = next_fire - now;
-
-               if (dist>=0.) {
-                  if ((min_tmout<0.) || (dist<min_tmout))  min_tmout = dist;
-                  return false;
-               }
+            /** Returns time since previous timeout processing */
+            double LastDiff(const TimeStamp& now) const { return prev_fire.null() ? 0. : now - prev_fire; }
 
-               last_diff = prev_fire.null() ? 0. : now - prev_fire;
-
-               return true;
-            }
-
-            void SetNextFire(const TimeStamp& now, double dist, double& min_tmout)
+            /** Set next fire time, returns true when timeout remains active */
+            bool SetNextFire(const TimeStamp& now, double dist)
             {
                if (dist>=0.) {
                   prev_fire = now;
                   next_fire = now + dist;
-                  if ((min_tmout<0.) || (dist<min_tmout))  min_tmout = dist;
-               } else {
-                  prev_fire.Reset();
-                  next_fire.Reset();
+                  return true;
                }
+
+               prev_fire.Reset();
+               next_fire.Reset();
+               return false;
             }
          };
 
+         /** Entry in the heap of active timeouts
+          * Entry is valid only as long as its fire time matches next_fire of the timeout record,
+          * otherwise it is just ignored when extracted from the heap */
+         struct TimeoutEntry {
+            TimeStamp      fire;         ///< when timeout should be processed
+            unsigned       workerid;     ///< worker id
+            bool           addon;        ///< timeout for addon or for worker
+
+            TimeoutEntry(const TimeStamp& _fire, unsigned _id, bool _addon) :
+               fire(_fire), workerid(_id), addon(_addon) {}
+
+            /** Ordering for std::push_heap/std::pop_heap, earliest entry on the top */
+            bool operator<(const TimeoutEntry& src) const { return fire > src.fire; }
+         };
+
+         typedef std::vector<TimeoutEntry> TimeoutsHeap;
+
 
 
          struct WorkerRec {
@@ -283,8 +289,18 @@ namespace dabc {
          EventsQueue         *fQueues;         ///< queues for threads events
          int                  fNumQueues;      ///< number of queues
 
+         EventId             *fDrainBuf;       ///< events taken from queues with single lock, but not yet processed
+         unsigned             fDrainSize;      ///< maximal number of events taken from queues at once
+         unsigned             fDrainNum;       ///< number of events in drain buffer
+         unsigned             fDrainPos;       ///< position of next event in drain buffer
+         uint64_t             fStatEvents;     ///< total number of events taken from queues
+         uint64_t             fStatLocks;      ///< number of locked queue accesses which delivered events
+         std::atomic<unsigned> fNumPending;    ///< number of events in queues, checked without lock when spinning
+         double               fSpinTime;       ///< time in seconds to spin before blocking, negative - busy polling
+
          TimeStamp            fNextTimeout;    ///< indicate when we expects next timeout
          int                  fProcessingTimeouts; ///< indicate recursion in timeouts processing
+         TimeoutsHeap         fTimeouts;       ///< min-heap of active timeouts, used only from thread itself
 
          WorkersVector        fWorkers;          ///< vector of all processors
 
@@ -381,6 +397,9 @@ namespace dabc {
 
          virtual int ExecuteThreadCommand(Command cmd);
 
+         /** \brief Returns thread configuration parameter, taken from command or from xml file */
+         RecordField ThreadCfg(const std::string &name, Command cmd = nullptr) const;
+
          virtual bool WaitEvent(EventId&, double tmout);
 
          void ProcessEvent(const EventId&);
@@ -391,8 +410,32 @@ namespace dabc {
 
          void ProcessNoneEvent();
 
+         /** Take next event from the queues, up to fDrainSize-1 further events moved into drain buffer */
          bool _GetNextEvent(EventId&);
 
+         /** Pop single event from the queues according to their priorities */
+         bool _PopEvent(EventId&);
+
+         /** Returns how long thread should spin before blocking for specified waiting timeout,
+          * negative value means spinning without time limit */
+         double SpinLimit(double tmout) const
+         {
+            if (fSpinTime < 0.) return tmout;
+            return ((tmout >= 0.) && (tmout < fSpinTime)) ? tmout : fSpinTime;
+         }
+
+         /** Spin until events appear in the queues or spin limit is reached,
+          * remaining waiting time is returned in tmout. Used in spin-then-block mode */
+         void SpinForEvents(double& tmout);
+
+         /** Returns event, drained before from the queues, does not require locking */
+         inline bool TakeDrainedEvent(EventId& evnt)
+         {
+            if (fDrainPos >= fDrainNum) return false;
+            evnt = fDrainBuf[fDrainPos++];
+            return true;
+         }
+
          virtual void RunnableCancelled();
 
         #ifdef DABC_EXTRA_CHECKS
@@ -411,6 +454,7 @@ namespace dabc {
             #endif
 
             fQueues[nq<0 ? fNumQueues - 1 : nq].Push(arg);
+            fNumPending.fetch_add(1, std::memory_order_release);
 
             #ifdef DABC_EXTRA_CHECKS
             if (nq<0) nq = fNumQueues - 1;
@@ -430,8 +474,20 @@ namespace dabc {
             _Fire(arg, nq);
          }
 
+         /** Fire same event several times, thread mutex must be locked */
+         inline void _FireEvents(const EventId& arg, unsigned cnt, int nq)
+         {
+            while (cnt-- > 0) _Fire(arg, nq);
+         }
+
          double CheckTimeouts(bool forcerecheck = false);
 
+         /** Returns timeout record for the heap entry or nullptr when entry is outdated */
+         TimeoutRec* GetTimeoutRec(const TimeoutEntry& entry);
+
+         /** Insert timeout into heap, called when next fire time of the worker is changed */
+         void PushTimeout(unsigned workerid, bool addon, const TimeStamp& fire);
+
          /** \brief Internal DABC method, Add worker to thread; reference-safe
           * Reference safe means - it is safe to call it as long as reference on thread is exists
           * We use here reference on the worker to ensure that it does not disappear meanwhile*/
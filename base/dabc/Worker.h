@@ -359,6 +359,21 @@ namespace dabc {
          }
 
 
+         /** Fire same event several times with single lock of thread mutex */
+         inline bool _FireEvents(uint16_t evid, uint32_t arg, unsigned cnt, int pri = -1)
+         {
+            if (!_IsFireEvent()) return false;
+            fThread()->_FireEvents(EventId(evid, fWorkerId, arg), cnt, pri < 0 ? fWorkerPriority : pri);
+            fWorkerFiredEvents += cnt;
+            return true;
+         }
+
+         inline bool FireEvents(uint16_t evid, uint32_t arg, unsigned cnt, int pri = -1)
+         {
+            LockGuard lock(fThreadMutex);
+            return _FireEvents(evid, arg, cnt, pri);
+         }
+
          inline bool _FireDoNothingEvent()
          {
             if (!_IsFireEvent()) return false;
@@ -26,6 +26,10 @@
 #include "dabc/logging.h"
 #endif
 
+#ifndef DABC_SmallObjects
+#include "dabc/SmallObjects.h"
+#endif
+
 #if defined(__MACH__) /* Apple OSX section */
 
 // try to provide dummy wrapper for all using functions around affinity
@@ -68,6 +72,10 @@ namespace dabc {
      public:
         Mutex(bool recursive = false);
         inline ~Mutex() { pthread_mutex_destroy(&fMutex); }
+
+        // mutexes of objects like commands created and deleted very often
+        static void *operator new(size_t sz) { return SmallObjects::Allocate(sz); }
+        static void operator delete(void *ptr, size_t sz) { SmallObjects::Release(ptr, sz); }
         inline void Lock() { pthread_mutex_lock(&fMutex); }
         inline void Unlock() { pthread_mutex_unlock(&fMutex); }
         bool TryLock();
@@ -303,6 +311,12 @@ namespace dabc {
 
          bool _DoWait(double wait_seconds);
 
+         /** Account several fired events at once, used when events are taken out without waiting */
+         inline void _DoTake(long cnt)
+         {
+            fFiredCounter = (fFiredCounter > cnt) ? fFiredCounter - cnt : 0;
+         }
+
          Mutex* CondMutex() const { return fCondMutex; }
 
          bool _Waiting() const { return fWaiting; }
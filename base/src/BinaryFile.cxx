@@ -21,7 +21,12 @@
 #include <fnmatch.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <climits>
+#include <cerrno>
 #include <cstring>
+#include <vector>
 
 #include "dabc/Object.h"
 #include "dabc/logging.h"
@@ -107,3 +112,329 @@ dabc::Object* dabc::FileInterface::fmatch(const char* fmask, bool select_files)
 
    return res;
 }
+
+// ===============================================================================
+
+namespace dabc {
+
+   /** Handle of file, opened by PosixFileInterface */
+   struct PosixFileHandle {
+      int      fd;         ///< file descriptor
+      bool     writing;    ///< file opened for writing
+      bool     direct;     ///< file opened with O_DIRECT
+      bool     eof;        ///< end of file reached by reading
+      uint64_t pos;        ///< current position in the file, including staged data
+      uint64_t maxpos;     ///< largest position before seek, file not truncated below it
+      uint64_t allocated;  ///< preallocated or padded file size
+      char*    stage;      ///< aligned staging buffer for O_DIRECT, always starts at aligned file offset
+      size_t   stagefill;  ///< filled size of staging buffer
+
+      PosixFileHandle() : fd(-1), writing(false), direct(false), eof(false), pos(0), maxpos(0), allocated(0), stage(nullptr), stagefill(0) {}
+   };
+
+   /** Write complete iovec list at specified position, repeat when partially written */
+   static bool PosixWriteAll(int fd, struct iovec* iov, unsigned cnt, uint64_t pos)
+   {
+      while (cnt > 0) {
+         int portion = cnt > IOV_MAX ? IOV_MAX : cnt;
+         ssize_t res = pwritev(fd, iov, portion, pos);
+         if (res < 0) {
+            if (errno == EINTR) continue;
+            EOUT("pwritev fails %s", strerror(errno));
+            return false;
+         }
+         pos += res;
+         // skip completely written pieces, adjust partially written
+         while ((cnt > 0) && (res >= (ssize_t) iov->iov_len)) {
+            res -= iov->iov_len;
+            iov++; cnt--;
+         }
+         if (res > 0) {
+            iov->iov_base = (char*) iov->iov_base + res;
+            iov->iov_len -= res;
+         }
+      }
+      return true;
+   }
+
+   /** Write staging buffer padded to the block size, incomplete last block remains in the buffer
+    * and will be written again when more data come. Padding is truncated on close */
+   static bool PosixFlushStage(PosixFileHandle* h, size_t align)
+   {
+      if (h->stagefill == 0) return true;
+
+      size_t full = h->stagefill / align * align,
+             padded = (h->stagefill + align - 1) / align * align;
+      uint64_t stagepos = h->pos - h->stagefill;
+
+      memset(h->stage + h->stagefill, 0, padded - h->stagefill);
+
+      struct iovec iov;
+      iov.iov_base = h->stage;
+      iov.iov_len = padded;
+      if (!PosixWriteAll(h->fd, &iov, 1, stagepos)) return false;
+
+      if (stagepos + padded > h->allocated) h->allocated = stagepos + padded;
+
+      if (full < h->stagefill) memmove(h->stage, h->stage + full, h->stagefill - full);
+      h->stagefill -= full;
+      return true;
+   }
+
+}
+
+dabc::FileInterface::Handle dabc::PosixFileInterface::fopen(const char* fname, const char* mode, const char*)
+{
+   if (!fname || !*fname || !mode) return nullptr;
+
+   bool writing = (strchr(mode, 'w') != nullptr) || (strchr(mode, 'a') != nullptr);
+   bool append = strchr(mode, 'a') != nullptr;
+
+   int flags = writing ? (O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC)) : O_RDONLY;
+   bool direct = false;
+
+   int fd = -1;
+#ifdef O_DIRECT
+   if (writing && fDirect) {
+      fd = ::open(fname, flags | O_DIRECT, 0644);
+      // not all file systems support O_DIRECT
+      if (fd >= 0) direct = true;
+              else DOUT0("Cannot open %s with O_DIRECT (%s), use normal mode", fname, strerror(errno));
+   }
+#endif
+   if (fd < 0) fd = ::open(fname, flags, 0644);
+
+   if (fd < 0) return nullptr;
+
+   PosixFileHandle* h = new PosixFileHandle;
+   h->fd = fd;
+   h->writing = writing;
+   h->direct = direct;
+
+   if (append) {
+      off_t end = lseek(fd, 0, SEEK_END);
+      h->pos = h->allocated = (end > 0) ? end : 0;
+      // O_DIRECT requires aligned offset
+      if (direct && (h->pos % DirectAlign != 0)) {
+         fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+         h->direct = false;
+      }
+   }
+
+   if (h->direct && (posix_memalign((void**) &h->stage, DirectAlign, StageSize) != 0)) {
+      ::close(fd);
+      delete h;
+      return nullptr;
+   }
+
+   return (Handle) h;
+}
+
+void dabc::PosixFileInterface::fclose(Handle f)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   if (!h) return;
+
+   if (h->writing && (h->stagefill > 0)) {
+      // rest of data is not aligned, write it without O_DIRECT
+#ifdef O_DIRECT
+      fcntl(h->fd, F_SETFL, fcntl(h->fd, F_GETFL) & ~O_DIRECT);
+#endif
+      struct iovec iov;
+      iov.iov_base = h->stage;
+      iov.iov_len = h->stagefill;
+      PosixWriteAll(h->fd, &iov, 1, h->pos - h->stagefill);
+      h->stagefill = 0;
+   }
+
+   // release preallocated but not used space and padding of flushed blocks
+   uint64_t end = h->pos > h->maxpos ? h->pos : h->maxpos;
+   if (h->writing && (h->allocated > end))
+      if (ftruncate(h->fd, end) != 0)
+         EOUT("ftruncate fails %s", strerror(errno));
+
+   ::close(h->fd);
+   std::free(h->stage);
+   delete h;
+}
+
+size_t dabc::PosixFileInterface::fwrite(const void* ptr, size_t sz, size_t nmemb, Handle f)
+{
+   if (!f || !ptr) return 0;
+   size_t len = sz*nmemb;
+   return fwritev(&ptr, &len, 1, f) ? nmemb : 0;
+}
+
+bool dabc::PosixFileInterface::fwritev(const void* const* ptrs, const size_t* sizes, unsigned num, Handle f)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   if (!h || !h->writing) return false;
+
+   uint64_t total = 0;
+   for (unsigned n = 0; n < num; n++)
+      total += sizes[n];
+
+#if defined(__linux__)
+   if ((fPrealloc > 0) && (h->pos + total > h->allocated)) {
+      uint64_t newsize = ((h->pos + total) / fPrealloc + 1) * fPrealloc;
+      if (fallocate(h->fd, FALLOC_FL_KEEP_SIZE, h->allocated, newsize - h->allocated) == 0) {
+         h->allocated = newsize;
+      } else {
+         DOUT0("fallocate fails %s, disable preallocation", strerror(errno));
+         fPrealloc = 0;
+      }
+   }
+#endif
+
+   std::vector<struct iovec> iov;
+   iov.reserve(num);
+
+   if (!h->direct) {
+      for (unsigned n = 0; n < num; n++) {
+         if (sizes[n] == 0) continue;
+         struct iovec item;
+         item.iov_base = (void*) ptrs[n];
+         item.iov_len = sizes[n];
+         iov.push_back(item);
+      }
+
+      if (!PosixWriteAll(h->fd, iov.data(), iov.size(), h->pos)) return false;
+      h->pos += total;
+      return true;
+   }
+
+   // with O_DIRECT memory, size and file offset must be aligned
+   // staging buffer starts at aligned file offset, when data have same alignment as file position,
+   // only head is copied to complete staging buffer up to the block boundary, rest written directly
+   // together with the staging buffer. Otherwise data collected in staging buffer
+   uint64_t batchpos = 0, pending = 0; // file offset and size of direct pieces in iov
+   bool staged = false;                // staging buffer is part of iov
+
+   for (unsigned n = 0; n < num; n++) {
+      const char* ptr = (const char*) ptrs[n];
+      size_t size = sizes[n];
+
+      while (size > 0) {
+         size_t head = (DirectAlign - (h->pos + pending) % DirectAlign) % DirectAlign;
+
+         if ((((uintptr_t) ptr + head) % DirectAlign == 0) && (size >= head + DirectAlign)) {
+            // with head > 0 last data were copied into stage, therefore iov is empty
+            if (head > 0) {
+               memcpy(h->stage + h->stagefill, ptr, head);
+               h->stagefill += head;
+               h->pos += head;
+               ptr += head;
+               size -= head;
+            }
+            struct iovec item;
+            if (iov.empty()) batchpos = h->pos - h->stagefill;
+            if ((h->stagefill > 0) && !staged) {
+               item.iov_base = h->stage;
+               item.iov_len = h->stagefill;
+               iov.push_back(item);
+               staged = true;
+            }
+            item.iov_base = (void*) ptr;
+            item.iov_len = size / DirectAlign * DirectAlign;
+            iov.push_back(item);
+            ptr += item.iov_len;
+            size -= item.iov_len;
+            pending += item.iov_len;
+            continue;
+         }
+
+         // staged data follow directly written
+         if (!iov.empty()) {
+            if (!PosixWriteAll(h->fd, iov.data(), iov.size(), batchpos)) return false;
+            iov.clear();
+            h->pos += pending;
+            pending = 0;
+            if (staged) { h->stagefill = 0; staged = false; }
+         }
+
+         size_t len = StageSize - h->stagefill;
+         if (len > size) len = size;
+         memcpy(h->stage + h->stagefill, ptr, len);
+         h->stagefill += len;
+         h->pos += len;
+         ptr += len;
+         size -= len;
+
+         if (h->stagefill == StageSize) {
+            struct iovec item;
+            item.iov_base = h->stage;
+            item.iov_len = StageSize;
+            if (!PosixWriteAll(h->fd, &item, 1, h->pos - StageSize)) return false;
+            h->stagefill = 0;
+         }
+      }
+   }
+
+   if (!iov.empty()) {
+      if (!PosixWriteAll(h->fd, iov.data(), iov.size(), batchpos)) return false;
+      h->pos += pending;
+      if (staged) h->stagefill = 0;
+   }
+
+   return true;
+}
+
+size_t dabc::PosixFileInterface::fread(void* ptr, size_t sz, size_t nmemb, Handle f)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   if (!h || !ptr || h->writing || (sz == 0)) return 0;
+
+   size_t total = sz*nmemb, got = 0;
+
+   while (got < total) {
+      ssize_t res = pread(h->fd, (char*) ptr + got, total - got, h->pos);
+      if ((res < 0) && (errno == EINTR)) continue;
+      if (res <= 0) { h->eof = true; break; }
+      got += res;
+      h->pos += res;
+   }
+
+   return got / sz;
+}
+
+bool dabc::PosixFileInterface::feof(Handle f)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   return h ? h->eof : false;
+}
+
+bool dabc::PosixFileInterface::fflush(Handle f)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   if (!h) return false;
+
+   // staged O_DIRECT data written padded, incomplete block kept in staging buffer
+   return !h->writing || PosixFlushStage(h, DirectAlign);
+}
+
+bool dabc::PosixFileInterface::fseek(Handle f, long int offset, bool relative)
+{
+   PosixFileHandle* h = (PosixFileHandle*) f;
+   if (!h) return false;
+
+   int64_t newpos = relative ? (int64_t) h->pos + offset : offset;
+   if (newpos < 0) return false;
+
+   if (h->writing && ((uint64_t) newpos != h->pos)) {
+      if (h->pos > h->maxpos) h->maxpos = h->pos;
+      if (h->direct) {
+         // padding of staged data must not overwrite existing content,
+         // therefore after seek data written without O_DIRECT
+         if (!PosixFlushStage(h, DirectAlign)) return false;
+         h->stagefill = 0;
+#ifdef O_DIRECT
+         fcntl(h->fd, F_SETFL, fcntl(h->fd, F_GETFL) & ~O_DIRECT);
+#endif
+         h->direct = false;
+      }
+   }
+
+   h->pos = newpos;
+   h->eof = false;
+   return true;
+}
@@ -314,6 +314,73 @@ bool dabc::Buffer::Insert(BufferSize_t pos, Buffer& src, bool moverefs)
 }
 
 
+bool dabc::Buffer::AppendRef(const Pointer& ptr, BufferSize_t len)
+{
+   if (null() || (len == 0) || (ptr.fullsize() < len)) return false;
+
+   const Buffer& src = ptr.fBuf;
+
+   MemoryPool* pool = src.PoolPtr();
+   if (!pool) return false;
+
+   if ((NumSegments() == 0) && GetObject()->fPool.null())
+      GetObject()->fPool = src.GetObject()->fPool;
+   else if (PoolPtr() != pool)
+      return false;
+
+   MemSegment* tgt = Segments();
+   const MemSegment* srcsegm = src.Segments();
+   unsigned numseg = NumSegments(), firstnew = numseg;
+
+   // first count segments, buffer should not be changed if operation is not possible
+   unsigned nsrc = ptr.fSegm, required = 0;
+   BufferSize_t rest = len, piece = ptr.fRawSize < len ? ptr.fRawSize : len;
+   bool merge = (numseg > 0) && (tgt[numseg-1].id == srcsegm[nsrc].id) &&
+                ((char*) tgt[numseg-1].buffer + tgt[numseg-1].datasize == (char*) ptr.fPtr);
+
+   while (rest > 0) {
+      if (!merge || (rest < len)) required++;
+      rest -= piece;
+      if (rest > 0) {
+         nsrc++;
+         piece = srcsegm[nsrc].datasize < rest ? srcsegm[nsrc].datasize : rest;
+      }
+   }
+
+   if (numseg + required > GetObject()->fCapacity) return false;
+
+   nsrc = ptr.fSegm;
+   rest = len;
+   piece = ptr.fRawSize < len ? ptr.fRawSize : len;
+   void* pos = ptr.fPtr;
+
+   while (rest > 0) {
+      if (merge && (rest == len)) {
+         tgt[numseg-1].datasize += piece;
+      } else {
+         tgt[numseg].id = srcsegm[nsrc].id;
+         tgt[numseg].buffer = pos;
+         tgt[numseg].datasize = piece;
+         numseg++;
+      }
+      rest -= piece;
+      if (rest > 0) {
+         nsrc++;
+         pos = srcsegm[nsrc].buffer;
+         piece = srcsegm[nsrc].datasize < rest ? srcsegm[nsrc].datasize : rest;
+      }
+   }
+
+   // merged piece is covered by reference of existing segment
+   if (numseg > firstnew)
+      pool->IncreaseSegmRefs(tgt + firstnew, numseg - firstnew);
+
+   GetObject()->fNumSegments = numseg;
+
+   return true;
+}
+
+
 std::string dabc::Buffer::AsStdString()
 {
    std::string sbuf;
@@ -446,6 +513,20 @@ dabc::Buffer dabc::Buffer::CreateBuffer(const void* ptr, unsigned size, bool own
    return res;
 }
 
+dabc::Buffer dabc::Buffer::CreateBuffer(const void* ptr, unsigned size, const Reference& owner) throw()
+{
+   dabc::Buffer res;
+
+   res.AllocateContainer(8);
+
+   res.GetObject()->fPool = owner;
+   res.GetObject()->fNumSegments = 1;
+   res.GetObject()->fSegm[0].buffer = (void*) ptr;
+   res.GetObject()->fSegm[0].datasize = size;
+
+   return res;
+}
+
 
 bool dabc::Buffer::CanSafelyChange() const
 {
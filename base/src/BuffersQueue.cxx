@@ -39,3 +39,10 @@ void dabc::BuffersQueue::Cleanup(Mutex* m)
 
    } while (!buf.null());
 }
+
+void dabc::BuffersRing::Cleanup()
+{
+   Buffer buf;
+   while (PopBuffer(buf))
+      buf.Release();
+}
@@ -9,6 +9,7 @@ dabc::CommandsQueue::CommandsQueue(EKind kind) :
    fKind(kind),
    fIdCounter(0)
 {
+   for (int n = 0; n <= kindPostponed; n++) fKindCnt[n] = 0;
 }
 
 dabc::CommandsQueue::~CommandsQueue()
@@ -30,6 +31,7 @@ void dabc::CommandsQueue::Cleanup(Mutex* m, Worker* proc, int res)
 
          cmd << fList.front().cmd;
          kind = fList.front().kind;
+         fKindCnt[kind]--;
          fList.pop_front();
       }
 
@@ -62,6 +64,7 @@ void dabc::CommandsQueue::ReplyTimedout()
 
       iter->cmd.Reply(dabc::cmd_timedout);
 
+      fKindCnt[iter->kind]--;
       QueueRecsList::iterator curr = iter++;
       fList.erase(curr);
    }
@@ -79,6 +82,7 @@ uint32_t dabc::CommandsQueue::Push(Command cmd, EKind kind)
 
    fList.back().cmd << cmd;
    fList.back().kind = kind;
+   fKindCnt[kind]++;
    fList.back().id = fIdCounter;
 
    return fIdCounter;
@@ -92,6 +96,7 @@ dabc::Command dabc::CommandsQueue::Pop()
 
    cmd << fList.front().cmd;
 
+   fKindCnt[fList.front().kind]--;
    fList.pop_front();
 
    return cmd;
@@ -99,10 +104,14 @@ dabc::Command dabc::CommandsQueue::Pop()
 
 dabc::Command dabc::CommandsQueue::PopWithKind(EKind kind)
 {
+   // typically called when many other commands are in the queue
+   if (fKindCnt[kind] == 0) return dabc::Command();
+
    for (QueueRecsList::iterator iter = fList.begin(); iter != fList.end(); iter++) {
       if (iter->kind==kind) {
          dabc::Command cmd;
          cmd << iter->cmd;
+         fKindCnt[iter->kind]--;
          fList.erase(iter);
          return cmd;
       }
@@ -117,6 +126,7 @@ dabc::Command dabc::CommandsQueue::PopWithId(uint32_t id)
       if (iter->id==id) {
          dabc::Command cmd;
          cmd << iter->cmd;
+         fKindCnt[iter->kind]--;
          fList.erase(iter);
          return cmd;
       }
@@ -139,6 +149,8 @@ uint32_t dabc::CommandsQueue::ChangeKind(Command& cmd, EKind kind)
 {
    for (QueueRecsList::iterator iter = fList.begin(); iter != fList.end(); iter++) {
       if (iter->cmd==cmd) {
+         fKindCnt[iter->kind]--;
+         fKindCnt[kind]++;
          iter->kind = kind;
          return iter->id;
       }
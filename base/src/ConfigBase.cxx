@@ -38,6 +38,7 @@ namespace dabc {
    const char* xmlThreadAttr       = "thread";
    const char* xmlUseacknAttr      = "useackn";
    const char* xmlOptionalAttr     = "optional";
+   const char* xmlBatchAttr        = "batch";
    const char* xmlPoolAttr         = "pool";
    const char* xmlTimeoutAttr      = "timeout";
    const char* xmlAutoAttr         = "auto";
@@ -76,6 +77,7 @@ namespace dabc {
    const char* xmlNormalMainThrd   = "normalmainthrd";
    const char* xmlAffinity         = "affinity";
    const char* xmlThreadsLayout    = "threads_layout";
+   const char* xmlSmallObjects     = "smallobjects";
    const char* xmlTaskset          = "taskset";
    const char* xmlLDPATH           = "LD_LIBRARY_PATH";
    const char* xmlUserLib          = "lib";
@@ -113,6 +113,10 @@ bool dabc::Configuration::SelectContext(unsigned nodeid, unsigned numnodes)
    if (log.length()>0)
       dabc::Logger::Instance()->SetLogLimit(std::stoi(log));
 
+   val = Find1(fSelected, "", xmlRunNode, xmlSmallObjects);
+   if (!val.empty())
+      dabc::SmallObjects::SetMaxKeep(std::stoi(val));
+
    fLocalHost = Find1(fSelected, "", xmlRunNode, xmlSocketHost);
 
    return true;
@@ -485,6 +485,7 @@ bool dabc::ConnectionManager::FillAnswerOnRemoteConnectCmd(Command cmd, Connecti
       cmd.SetInt("ServerInlineSize", req.GetInlineDataSize());
       cmd.SetDouble("ServerTimeout", req.GetConnTimeout());
       cmd.SetBool(dabc::xmlUseAcknowledge, req.GetUseAckn());
+      cmd.SetUInt("ServerBatchSize", req.GetBatchSize());
 
    } else {
       // should not happened
@@ -550,6 +551,8 @@ void dabc::ConnectionManager::HandleCmdGlobalConnectReply(CmdGlobalConnect cmd)
             req.SetConnTimeoutDirectly(cmd.GetDouble("ServerTimeout", 10.));
             // this acknowledge parameter of protocol, one can later code it inside serverid
             req.SetUseAcknDirectly(cmd.GetBool(dabc::xmlUseAcknowledge, false));
+            // batching is also defined by the server, both sides should support it
+            req.SetBatchSizeDirectly(cmd.GetUInt("ServerBatchSize", 0));
 
             int inlinesize = cmd.GetInt("ServerInlineSize");
             if (inlinesize != req.GetInlineDataSize()) {
@@ -140,6 +140,13 @@ void dabc::ConnectionRequest::SetConfigFromXml(XMLNodePointer_t node)
       SetUseAckn(strcmp(useackn, xmlTrueValue)==0);
    }
 
+   const char* batch = Xml::GetAttr(node, xmlBatchAttr);
+   int batch_val(0);
+   if ((batch!=0) && str_to_int(batch, &batch_val) && (batch_val>=0)) {
+      SetAllowedField(xmlBatchAttr);
+      SetBatchSize(batch_val);
+   }
+
    const char* isserver = Xml::GetAttr(node, "server");
    if (isserver!=0) {
       SetAllowedField("server");
@@ -17,6 +17,166 @@
 
 #include "dabc/Manager.h"
 #include "dabc/Publisher.h"
+#include "dabc/BuffersQueue.h"
+
+namespace dabc {
+
+   /** \brief Thread, which performs writing of buffers for \ref dabc::OutputTransport
+    *
+    * Transport thread only submits buffers, all calls of output methods during writing
+    * are done in writer thread. Buffers are released (returned to the pool) after writing */
+
+   class OutputAsyncWriter : public Runnable {
+      public:
+         OutputTransport* fTransport;  ///< transport, informed when writer has free slot
+         DataOutput*      fOutput;     ///< output object
+         Mutex            fOutMutex;   ///< serializes all calls of output methods
+         Mutex            fMutex;      ///< protects queue and state
+         Condition        fCond;       ///< fired when new buffer submitted or stop requested
+         BuffersQueue     fQueue;      ///< buffers waiting for writing
+         unsigned         fInFlight;   ///< buffers submitted and not yet written
+         unsigned         fStatus;     ///< do_Ok or first error from output
+         bool             fWaiting;    ///< transport waits for call-back
+         bool             fStop;       ///< thread should be stopped
+         uint64_t         fNumWritten; ///< number of written buffers
+         unsigned         fMaxInFlight; ///< maximal number of buffers in flight
+         PosixThread      fThrd;       ///< writer thread
+
+         OutputAsyncWriter(OutputTransport* tr, DataOutput* out, unsigned depth) :
+            Runnable(),
+            fTransport(tr),
+            fOutput(out),
+            fOutMutex(),
+            fMutex(),
+            fCond(&fMutex),
+            fQueue(depth),
+            fInFlight(0),
+            fStatus(do_Ok),
+            fWaiting(false),
+            fStop(false),
+            fNumWritten(0),
+            fMaxInFlight(0),
+            fThrd()
+         {
+            fThrd.Start(this);
+            fThrd.SetThreadName("DabcWriter");
+         }
+
+         virtual ~OutputAsyncWriter()
+         {
+            {
+               LockGuard lock(fMutex);
+               fStop = true;
+               fWaiting = false; // transport will not be informed any longer
+               fCond._DoFire();
+            }
+            fThrd.Join();
+         }
+
+         /** Check if new buffer can be submitted.
+          * Returns do_Ok when buffer can be submitted, do_CallBack when transport must wait,
+          * do_Error or do_Close when output failed. With drain=true waits until all buffers are written */
+         unsigned Check(bool drain)
+         {
+            LockGuard lock(fMutex);
+            if (fStatus != do_Ok) return fStatus;
+            if (drain ? (fInFlight > 0) : (fInFlight >= fQueue.Capacity())) {
+               fWaiting = true;
+               return do_CallBack;
+            }
+            return do_Ok;
+         }
+
+         void Submit(Buffer& buf)
+         {
+            LockGuard lock(fMutex);
+            fQueue.PushBuffer(buf);
+            if (++fInFlight > fMaxInFlight) fMaxInFlight = fInFlight;
+            fCond._DoFire();
+         }
+
+         void ResetStatus()
+         {
+            LockGuard lock(fMutex);
+            fStatus = do_Ok;
+         }
+
+         /** Write single buffer, output mutex is locked */
+         unsigned WriteBuffer(Buffer& buf)
+         {
+            if (buf.GetTypeId() == mbt_EOL) {
+               fOutput->Write_Flush();
+               return do_Ok;
+            }
+
+            while (true) {
+               unsigned ret = fOutput->Write_Check();
+               if (ret == do_Ok) break;
+               if (ret == do_Skip) return do_Ok;
+               if (ret == do_Repeat) continue;
+               if (ret == do_RepeatTimeOut) {
+                  dabc::Sleep(fOutput->Write_Timeout());
+                  continue;
+               }
+               if (ret == do_CallBack) {
+                  EOUT("Call-back not supported by asynchronous output");
+                  return do_Error;
+               }
+               return ret;
+            }
+
+            unsigned ret = fOutput->Write_Buffer(buf);
+            if (ret == do_Skip) return do_Ok;
+            if (ret == do_Ok) return fOutput->Write_Complete();
+            if (ret == do_CallBack) {
+               EOUT("Call-back not supported by asynchronous output");
+               return do_Error;
+            }
+            return ret;
+         }
+
+         virtual void* MainLoop()
+         {
+            while (true) {
+               Buffer buf;
+               unsigned status = do_Ok;
+
+               {
+                  LockGuard lock(fMutex);
+                  while (!fStop && (fQueue.Size() == 0))
+                     fCond._DoWait(-1.);
+                  if (fQueue.Size() == 0) break;
+                  fQueue.PopBuffer(buf);
+                  status = fStatus;
+               }
+
+               // after error remaining buffers are not written
+               if (status == do_Ok) {
+                  LockGuard lock(fOutMutex);
+                  status = WriteBuffer(buf);
+               }
+
+               // return buffer to the pool before informing transport
+               buf.Release();
+
+               bool fire = false;
+               {
+                  LockGuard lock(fMutex);
+                  fInFlight--;
+                  if (status == do_Ok) fNumWritten++;
+                                  else if (fStatus == do_Ok) fStatus = status;
+                  fire = fWaiting;
+                  fWaiting = false;
+               }
+
+               if (fire) fTransport->Write_CallBack(do_Ok);
+            }
+
+            return nullptr;
+         }
+   };
+
+}
 
 dabc::InputTransport::InputTransport(dabc::Command cmd, const PortRef& inpport, DataInput* inp, bool owner) :
    dabc::Transport(cmd, inpport, 0),
@@ -581,7 +741,8 @@ dabc::OutputTransport::OutputTransport(dabc::Command cmd, const PortRef& outport
    fOutState(outReady),
    fCurrentBuf(),
    fStopRequested(false),
-   fRetryPeriod(-1.)
+   fRetryPeriod(-1.),
+   fWriter(nullptr)
 {
    SetDataOutput(out, owner);
 
@@ -589,6 +750,15 @@ dabc::OutputTransport::OutputTransport(dabc::Command cmd, const PortRef& outport
 
    fRetryPeriod = outport.Cfg("retry", cmd).AsDouble(-1);
 
+   // number of buffers, which can be written by separate thread
+   unsigned async = outport.Cfg("async", cmd).AsUInt(0);
+   if ((async > 0) && fOutput) {
+      if (fOutput->Write_GetAddon())
+         EOUT("Output with addon cannot be used in async mode");
+      else
+         fWriter = new OutputAsyncWriter(this, fOutput, async);
+   }
+
    if (!fTransportInfoName.empty() && fOutput)
       fOutput->SetInfoParName(fTransportInfoName);
 
@@ -624,6 +794,10 @@ void dabc::OutputTransport::SetDataOutput(DataOutput* out, bool owner)
 
 void dabc::OutputTransport::CloseOutput()
 {
+   // writer completes all submitted buffers before output is deleted
+   delete fWriter;
+   fWriter = nullptr;
+
    if ((fOutput!=0) && fOutputOwner)
       delete fOutput;
 
@@ -690,7 +864,13 @@ void dabc::OutputTransport::TransportCleanup()
 
 void dabc::OutputTransport::CloseOnError()
 {
-   if ((fRetryPeriod < 0.) || !fOutput || !fOutput->Write_Retry()) {
+   bool retry = false;
+   if ((fRetryPeriod >= 0.) && fOutput) {
+      LockGuard lock(fWriter ? &fWriter->fOutMutex : nullptr);
+      retry = fOutput->Write_Retry();
+   }
+
+   if (!retry) {
       ChangeState(outClosed);
       CloseOutput();
       CloseTransport(true);
@@ -752,6 +932,9 @@ bool dabc::OutputTransport::ProcessRecv(unsigned port)
       return false;
    }
 
+   if (fWriter && ((fOutState == outReady) || (fOutState == outClosing)))
+      return ProcessAsyncRecv(port);
+
    if (fOutState == outReady) {
 
       unsigned ret(do_Ok);
@@ -888,15 +1071,70 @@ bool dabc::OutputTransport::ProcessRecv(unsigned port)
    return true;
 }
 
+bool dabc::OutputTransport::ProcessAsyncRecv(unsigned port)
+{
+   if (fOutState == outReady) {
+      bool iseof = RecvQueueItem(port,0).GetTypeId() == dabc::mbt_EOF;
+
+      // before close all submitted buffers must be written
+      unsigned ret = fWriter->Check(iseof);
+
+      switch (ret) {
+         case do_Ok:
+            if (iseof) {
+               DOUT0("EOF - close output transport");
+               Recv(port).Release();
+               ChangeState(outClosing);
+            } else {
+               Buffer buf = Recv(port);
+               fWriter->Submit(buf);
+            }
+            break;
+         case do_CallBack:
+            ChangeState(outWaitCallback);
+            return false;
+         case do_Close:
+            ChangeState(outClosing);
+            break;
+         default:
+            DOUT0("Error when writing buffer in transport %s", GetName());
+            ChangeState(outError);
+      }
+   }
+
+   if (fOutState == outClosing) {
+      ChangeState(outClosed);
+      CloseOutput();
+      CloseTransport(false);
+      return false;
+   }
+
+   if (fOutState == outError) {
+      CloseOnError();
+      return false;
+   }
+
+   // do not block transport thread when writer is busy
+   if (fOutput && InfoExpected() && fWriter->fOutMutex.TryLock()) {
+      std::string info = fOutput->ProvideInfo();
+      fWriter->fOutMutex.Unlock();
+      ProvideInfo(0, info);
+   }
+
+   return true;
+}
+
 void dabc::OutputTransport::ProcessTimerEvent(unsigned)
 {
    if (fOutState == outInitTimeout)
       ChangeState(outReady);
 
    if (fOutState == outRetry) {
-      if (fOutput && fOutput->Write_Init())
+      LockGuard lock(fWriter ? &fWriter->fOutMutex : nullptr);
+      if (fOutput && fOutput->Write_Init()) {
+         if (fWriter) fWriter->ResetStatus();
          ChangeState(outReady);
-      else {
+      } else {
          ShootTimer("SysTimer", fRetryPeriod);
          return;
       }
@@ -910,9 +1148,16 @@ int dabc::OutputTransport::ExecuteCommand(dabc::Command cmd)
    if (cmd.IsName("GetTransportStatistic")) {
       // take statistic from output element
       cmd.SetStr("OutputState", StateAsStr());
+      LockGuard lock(fWriter ? &fWriter->fOutMutex : nullptr);
+      if (fWriter) {
+         LockGuard guard(fWriter->fMutex);
+         cmd.SetUInt("AsyncInFlight", fWriter->fInFlight);
+         cmd.SetUInt("AsyncMaxInFlight", fWriter->fMaxInFlight);
+      }
       if (fOutput) fOutput->Write_Stat(cmd);
       return cmd_true;
    } else if (cmd.IsName("RestartTransport")) {
+      LockGuard lock(fWriter ? &fWriter->fOutMutex : nullptr);
       bool res = fOutput ? fOutput->Write_Restart(cmd) : false;
       return cmd_bool(res);
    }
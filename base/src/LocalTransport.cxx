@@ -18,10 +18,11 @@
 #include "dabc/MemoryPool.h"
 
 
-dabc::LocalTransport::LocalTransport(unsigned capacity, bool withmutex) :
+dabc::LocalTransport::LocalTransport(unsigned capacity, bool withmutex, bool lockfree) :
     dabc::Object("queue"),
-    fQueue(capacity),
-    fWithMutex(withmutex),
+    fQueue(lockfree ? 0 : capacity),
+    fRing(lockfree ? new BuffersRing(capacity) : nullptr),
+    fWithMutex(withmutex || lockfree),
     fOut(),
     fOutId(0),
     fOutSignKind(0),
@@ -36,7 +37,7 @@ dabc::LocalTransport::LocalTransport(unsigned capacity, bool withmutex) :
 {
    SetFlag(flAutoDestroy, true);
 
-   DOUT3("Create buffers queue %p", this);
+   DOUT3("Create buffers queue %p lockfree %s", this, DBOOL(fRing));
 }
 
 dabc::LocalTransport::~LocalTransport()
@@ -44,12 +45,15 @@ dabc::LocalTransport::~LocalTransport()
 //   DOUT3("Destroy dabc::LocalTransport %p size %u", this, fQueue.Size());
 
    if (fConnected!=0)
-      EOUT("Queue was not correctly disconnected %u", fConnected);
+      EOUT("Queue was not correctly disconnected %u", fConnected.load());
 
-   if (fQueue.Size() != 0) {
+   if (Size() != 0) {
       // EOUT("!!! QUEUE WAS NOT cleaned up");
       CleanupQueue();
    }
+
+   delete fRing;
+   fRing = nullptr;
 }
 
 
@@ -62,6 +66,8 @@ bool dabc::LocalTransport::Send(Buffer& buf)
 
    if (buf.null()) return true;
 
+   if (fRing) return SendLockFree(buf);
+
 //   DOUT0("Local transport %p send buffer %u", this, (unsigned) buf.SegmentId(0));
 
 
@@ -140,6 +146,8 @@ bool dabc::LocalTransport::Send(Buffer& buf)
 
 bool dabc::LocalTransport::Recv(Buffer& buf)
 {
+   if (fRing) return RecvLockFree(buf);
+
    dabc::WorkerRef mdl;
    unsigned id(0);
 
@@ -199,6 +207,26 @@ void dabc::LocalTransport::SignalWhenFull()
    dabc::WorkerRef mdl;
    unsigned id(0), evnt(0);
 
+   if (fRing) {
+      // only input port calls the method, therefore no need to lock mutex for queue itself
+      if (fRing->Full()) {
+         evnt = evntInput;
+      } else {
+         unsigned expected = 2;
+         fSignalInp.compare_exchange_strong(expected, 3);
+         if (SwitchSignal(fSignalOut, fOutSignKind)) evnt = evntOutput;
+      }
+
+      if (evnt) {
+         dabc::LockGuard lock(QueueMutex());
+         mdl = (evnt == evntInput) ? fInp : fOut;
+         id = (evnt == evntInput) ? fInpId : fOutId;
+      }
+
+      mdl.FireEvent(evnt, id);
+      return;
+   }
+
    {
       dabc::LockGuard lock(QueueMutex());
 
@@ -249,6 +277,10 @@ void dabc::LocalTransport::ConfirmEvent(bool fromoutputport)
 {
    // method only called by ports, which are configured as Port::SignalConfirm
 
+   if (fRing) {
+      ConfirmLockFree(fromoutputport);
+      return;
+   }
 
    dabc::LockGuard lock(QueueMutex());
 
@@ -304,7 +336,7 @@ void dabc::LocalTransport::Disconnect(bool isinp, bool witherr)
       if (fConnected == 0) cleanup = true;
    }
 
-   DOUT3("Queue %p disconnected witherr %s isinp %s conn %u m1:%s m2:%s", this, DBOOL(witherr), DBOOL(isinp), fConnected, m1.GetName(), m2.GetName());
+   DOUT3("Queue %p disconnected witherr %s isinp %s conn %u m1:%s m2:%s", this, DBOOL(witherr), DBOOL(isinp), fConnected.load(), m1.GetName(), m2.GetName());
 
    if (!isinp) m1.FireEvent(witherr ? evntPortError : evntPortDisconnect, id1);
 
@@ -323,7 +355,131 @@ void dabc::LocalTransport::Disconnect(bool isinp, bool witherr)
 
 void dabc::LocalTransport::CleanupQueue()
 {
-   fQueue.Cleanup(QueueMutex());
+   // ring cleaned only when no any port is connected
+   if (fRing)
+      fRing->Cleanup();
+   else
+      fQueue.Cleanup(QueueMutex());
+}
+
+bool dabc::LocalTransport::SwitchSignal(std::atomic<unsigned> &sig, int kind)
+{
+   unsigned expected = 3;
+
+   switch (kind) {
+      case Port::SignalNone: return false;
+      case Port::SignalConfirm: return sig.compare_exchange_strong(expected, 1);
+      case Port::SignalOperation: return sig.compare_exchange_strong(expected, 2);
+      case Port::SignalEvery: return true;
+   }
+
+   return false;
+}
+
+bool dabc::LocalTransport::SendLockFree(Buffer& buf)
+{
+   // only output port thread calls the method, buffer and signaling states are changed without mutex
+   // mutex only used to access references on the modules, which could be changed by disconnect
+
+   if (buf.NumReferences() > 1)
+      EOUT("Buffer ref cnt %d bigger than 1, which means extra buffer instance inside thread", buf.NumReferences());
+
+   dabc::Buffer skipbuf;
+
+   if (!fRing->PushBuffer(buf)) {
+      dabc::LockGuard lock(QueueMutex());
+
+      // oldest buffer can be skipped only when input port not connected,
+      // input port sets connected flag under same mutex, therefore no concurrent read is possible
+      if (!(fConnected & MaskInp) && !fBlockWhenUnconnected)
+         fRing->PopBuffer(skipbuf);
+
+      if (!fRing->PushBuffer(buf))
+         EOUT("Not able to push buffer into the %s -> %s lock-free queue, skipped: %s, size: %u %u, connected: %s",
+               fOut.ItemName().c_str(), fInp.ItemName().c_str(), DBOOL(!skipbuf.null()), fRing->Size(), fRing->Capacity(),
+               DBOOL(fConnected == MaskConn));
+   }
+
+   if (!buf.null()) { EOUT("Something went wrong - buffer is not null here"); exit(3); }
+
+   skipbuf.Release();
+
+   unsigned expected = 2;
+   fSignalOut.compare_exchange_strong(expected, 3); // mark that output operation done
+
+   // only if input port still connected, deliver events to it
+   if (!(fConnected & MaskInp) || !SwitchSignal(fSignalInp, fInpSignKind)) return true;
+
+   dabc::WorkerRef mdl;
+   unsigned id(0);
+
+   {
+      dabc::LockGuard lock(QueueMutex());
+      mdl = fInp;
+      id = fInpId;
+   }
+
+   mdl.FireEvent(evntInput, id);
+
+   return true;
+}
+
+bool dabc::LocalTransport::RecvLockFree(Buffer& buf)
+{
+   // only input port thread calls the method
+
+   if (!buf.null()) { EOUT("AAAAAAAAAA"); exit(432); }
+
+   fRing->PopBuffer(buf);
+
+   unsigned expected = 2;
+   fSignalInp.compare_exchange_strong(expected, 3);
+
+   // signal output event only if sender did something after previous event
+   if (!SwitchSignal(fSignalOut, fOutSignKind)) return true;
+
+   dabc::WorkerRef mdl;
+   unsigned id(0);
+
+   {
+      dabc::LockGuard lock(QueueMutex());
+      mdl = fOut;
+      id = fOutId;
+   }
+
+   mdl.FireEvent(evntOutput, id);
+
+   return true;
+}
+
+void dabc::LocalTransport::ConfirmLockFree(bool fromoutputport)
+{
+   // Same logic as in ConfirmEvent, but other side can change queue after Full() or Empty() check.
+   // In such case other side may not see signal state 3 and will not produce event.
+   // Therefore queue checked again after state is changed and event produced by ourself
+
+   dabc::WorkerRef mdl;
+   unsigned id(0), evnt(0);
+
+   if (fromoutputport) {
+      fSignalOut = fRing->Full() ? 3 : 2;
+      if ((fSignalOut == 3) && !fRing->Full() && SwitchSignal(fSignalOut, Port::SignalConfirm))
+         evnt = evntOutput;
+   } else {
+      fSignalInp = fRing->Empty() ? 3 : 2;
+      if ((fSignalInp == 3) && !fRing->Empty() && SwitchSignal(fSignalInp, Port::SignalConfirm))
+         evnt = evntInput;
+   }
+
+   if (!evnt) return;
+
+   {
+      dabc::LockGuard lock(QueueMutex());
+      mdl = fromoutputport ? fOut : fInp;
+      id = fromoutputport ? fOutId : fInpId;
+   }
+
+   mdl.FireEvent(evnt, id);
 }
 
 
@@ -359,6 +515,9 @@ int dabc::LocalTransport::ConnectPorts(Reference port1ref, Reference port2ref, C
    std::string blocking = port_out.Cfg("blocking", cmd).AsStr();
    if (blocking.empty()) blocking = port_inp.Cfg("blocking").AsStr("connected");
 
+   // lock-free ring can be disabled for any of the ports
+   bool lockfree = port_out.Cfg("lockfree", cmd).AsBool(true) && port_inp.Cfg("lockfree").AsBool(true);
+
    DOUT2("Connect ports %s -> %s", port_out.ItemName().c_str(), port_inp.ItemName().c_str());
 
    ModuleRef m1 = port_out.GetModule();
@@ -380,6 +539,9 @@ int dabc::LocalTransport::ConnectPorts(Reference port1ref, Reference port2ref, C
       withmutex = false;
    }
 
+   // ring does not allow to skip buffers when both ports are connected
+   if (!withmutex || (blocking == "disconnected") || (blocking == "never")) lockfree = false;
+
    unsigned queuesize = port_out.QueueCapacity() > port_inp.QueueCapacity() ?
          port_out.QueueCapacity() : port_inp.QueueCapacity();
 
@@ -398,7 +560,7 @@ int dabc::LocalTransport::ConnectPorts(Reference port1ref, Reference port2ref, C
       assign_inp = false;
       DOUT3("REUSE queue of input port %s", port_inp.ItemName().c_str());
    } else {
-      q = new LocalTransport(queuesize, withmutex);
+      q = new LocalTransport(queuesize, withmutex, lockfree);
    }
 
    if (blocking == "disconnected") {
@@ -418,6 +580,12 @@ int dabc::LocalTransport::ConnectPorts(Reference port1ref, Reference port2ref, C
       q()->fBlockWhenConnected = true;
    }
 
+   // reused ring cannot be switched into non-blocking mode
+   if (q()->fRing && !q()->fBlockWhenConnected) {
+      DOUT0("Queue %s -> %s is lock-free and always blocks when connected", port_out.ItemName().c_str(), port_inp.ItemName().c_str());
+      q()->fBlockWhenConnected = true;
+   }
+
    if (assign_inp) {
       q()->fInp = m2;
       q()->fInpId = port_inp.ItemId();
@@ -419,7 +419,7 @@ void dabc::Manager::HaltManager()
 
    dabc::Object::InspectGarbageCollector();
 
-   DOUT3("dabc::Manager::HaltManager done refcnt = %u", fObjectRefCnt);
+   DOUT3("dabc::Manager::HaltManager done refcnt = %u", fObjectRefCnt.load());
 }
 
 bool dabc::Manager::ProcessDestroyQueue()
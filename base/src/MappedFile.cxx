@@ -0,0 +1,166 @@
+// $Id$
+
+/************************************************************
+ * The Data Acquisition Backbone Core (DABC)                *
+ ************************************************************
+ * Copyright (C) 2009 -                                     *
+ * GSI Helmholtzzentrum fuer Schwerionenforschung GmbH      *
+ * Planckstr. 1, 64291 Darmstadt, Germany                   *
+ * Contact:  http://dabc.gsi.de                             *
+ ************************************************************
+ * This software can be used under the GPL license          *
+ * agreements as stated in LICENSE.txt file                 *
+ * which is part of the distribution.                       *
+ ************************************************************/
+
+#include "dabc/MappedFile.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+
+#include "dabc/logging.h"
+
+namespace dabc {
+
+   /** Helper class to keep mapped file window
+    * Object will be deleted (and memory unmapped) when last reference in buffer disappear */
+   class MappedWindow : public Object {
+      public:
+
+         void*  fPtr;
+         size_t fLen;
+
+         MappedWindow(void *ptr, size_t len) :
+            Object(nullptr, "", flAutoDestroy),
+            fPtr(ptr),
+            fLen(len)
+         {
+         }
+
+         virtual ~MappedWindow()
+         {
+            if (fPtr) { munmap(fPtr, fLen); fPtr = nullptr; }
+         }
+   };
+}
+
+
+dabc::MappedFile::MappedFile() :
+   fFd(-1),
+   fFileSize(0),
+   fWindowSize(0),
+   fWindow(),
+   fWindowPtr(nullptr),
+   fWindowPos(0),
+   fWindowLen(0),
+   fPos(0),
+   fNumWindows(0)
+{
+}
+
+bool dabc::MappedFile::Open(const char* fname, uint64_t window)
+{
+   Close();
+
+   if (!fname || !*fname) return false;
+
+   fFd = open(fname, O_RDONLY);
+   if (fFd < 0) {
+      EOUT("Cannot open file %s for reading: %s", fname, strerror(errno));
+      return false;
+   }
+
+   struct stat st;
+   if (fstat(fFd, &st) != 0) {
+      EOUT("Cannot get size of file %s: %s", fname, strerror(errno));
+      Close();
+      return false;
+   }
+
+   uint64_t pagesize = sysconf(_SC_PAGESIZE);
+
+   fFileSize = st.st_size;
+   fWindowSize = (window + pagesize - 1) / pagesize * pagesize;
+   if (fWindowSize < pagesize) fWindowSize = pagesize;
+
+#if defined(__linux__)
+   posix_fadvise(fFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+   return true;
+}
+
+void dabc::MappedFile::Close()
+{
+   // buffers, delivered to the consumers, still keep their windows mapped
+   fWindow.Release();
+   fWindowPtr = nullptr;
+   fWindowPos = fWindowLen = fPos = 0;
+
+   if (fFd >= 0) { close(fFd); fFd = -1; }
+   fFileSize = 0;
+}
+
+bool dabc::MappedFile::MapWindow(uint64_t len)
+{
+   uint64_t pagesize = sysconf(_SC_PAGESIZE);
+
+   // window always starts at page boundary before current position
+   uint64_t pos = fPos / pagesize * pagesize;
+
+   // window enlarged when requested portion does not fit into it
+   while (fWindowSize < fPos - pos + len) fWindowSize *= 2;
+
+   uint64_t maplen = fWindowSize;
+   if (pos + maplen > fFileSize) maplen = fFileSize - pos;
+
+   // mapping is private to let consumers modify data in place (copy-on-write)
+   void* ptr = mmap(nullptr, maplen, PROT_READ | PROT_WRITE, MAP_PRIVATE, fFd, pos);
+   if (ptr == MAP_FAILED) {
+      EOUT("Fail to map %lu bytes of file at offset %lu: %s", (long unsigned) maplen, (long unsigned) pos, strerror(errno));
+      return false;
+   }
+
+#if defined(__linux__)
+   madvise(ptr, maplen, MADV_SEQUENTIAL);
+   madvise(ptr, maplen, MADV_WILLNEED);
+   // start reading of the next window while current is processed
+   if (pos + maplen < fFileSize)
+      posix_fadvise(fFd, pos + maplen, fWindowSize, POSIX_FADV_WILLNEED);
+#endif
+
+   // previous window will be unmapped when last buffer is released
+   fWindow = new MappedWindow(ptr, maplen);
+   fWindowPtr = (char*) ptr;
+   fWindowPos = pos;
+   fWindowLen = maplen;
+   fNumWindows++;
+
+   return true;
+}
+
+const char* dabc::MappedFile::Map(uint64_t len)
+{
+   if (!isOpened() || (fPos + len > fFileSize)) return nullptr;
+
+   if ((fWindowLen == 0) || (fPos + len > fWindowPos + fWindowLen))
+      if (!MapWindow(len)) return nullptr;
+
+   return fWindowPtr + (fPos - fWindowPos);
+}
+
+dabc::Buffer dabc::MappedFile::Take(uint64_t len)
+{
+   dabc::Buffer res;
+
+   if ((fWindowLen == 0) || (fPos + len > fWindowPos + fWindowLen)) return res;
+
+   res = dabc::Buffer::CreateBuffer(fWindowPtr + (fPos - fWindowPos), len, fWindow);
+   fPos += len;
+
+   return res;
+}
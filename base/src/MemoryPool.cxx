@@ -16,6 +16,14 @@
 #include "dabc/MemoryPool.h"
 
 #include <cstdlib>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
 
 #include "dabc/defines.h"
 
@@ -23,6 +31,58 @@ namespace dabc {
 
    enum  { evntProcessRequests = evntModuleLast };
 
+   /** Per-thread cache of free buffers indexes.
+    * Normally accessed only by owner thread, other threads lock it when collecting all free buffers */
+   struct MemoryMagazine {
+      Mutex                 fMutex;     ///< mutex, almost never contended
+      std::vector<unsigned> fIds;       ///< cached indexes
+      unsigned              fNum;       ///< number of cached indexes
+      std::atomic<uint64_t> fHits;      ///< buffers taken from cache
+      std::atomic<uint64_t> fMisses;    ///< cache refilled from the pool
+      std::atomic<uint64_t> fFlushes;   ///< part of cache returned to the pool
+      char                  fPad[64];   ///< avoid sharing cache line with other thread
+
+      MemoryMagazine(unsigned size) : fMutex(), fIds(size), fNum(0), fHits(0), fMisses(0), fFlushes(0) {}
+
+      /** Increment counter, only done under magazine mutex */
+      static void Inc(std::atomic<uint64_t> &cnt) { cnt.store(cnt.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+   };
+
+   static Mutex gMagazinesMutex;              ///< protects list of free magazines indexes
+   static std::vector<unsigned> gMagazinesFree; ///< indexes released by finished threads
+   static unsigned gMagazinesCounter = 0;       ///< number of assigned indexes
+
+   /** Index of current thread in the magazines list of any pool.
+    * When thread exits, index is returned to the free list and reused by other thread
+    * together with its magazines - they are just caches of free buffers */
+   struct MagazineId {
+      unsigned fId;
+
+      MagazineId() : fId((unsigned) -1) {}
+
+      ~MagazineId()
+      {
+         if (fId == (unsigned) -1) return;
+         LockGuard lock(gMagazinesMutex);
+         gMagazinesFree.push_back(fId);
+      }
+
+      unsigned Get()
+      {
+         if (fId != (unsigned) -1) return fId;
+         LockGuard lock(gMagazinesMutex);
+         if (!gMagazinesFree.empty()) {
+            fId = gMagazinesFree.back();
+            gMagazinesFree.pop_back();
+         } else {
+            fId = gMagazinesCounter++;
+         }
+         return fId;
+      }
+   };
+
+   static thread_local MagazineId gMagazineId;
+
 
    class MemoryBlock {
       public:
@@ -31,19 +91,49 @@ namespace dabc {
             void         *buf;     ///< pointer on raw memory
             BufferSize_t  size;    ///< size of the block
             bool          owner;   ///< is memory should be released
-            int           refcnt;  ///< usage counter - number of references on the memory
+            unsigned      cls;     ///< size class of the buffer
+            std::atomic<int> refcnt;  ///< usage counter - number of references on the memory
          };
 
          typedef Queue<unsigned, false> FreeQueue;
 
-         Entry*    fArr;       ///< array of buffers
-         unsigned  fNumber;    ///< number of buffers
-         FreeQueue fFree;      ///< list of free buffers
+         /** Buffers of same size, classes are sorted by increasing buffer size */
+         struct SizeClass {
+            BufferSize_t size;      ///< buffers size
+            unsigned     number;    ///< number of buffers
+            FreeQueue    free;      ///< list of free buffers
+            uint64_t     taken;     ///< number of buffers taken from the class
+            uint64_t     fallback;  ///< number of requests, served by other classes while class was empty
+
+            SizeClass() : size(0), number(0), free(), taken(0), fallback(0) {}
+         };
+
+         enum { MaxMagazines = 256 };
+
+         Entry*     fArr;        ///< array of buffers
+         unsigned   fNumber;     ///< number of buffers
+         SizeClass* fClasses;    ///< size classes
+         unsigned   fNumClasses; ///< number of size classes
+
+         unsigned  fCacheSize; ///< capacity of each per-thread cache
+         std::atomic<MemoryMagazine*>* fMags; ///< per-thread caches, each created by its thread
+
+         void*       fRegion;     ///< single memory region for all buffers
+         size_t      fRegionSize; ///< size of memory region
+         std::string fMemMode;    ///< how memory was allocated
+         int         fNumaNode;   ///< NUMA node where memory bound, -1 if not bound
 
          MemoryBlock() :
             fArr(0),
             fNumber(0),
-            fFree()
+            fClasses(nullptr),
+            fNumClasses(0),
+            fCacheSize(0),
+            fMags(nullptr),
+            fRegion(nullptr),
+            fRegionSize(0),
+            fMemMode("malloc"),
+            fNumaNode(-1)
          {
          }
 
@@ -52,7 +142,75 @@ namespace dabc {
             Release();
          }
 
-         inline bool IsAnyFree() const { return !fFree.Empty(); }
+         void EnableCache(unsigned size)
+         {
+            fCacheSize = size;
+            fMags = new std::atomic<MemoryMagazine*>[MaxMagazines];
+            for (unsigned n = 0; n < MaxMagazines; n++)
+               fMags[n].store(nullptr);
+         }
+
+         /** Returns cache of current thread, creates it when necessary */
+         MemoryMagazine* GetMagazine()
+         {
+            if (!fMags) return nullptr;
+
+            unsigned id = gMagazineId.Get();
+            if (id >= MaxMagazines) {
+               static std::atomic<bool> reported(false);
+               if (!reported.exchange(true))
+                  EOUT("More than %d threads use memory pools simultaneously, thread caches disabled for others", (int) MaxMagazines);
+               return nullptr;
+            }
+
+            MemoryMagazine* mag = fMags[id].load(std::memory_order_acquire);
+            if (!mag) {
+               // only thread which owns the index creates the magazine
+               mag = new MemoryMagazine(fCacheSize);
+               fMags[id].store(mag, std::memory_order_release);
+            }
+            return mag;
+         }
+
+         inline bool IsAnyFree() const
+         {
+            for (unsigned n = 0; n < fNumClasses; n++)
+               if (!fClasses[n].free.Empty()) return true;
+            return false;
+         }
+
+         inline unsigned NumFree() const
+         {
+            unsigned sum = 0;
+            for (unsigned n = 0; n < fNumClasses; n++)
+               sum += fClasses[n].free.Size();
+            return sum;
+         }
+
+         /** Return buffer to the free list of its class */
+         inline void PushFree(unsigned id) { fClasses[fArr[id].cls].free.Push(id); }
+
+         /** Take free buffer from the largest class which has free buffers, returns -1 if none */
+         int PopAnyFree()
+         {
+            for (unsigned n = fNumClasses; n-- > 0; )
+               if (!fClasses[n].free.Empty()) return fClasses[n].free.Pop();
+            return -1;
+         }
+
+         /** Returns smallest class which has free buffer of at least specified size, -1 if none */
+         int FindClass(BufferSize_t size)
+         {
+            bool first = true;
+            for (unsigned n = 0; n < fNumClasses; n++) {
+               if (fClasses[n].size < size) continue;
+               if (!fClasses[n].free.Empty()) return n;
+               // best fitting class is empty, other class will be used
+               if (first) fClasses[n].fallback++;
+               first = false;
+            }
+            return -1;
+         }
 
          void Release()
          {
@@ -70,22 +228,145 @@ namespace dabc {
             fArr = nullptr;
             fNumber = 0;
 
-            fFree.Reset();
+            delete [] fClasses;
+            fClasses = nullptr;
+            fNumClasses = 0;
+
+#if defined(__linux__)
+            if (fRegion) munmap(fRegion, fRegionSize);
+#endif
+            fRegion = nullptr;
+            fRegionSize = 0;
+
+            if (fMags) {
+               for (unsigned n = 0; n < MaxMagazines; n++)
+                  delete fMags[n].load();
+               delete [] fMags;
+               fMags = nullptr;
+            }
+         }
+
+         /** Create entries and classes, sizes must be sorted and unique */
+         void CreateClasses(const std::vector<BufferSize_t> &sizes, const std::vector<unsigned> &numbers)
+         {
+            fNumClasses = sizes.size();
+            fClasses = new SizeClass[fNumClasses];
+
+            fNumber = 0;
+            for (unsigned n = 0; n < fNumClasses; n++) {
+               fClasses[n].size = sizes[n];
+               fClasses[n].number = numbers[n];
+               fClasses[n].free.Allocate(numbers[n]);
+               fNumber += numbers[n];
+            }
+
+            fArr = new Entry[fNumber];
+
+            unsigned id = 0;
+            for (unsigned n = 0; n < fNumClasses; n++)
+               for (unsigned k = 0; k < numbers[n]; k++, id++) {
+                  fArr[id].buf = nullptr;
+                  fArr[id].size = sizes[n];
+                  fArr[id].owner = false;
+                  fArr[id].cls = n;
+                  fArr[id].refcnt = 0;
+               }
          }
 
-         bool Allocate(unsigned number, unsigned size, unsigned align)
+         /** Allocate all buffers as one region, optionally with huge pages and bound to NUMA node
+          * \param hugepage - huge page size in bytes, 0 - normal pages
+          * \param numanode - NUMA node, -1 - no binding, -2 - node of current CPU */
+         bool AllocateRegion(const std::vector<BufferSize_t> &sizes, const std::vector<unsigned> &numbers, unsigned align, size_t hugepage, int numanode)
          {
+#if defined(__linux__)
             Release();
 
-            fArr = new Entry[number];
-            fNumber = number;
+            if (align < 16) align = 16;
+            size_t fullsize = 0;
+            for (unsigned n = 0; n < sizes.size(); n++)
+               fullsize += (sizes[n] + align - 1) / align * align * numbers[n];
+
+            size_t pagesize = hugepage ? hugepage : (size_t) sysconf(_SC_PAGESIZE);
+            size_t total = (fullsize + pagesize - 1) / pagesize * pagesize;
+
+            void* region = MAP_FAILED;
+
+            if (hugepage) {
+               int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+               int shift = 0;
+               while ((((size_t) 1) << shift) < hugepage) shift++;
+               flags |= (shift << MAP_HUGE_SHIFT);
+#endif
+               region = mmap(nullptr, total, PROT_READ | PROT_WRITE, flags, -1, 0);
+               if (region != MAP_FAILED)
+                  fMemMode = dabc::format("hugetlb %s", dabc::size_to_str(hugepage).c_str());
+               else
+                  DOUT0("Cannot get %s huge pages for %s pool, use transparent huge pages", dabc::size_to_str(hugepage).c_str(), dabc::size_to_str(total).c_str());
+            }
+
+            if (region == MAP_FAILED) {
+               // normal pages, transparent huge pages when requested
+               if (hugepage) total = (fullsize + 4096 - 1) / 4096 * 4096;
+               region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+               if (region == MAP_FAILED) {
+                  EOUT("Cannot map %s for Memory Block", dabc::size_to_str(total).c_str());
+                  throw dabc::Exception(ex_Pool, "Cannot allocate memory region", "MemBlock");
+                  return false;
+               }
+               fMemMode = "region";
+#ifdef MADV_HUGEPAGE
+               if (hugepage && (madvise(region, total, MADV_HUGEPAGE) == 0)) fMemMode = "thp";
+#endif
+            }
+
+            fRegion = region;
+            fRegionSize = total;
+
+            if (numanode == -2) {
+               unsigned cpu = 0, node = 0;
+               if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) numanode = node;
+                                                                else numanode = -1;
+            }
+
+            if (numanode >= 0) {
+               unsigned long mask[4] = { 0, 0, 0, 0 };
+               if (numanode < (int) (sizeof(mask)*8)) {
+                  mask[numanode / (sizeof(unsigned long)*8)] |= 1UL << (numanode % (sizeof(unsigned long)*8));
+                  // memory not yet touched, therefore policy applies to all pages
+                  if (syscall(SYS_mbind, region, total, MPOL_BIND, mask, sizeof(mask)*8, 0) == 0)
+                     fNumaNode = numanode;
+                  else
+                     EOUT("Cannot bind memory pool to NUMA node %d", numanode);
+               }
+            }
+
+            CreateClasses(sizes, numbers);
 
-            fFree.Allocate(number);
+            char* ptr = (char*) region;
+            for (unsigned n=0;n<fNumber;n++) {
+               fArr[n].buf = ptr;
+               ptr += (fArr[n].size + align - 1) / align * align;
+               fClasses[fArr[n].cls].free.Push(n);
+            }
+
+            return true;
+#else
+            (void) hugepage; (void) numanode;
+            return Allocate(sizes, numbers, align);
+#endif
+         }
+
+         bool Allocate(const std::vector<BufferSize_t> &sizes, const std::vector<unsigned> &numbers, unsigned align)
+         {
+            Release();
+
+            CreateClasses(sizes, numbers);
 
             for (unsigned n=0;n<fNumber;n++) {
 
                void* buf(0);
-               int res = posix_memalign(&buf, align, size);
+               int res = posix_memalign(&buf, align, fArr[n].size);
 
                if ((res!=0) || (buf==0)) {
                   EOUT("Cannot allocate data for new Memory Block");
@@ -94,11 +375,9 @@ namespace dabc {
                }
 
                fArr[n].buf = buf;
-               fArr[n].size = size;
                fArr[n].owner = true;
-               fArr[n].refcnt = 0;
 
-               fFree.Push(n);
+               fClasses[fArr[n].cls].free.Push(n);
             }
 
             return true;
@@ -108,18 +387,32 @@ namespace dabc {
          {
             Release();
 
+            // each distinct buffer size forms its own class
+            std::vector<BufferSize_t> clsizes;
+            for (unsigned n=0;n<sizes.size();n++)
+               clsizes.push_back(sizes[n]);
+            std::sort(clsizes.begin(), clsizes.end());
+            clsizes.erase(std::unique(clsizes.begin(), clsizes.end()), clsizes.end());
+
+            fNumClasses = clsizes.size();
+            fClasses = new SizeClass[fNumClasses];
+            for (unsigned n = 0; n < fNumClasses; n++) {
+               fClasses[n].size = clsizes[n];
+               fClasses[n].free.Allocate(bufs.size());
+            }
+
             fArr = new Entry[bufs.size()];
             fNumber = bufs.size();
 
-            fFree.Allocate(bufs.size());
-
             for (unsigned n=0;n<fNumber;n++) {
                fArr[n].buf = bufs[n];
                fArr[n].size = sizes[n];
                fArr[n].owner = isowner;
+               fArr[n].cls = std::lower_bound(clsizes.begin(), clsizes.end(), (BufferSize_t) sizes[n]) - clsizes.begin();
                fArr[n].refcnt = 0;
 
-               fFree.Push(n);
+               fClasses[fArr[n].cls].number++;
+               fClasses[fArr[n].cls].free.Push(n);
             }
             return true;
          }
@@ -138,6 +431,13 @@ dabc::MemoryPool::MemoryPool(const std::string &name, bool withmanager) :
    dabc::ModuleAsync(std::string(withmanager ? "" : "#") + name),
    fMem(0),
    fAlignment(fDfltAlignment),
+   fCacheSize(0),
+   fCacheMem(nullptr),
+   fCacheReclaims(0),
+   fHugePageSize(0),
+   fNumaNode(-1),
+   fClassSizes(),
+   fClassNumbers(),
    fReqests(),
    fPending(16),  // size 16 is preliminary and always can be extended
    fEvntFired(false),
@@ -178,6 +478,32 @@ bool dabc::MemoryPool::SetAlignment(unsigned align)
 }
 
 
+bool dabc::MemoryPool::SetThreadCache(unsigned size)
+{
+   LockGuard lock(ObjectMutex());
+   if (fMem!=0) return false;
+   fCacheSize = size;
+   return true;
+}
+
+bool dabc::MemoryPool::SetMemoryPlacement(uint64_t hugepage, int numanode)
+{
+   LockGuard lock(ObjectMutex());
+   if (fMem!=0) return false;
+   fHugePageSize = hugepage;
+   fNumaNode = numanode;
+   return true;
+}
+
+bool dabc::MemoryPool::AddSizeClass(BufferSize_t bufsize, unsigned number)
+{
+   LockGuard lock(ObjectMutex());
+   if ((fMem!=0) || (bufsize*number==0)) return false;
+   fClassSizes.push_back(bufsize);
+   fClassNumbers.push_back(number);
+   return true;
+}
+
 unsigned dabc::MemoryPool::GetAlignment() const
 {
    LockGuard lock(ObjectMutex());
@@ -188,12 +514,43 @@ bool dabc::MemoryPool::_Allocate(BufferSize_t bufsize, unsigned number) throw()
 {
    if (fMem!=0) return false;
 
-   if (bufsize*number==0) return false;
+   // collect all size classes, sorted by buffer size
+   std::vector<BufferSize_t> sizes;
+   std::vector<unsigned> numbers;
 
-   DOUT3("POOL:%s Create num:%u X size:%u buffers align:%u", GetName(), number, bufsize, fAlignment);
+   if (bufsize*number != 0) {
+      sizes.push_back(bufsize);
+      numbers.push_back(number);
+   }
+
+   for (unsigned n = 0; n < fClassSizes.size(); n++) {
+      unsigned pos = std::lower_bound(sizes.begin(), sizes.end(), fClassSizes[n]) - sizes.begin();
+      if ((pos < sizes.size()) && (sizes[pos] == fClassSizes[n])) {
+         numbers[pos] += fClassNumbers[n];
+      } else {
+         sizes.insert(sizes.begin() + pos, fClassSizes[n]);
+         numbers.insert(numbers.begin() + pos, fClassNumbers[n]);
+      }
+   }
+
+   if (sizes.empty()) return false;
+
+   DOUT3("POOL:%s Create num:%u X size:%u buffers align:%u classes:%u", GetName(), number, bufsize, fAlignment, (unsigned) sizes.size());
 
    fMem = new MemoryBlock;
-   fMem->Allocate(number, bufsize, fAlignment);
+   if ((fHugePageSize > 0) || (fNumaNode != -1))
+      fMem->AllocateRegion(sizes, numbers, fAlignment, fHugePageSize, fNumaNode);
+   else
+      fMem->Allocate(sizes, numbers, fAlignment);
+
+   if ((fHugePageSize > 0) || (fNumaNode != -1))
+      DOUT1("POOL:%s memory mode:%s numa:%d", GetName(), fMem->fMemMode.c_str(), fMem->fNumaNode);
+
+   // caches only used when all buffers have same size
+   if ((fCacheSize > 0) && (fMem->fNumClasses == 1)) {
+      fMem->EnableCache(fCacheSize);
+      fCacheMem.store(fMem, std::memory_order_release);
+   }
 
    fChangeCounter++;
 
@@ -225,6 +582,7 @@ bool dabc::MemoryPool::Release() throw()
    LockGuard lock(ObjectMutex());
 
    if (fMem) {
+      fCacheMem.store(nullptr);
       delete fMem;
       fMem = 0;
       fChangeCounter++;
@@ -319,14 +677,14 @@ bool dabc::MemoryPool::TakeRawBuffer(unsigned& indx)
 {
    LockGuard lock(ObjectMutex());
    if ((fMem==0) || !fMem->IsAnyFree()) return false;
-   indx = fMem->fFree.Pop();
+   indx = fMem->PopAnyFree();
    return true;
 }
 
 void dabc::MemoryPool::ReleaseRawBuffer(unsigned indx)
 {
    LockGuard lock(ObjectMutex());
-   if (fMem) fMem->fFree.Push(indx);
+   if (fMem) fMem->PushFree(indx);
 }
 
 
@@ -349,20 +707,36 @@ dabc::Buffer dabc::MemoryPool::_TakeBuffer(BufferSize_t size, bool except, bool
       return res;
    }
 
-   if ((size==0) && reserve_memory) size = fMem->fArr[fMem->fFree.Front()].size;
+   // largest class with free buffers provides default size
+   int cls = -1;
+   if ((size==0) && reserve_memory)
+      for (cls = fMem->fNumClasses - 1; cls >= 0; cls--)
+         if (!fMem->fClasses[cls].free.Empty()) {
+            size = fMem->fClasses[cls].size;
+            break;
+         }
+
+   // smallest class, which can provide buffer of requested size
+   if ((size > 0) && (cls < 0)) cls = fMem->FindClass(size);
 
    // first check if required size is available
    BufferSize_t sum(0);
    unsigned cnt(0);
-   while (sum<size) {
-      if (cnt>=fMem->fFree.Size()) {
+   if (cls >= 0) {
+      sum = fMem->fClasses[cls].size;
+      cnt = 1;
+   } else {
+      // segmented list is taken from largest classes
+      for (unsigned n = fMem->fNumClasses; (n-- > 0) && (sum < size); ) {
+         MemoryBlock::FreeQueue &free = fMem->fClasses[n].free;
+         for (unsigned k = 0; (k < free.Size()) && (sum < size); k++, cnt++)
+            sum += fMem->fArr[free.Item(k)].size;
+      }
+
+      if (sum < size) {
          if (except) throw dabc::Exception(ex_Pool, "Cannot reserve buffer of requested size", ItemName());
          return res;
       }
-
-      unsigned id = fMem->fFree.Item(cnt);
-      sum += fMem->fArr[id].size;
-      cnt++;
    }
 
    res.AllocateContainer(cnt < 8 ? 8 : cnt);
@@ -371,8 +745,13 @@ dabc::Buffer dabc::MemoryPool::_TakeBuffer(BufferSize_t size, bool except, bool
    cnt = 0;
    MemSegment* segs = res.Segments();
 
+   unsigned pcls = (cls >= 0) ? cls : fMem->fNumClasses - 1;
+
    while (sum<size) {
-      unsigned id = fMem->fFree.Pop();
+      while (fMem->fClasses[pcls].free.Empty()) pcls--;
+
+      unsigned id = fMem->fClasses[pcls].free.Pop();
+      fMem->fClasses[pcls].taken++;
 
       if (fMem->fArr[id].refcnt!=0)
          throw dabc::Exception(ex_Pool, "Buffer is not free even is declared so", ItemName());
@@ -406,10 +785,127 @@ dabc::Buffer dabc::MemoryPool::_TakeBuffer(BufferSize_t size, bool except, bool
 }
 
 
+dabc::Buffer dabc::MemoryPool::TakeCachedBuffer(BufferSize_t size)
+{
+   Buffer res;
+
+   MemoryBlock* mem = fCacheMem.load(std::memory_order_acquire);
+
+   // all buffers have same size, cache cannot provide segmented list
+   if (!mem || (size > mem->fArr[0].size)) return res;
+
+   MemoryMagazine* mag = mem->GetMagazine();
+   if (!mag) return res;
+
+   unsigned id = 0;
+
+   {
+      LockGuard guard(mag->fMutex);
+
+      if (mag->fNum == 0) {
+         // refill half of the cache from the pool
+         MemoryMagazine::Inc(mag->fMisses);
+         LockGuard lock(ObjectMutex());
+         unsigned half = (mag->fIds.size() + 1) / 2;
+         while ((mag->fNum < half) && mem->IsAnyFree())
+            mag->fIds[mag->fNum++] = mem->fClasses[0].free.Pop();
+         if (mag->fNum == 0) return res;
+      } else {
+         MemoryMagazine::Inc(mag->fHits);
+      }
+
+      id = mag->fIds[--mag->fNum];
+   }
+
+   if (mem->fArr[id].refcnt.exchange(1) != 0)
+      throw dabc::Exception(ex_Pool, "Buffer is not free even is declared so", ItemName());
+
+   res.AllocateContainer(8);
+
+   MemSegment* segs = res.Segments();
+   segs[0].buffer = mem->fArr[id].buf;
+   segs[0].datasize = ((size > 0) && (size < mem->fArr[id].size)) ? size : mem->fArr[id].size;
+   segs[0].id = id;
+
+   res.GetObject()->fPool.SetObject(this);
+   res.GetObject()->fNumSegments = 1;
+   res.SetTypeId(mbt_Generic);
+
+   return res;
+}
+
+void dabc::MemoryPool::ReleaseCachedBuffer(MemoryBlock* mem, unsigned id)
+{
+   MemoryMagazine* mag = mem->GetMagazine();
+
+   if (!mag) {
+      LockGuard lock(ObjectMutex());
+      mem->PushFree(id);
+      return;
+   }
+
+   LockGuard guard(mag->fMutex);
+
+   if (mag->fNum == mag->fIds.size()) {
+      // return half of the cache to the pool
+      MemoryMagazine::Inc(mag->fFlushes);
+      LockGuard lock(ObjectMutex());
+      unsigned half = mag->fIds.size() / 2;
+      while (mag->fNum > half)
+         mem->PushFree(mag->fIds[--mag->fNum]);
+   }
+
+   mag->fIds[mag->fNum++] = id;
+}
+
+bool dabc::MemoryPool::ReclaimThreadCaches()
+{
+   MemoryBlock* mem = fCacheMem.load(std::memory_order_acquire);
+   if (!mem) return false;
+
+   bool isany = false;
+
+   for (unsigned n = 0; n < MemoryBlock::MaxMagazines; n++) {
+      MemoryMagazine* mag = mem->fMags[n].load(std::memory_order_acquire);
+      if (!mag) continue;
+
+      // same locking order as in TakeCachedBuffer - first magazine, than pool
+      LockGuard guard(mag->fMutex);
+      if (mag->fNum == 0) continue;
+      LockGuard lock(ObjectMutex());
+      while (mag->fNum > 0)
+         mem->PushFree(mag->fIds[--mag->fNum]);
+      isany = true;
+   }
+
+   if (isany) {
+      LockGuard lock(ObjectMutex());
+      fCacheReclaims++;
+   }
+
+   return isany;
+}
+
+
 dabc::Buffer dabc::MemoryPool::TakeBuffer(BufferSize_t size) throw()
 {
    dabc::Buffer res;
 
+   if (fCacheSize > 0) {
+      res = TakeCachedBuffer(size);
+      if (!res.null()) return res;
+
+      {
+         LockGuard lock(ObjectMutex());
+         res = _TakeBuffer(size, false);
+      }
+
+      if (!res.null()) return res;
+
+      // free buffers may be kept in caches of other threads
+      ReclaimThreadCaches();
+   }
+
    {
       LockGuard lock(ObjectMutex());
 
@@ -422,7 +918,8 @@ dabc::Buffer dabc::MemoryPool::TakeBuffer(BufferSize_t size) throw()
 
 void dabc::MemoryPool::IncreaseSegmRefs(MemSegment* segm, unsigned num)
 {
-   LockGuard lock(ObjectMutex());
+   // with threads caches reference counters are changed without pool mutex
+   LockGuard lock(fCacheSize > 0 ? nullptr : ObjectMutex());
 
    if (fMem==0)
       throw dabc::Exception(ex_Pool, "Memory was not allocated in the pool", ItemName());
@@ -441,7 +938,7 @@ void dabc::MemoryPool::IncreaseSegmRefs(MemSegment* segm, unsigned num)
 
 bool dabc::MemoryPool::IsSingleSegmRefs(MemSegment* segm, unsigned num)
 {
-   LockGuard lock(ObjectMutex());
+   LockGuard lock(fCacheSize > 0 ? nullptr : ObjectMutex());
 
    if (!fMem)
       throw dabc::Exception(ex_Pool, "Memory was not allocated in the pool", ItemName());
@@ -461,6 +958,23 @@ bool dabc::MemoryPool::IsSingleSegmRefs(MemSegment* segm, unsigned num)
 
 void dabc::MemoryPool::DecreaseSegmRefs(MemSegment* segm, unsigned num)
 {
+   MemoryBlock* mem = fCacheMem.load(std::memory_order_acquire);
+
+   if (mem) {
+      for (unsigned cnt=0;cnt<num;cnt++) {
+         unsigned id = segm[cnt].id;
+         if (id >= mem->fNumber)
+            throw dabc::Exception(ex_Pool, "Wrong buffer id in the segments list of buffer", ItemName());
+
+         int prev = mem->fArr[id].refcnt--;
+         if (prev == 1)
+            ReleaseCachedBuffer(mem, id);
+         else if (prev <= 0)
+            throw dabc::Exception(ex_Pool, "Reference counter of specified segment is already 0", ItemName());
+      }
+      return;
+   }
+
    LockGuard lock(ObjectMutex());
 
    if (!fMem)
@@ -474,7 +988,7 @@ void dabc::MemoryPool::DecreaseSegmRefs(MemSegment* segm, unsigned num)
       if (fMem->fArr[id].refcnt == 0)
          throw dabc::Exception(ex_Pool, "Reference counter of specified segment is already 0", ItemName());
 
-      if (--(fMem->fArr[id].refcnt) == 0) fMem->fFree.Push(id);
+      if (--(fMem->fArr[id].refcnt) == 0) fMem->PushFree(id);
    }
 
 }
@@ -556,14 +1070,23 @@ bool dabc::MemoryPool::RecheckRequests(bool from_recv)
       BufferSize_t sz = fReqests[portid].size;
       Buffer buf;
 
-      {
+      if (fCacheSize > 0)
+         buf = TakeCachedBuffer(sz);
+
+      if (buf.null()) {
          LockGuard lock(ObjectMutex());
 
          buf = _TakeBuffer(sz, false, true);
+      }
+
+      if (buf.null() && ReclaimThreadCaches()) {
+         LockGuard lock(ObjectMutex());
 
-         if (buf.null()) { fProcessingReq = false; return false; }
+         buf = _TakeBuffer(sz, false, true);
       }
 
+      if (buf.null()) { fProcessingReq = false; return false; }
+
       // we cannot get buffer, break loop and do not
 
       DOUT5("Memory pool %s send buffer size %u to output %u", GetName(), buf.GetTotalSize(), portid);
@@ -619,10 +1142,45 @@ bool dabc::MemoryPool::Reconstruct(Command cmd)
 
    unsigned align = Cfg(xmlAlignment, cmd).AsUInt(GetDfltAlignment());
 
-   DOUT1("POOL:%s bufsize:%u X num:%u", GetName(), buffersize, numbuffers);
+   unsigned cache = Cfg(xmlThreadCache, cmd).AsUInt(0);
+
+   std::string huge = Cfg(xmlHugePages, cmd).AsStr();
+   uint64_t hugesize = 0;
+   if ((huge == "1G") || (huge == "1g")) hugesize = 0x40000000; else
+   if ((huge == "2M") || (huge == "2m") || (huge == "true")) hugesize = 0x200000; else
+   if (!huge.empty() && (huge != "false") && (huge != "off") && (huge != "0"))
+      EOUT("POOL:%s unsupported huge pages value %s, use 2M or 1G", GetName(), huge.c_str());
+
+   std::string numa = Cfg(xmlNumaNode, cmd).AsStr();
+   int numanode = -1;
+   if (numa == "auto") numanode = -2; else
+   if (!numa.empty() && !dabc::str_to_int(numa.c_str(), &numanode)) {
+      EOUT("POOL:%s wrong NUMA node value %s", GetName(), numa.c_str());
+      numanode = -1;
+   }
+
+   DOUT1("POOL:%s bufsize:%u X num:%u cache:%u", GetName(), buffersize, numbuffers, cache);
 
    if (align) SetAlignment(align);
 
+   SetThreadCache(cache);
+
+   SetMemoryPlacement(hugesize, numanode);
+
+   // additional size classes in form [size:number, size:number], size may have k or M suffix
+   std::vector<std::string> classes = Cfg(xmlSizeClasses, cmd).AsStrVect();
+   for (unsigned n = 0; n < classes.size(); n++) {
+      std::size_t pos = classes[n].find(":");
+      std::string ssize = classes[n].substr(0, pos);
+      unsigned mult = 1, clsize = 0, clnum = 0;
+      if (!ssize.empty() && ((ssize.back() == 'k') || (ssize.back() == 'K'))) { mult = 1024; ssize.pop_back(); } else
+      if (!ssize.empty() && ((ssize.back() == 'm') || (ssize.back() == 'M'))) { mult = 1024*1024; ssize.pop_back(); }
+
+      if ((pos == std::string::npos) || !dabc::str_to_uint(ssize.c_str(), &clsize) ||
+          !dabc::str_to_uint(classes[n].substr(pos+1).c_str(), &clnum) || !AddSizeClass(clsize*mult, clnum))
+         EOUT("POOL:%s wrong size class %s, expected size:number", GetName(), classes[n].c_str());
+   }
+
    return Allocate(buffersize, numbuffers);
 }
 
@@ -643,6 +1201,65 @@ double dabc::MemoryPool::GetUsedRatio() const
 }
 
 
+void dabc::MemoryPool::BuildFieldsMap(RecordFieldsMap* cont)
+{
+   dabc::ModuleAsync::BuildFieldsMap(cont);
+
+   uint64_t hits(0), misses(0), flushes(0), reclaims(0);
+   unsigned numbufs(0), cachesize(0);
+   std::string memmode;
+   int numanode(-1);
+   std::vector<uint64_t> clsize, clnum, clfree, cltaken, clfallback;
+
+   {
+      LockGuard lock(ObjectMutex());
+      numbufs = fMem ? fMem->fNumber : 0;
+      cachesize = fCacheSize;
+      reclaims = fCacheReclaims;
+      if (fMem) {
+         memmode = fMem->fMemMode;
+         numanode = fMem->fNumaNode;
+         for (unsigned n = 0; n < fMem->fNumClasses; n++) {
+            clsize.push_back(fMem->fClasses[n].size);
+            clnum.push_back(fMem->fClasses[n].number);
+            clfree.push_back(fMem->fClasses[n].free.Size());
+            cltaken.push_back(fMem->fClasses[n].taken);
+            clfallback.push_back(fMem->fClasses[n].fallback);
+         }
+      }
+   }
+
+   cont->Field(xmlNumBuffers).SetUInt(numbufs);
+   cont->Field(xmlThreadCache).SetUInt(cachesize);
+   cont->Field("MemoryMode").SetStr(memmode);
+   cont->Field(xmlNumaNode).SetInt(numanode);
+
+   // statistic per size class, only when several classes exists
+   if (clsize.size() > 1) {
+      cont->Field("ClassSize").SetVectUInt(clsize);
+      cont->Field("ClassNumber").SetVectUInt(clnum);
+      cont->Field("ClassFree").SetVectUInt(clfree);
+      cont->Field("ClassTaken").SetVectUInt(cltaken);
+      cont->Field("ClassFallback").SetVectUInt(clfallback);
+   }
+
+   MemoryBlock* mem = fCacheMem.load(std::memory_order_acquire);
+   if (!mem) return;
+
+   for (unsigned n = 0; n < MemoryBlock::MaxMagazines; n++) {
+      MemoryMagazine* mag = mem->fMags[n].load(std::memory_order_acquire);
+      if (!mag) continue;
+      hits += mag->fHits.load(std::memory_order_relaxed);
+      misses += mag->fMisses.load(std::memory_order_relaxed);
+      flushes += mag->fFlushes.load(std::memory_order_relaxed);
+   }
+
+   cont->Field("CacheHits").SetUInt(hits);
+   cont->Field("CacheMisses").SetUInt(misses);
+   cont->Field("CacheFlushes").SetUInt(flushes);
+   cont->Field("CacheReclaims").SetUInt(reclaims);
+}
+
 int dabc::MemoryPool::ExecuteCommand(Command cmd)
 {
    if (cmd.IsName("CreateNewRequester")) {
@@ -452,6 +452,8 @@ int dabc::Module::PreviewCommand(Command cmd)
 
          req.SetUseAckn(port.Cfg(xmlUseacknAttr).AsBool(false));
 
+         req.SetBatchSize(port.Cfg(xmlBatchAttr).AsUInt(0));
+
          req.SetOptional(port.Cfg(xmlOptionalAttr).AsBool(false));
 
          req.SetConnDevice(port.Cfg(xmlDeviceAttr).AsStr());
@@ -765,21 +767,21 @@ void dabc::Module::ProduceInputEvent(unsigned indx, unsigned cnt)
 {
    // TODO: should we produce such event automatically ???
 
-   while (IsValidInput(indx) && cnt--)
-      FireEvent(evntInput, fInputs[indx]->ItemId());
+   if (IsValidInput(indx) && (cnt > 0))
+      FireEvents(evntInput, fInputs[indx]->ItemId(), cnt);
 }
 
 void dabc::Module::ProducePoolEvent(unsigned indx, unsigned cnt)
 {
-   while (IsValidPool(indx) && cnt--)
-      FireEvent(evntInput, fPools[indx]->ItemId());
+   if (IsValidPool(indx) && (cnt > 0))
+      FireEvents(evntInput, fPools[indx]->ItemId(), cnt);
 }
 
 
 void dabc::Module::ProduceOutputEvent(unsigned indx, unsigned cnt)
 {
-   while (IsValidOutput(indx) && cnt--)
-      FireEvent(evntOutput, fOutputs[indx]->ItemId());
+   if (IsValidOutput(indx) && (cnt > 0))
+      FireEvents(evntOutput, fOutputs[indx]->ItemId(), cnt);
 }
 
 bool dabc::Module::IsPortConnected(const std::string &name) const
@@ -929,9 +931,10 @@ void dabc::Module::ProcessEvent(const EventId& evid)
    }
 }
 
-bool dabc::Module::CanSendToAllOutputs(bool exclude_disconnected) const
+bool dabc::Module::CanSendToOutputs(unsigned first, unsigned num, bool exclude_disconnected) const
 {
-   for(unsigned n=0;n<NumOutputs();n++) {
+   unsigned last = (first + num < NumOutputs()) ? first + num : NumOutputs();
+   for(unsigned n=first;n<last;n++) {
       OutputPort* out = Output(n);
       if (exclude_disconnected && !out->IsConnected()) continue;
       if (!out->CanSend()) return false;
@@ -939,18 +942,20 @@ bool dabc::Module::CanSendToAllOutputs(bool exclude_disconnected) const
    return true;
 }
 
-void dabc::Module::SendToAllOutputs(Buffer& buf)
+void dabc::Module::SendToOutputs(unsigned first, unsigned num, Buffer& buf)
 {
    if (buf.null()) return;
 
-   unsigned last_can_send = NumOutputs();
-   for(unsigned n=0;n<NumOutputs();n++) {
+   unsigned last = (first + num < NumOutputs()) ? first + num : NumOutputs();
+
+   unsigned last_can_send = last;
+   for(unsigned n=first;n<last;n++) {
       OutputPort* out = Output(n);
       out->fSendallFlag = out->CanSend();
       if (out->fSendallFlag) last_can_send = n;
    }
 
-   for(unsigned n=0;n<NumOutputs();n++) {
+   for(unsigned n=first;n<last;n++) {
       OutputPort* out = Output(n);
       if (!out->fSendallFlag) continue;
 
@@ -964,7 +969,7 @@ void dabc::Module::SendToAllOutputs(Buffer& buf)
       }
    }
 
-   if ((last_can_send != NumOutputs()) && !buf.null()) {
+   if ((last_can_send != last) && !buf.null()) {
       EOUT("Should never happens buf %u!!!", buf.GetTotalSize());
       exit(333);
    }
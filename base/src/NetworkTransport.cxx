@@ -18,11 +18,12 @@
 #include "dabc/Manager.h"
 #include "dabc/Pointer.h"
 
-dabc::NetworkTransport::NetworkTransport(dabc::Command cmd, const PortRef& inpport, const PortRef& outport, bool useackn, WorkerAddon* addon) :
+dabc::NetworkTransport::NetworkTransport(dabc::Command cmd, const PortRef& inpport, const PortRef& outport, bool useackn, WorkerAddon* addon, unsigned batchsize) :
     dabc::Transport(cmd, inpport, outport),
     fNet(0),
     fTransportId(0),
     fUseAckn(useackn),
+    fBatchSize(batchsize),
     fInputQueueCapacity(0),
     fOutputQueueCapacity(0),
     fNumRecs(0),
@@ -54,7 +55,7 @@ dabc::NetworkTransport::NetworkTransport(dabc::Command cmd, const PortRef& inppo
    if (IsOutputTransport())
       fOutputQueueCapacity = outport.QueueCapacity();
 
-   DOUT2("Create new net transport inp %s out %s ackn %s", DBOOL(IsInputTransport()), DBOOL(IsOutputTransport()), DBOOL(fUseAckn));
+   DOUT2("Create new net transport inp %s out %s ackn %s batch %u", DBOOL(IsInputTransport()), DBOOL(IsOutputTransport()), DBOOL(fUseAckn), fBatchSize);
 
    if (fUseAckn) {
       if (fInputQueueCapacity<AcknoledgeQueueLength)
@@ -302,13 +303,16 @@ bool dabc::NetworkTransport::CheckAcknReadyCounter(unsigned newitems)
 
    fAcknSendBufBusy = true;
 
-   fAcknReadyCounter -= ackn_limit;
+   // acknowledge is cumulative - all buffers submitted since last ackn are reported at once
+   uint32_t cnt = fAcknReadyCounter;
+
+   fAcknReadyCounter = 0;
 
    fFirstAckn = false;
 
    dabc::Buffer buf;
 
-   uint32_t recid = TakeRec(buf, netot_HdrSend, ackn_limit);
+   uint32_t recid = TakeRec(buf, netot_HdrSend, cnt);
 
    fNet->SubmitSend(recid);
 
@@ -528,7 +532,7 @@ bool dabc::NetworkTransport::Make(const ConnectionRequest& req, WorkerAddon* add
    dabc::CmdCreateTransport cmd;
    cmd.SetPoolName(req.GetPoolName());
 
-   TransportRef tr = new NetworkTransport(cmd, inpport, outport, req.GetUseAckn(), addon);
+   TransportRef tr = new NetworkTransport(cmd, inpport, outport, req.GetUseAckn(), addon, req.GetBatchSize());
 
    if (tr.MakeThreadForWorker(newthrdname)) {
       tr.ConnectPoolHandles();
@@ -49,6 +49,10 @@ namespace dabc {
    const char* xmlBufferSize        = "BufferSize";
    const char* xmlNumBuffers        = "NumBuffers";
    const char* xmlAlignment         = "Alignment";
+   const char* xmlThreadCache       = "ThreadCache";
+   const char* xmlHugePages         = "HugePages";
+   const char* xmlNumaNode          = "NumaNode";
+   const char* xmlSizeClasses       = "SizeClasses";
    const char* xmlShowInfo          = "ShowInfo";
 
    const char* xmlNumInputs         = "NumInputs";
@@ -106,6 +110,7 @@ dabc::Object::Object(const std::string &name, unsigned flags) :
    fObjectName(name),
    fObjectMutex(nullptr),
    fObjectRefCnt(0),
+   fObjectFastDec(true),
    fObjectChilds(nullptr),
    fObjectBlock(0)
 {
@@ -120,6 +125,7 @@ dabc::Object::Object(Reference parent, const std::string &name, unsigned flags)
    fObjectName(name),
    fObjectMutex(nullptr),
    fObjectRefCnt(0),
+   fObjectFastDec(true),
    fObjectChilds(nullptr),
    fObjectBlock(0)
 {
@@ -135,6 +141,7 @@ dabc::Object::Object(const ConstructorPair& pair, unsigned flags) :
    fObjectName(pair.name),
    fObjectMutex(nullptr),
    fObjectRefCnt(0),
+   fObjectFastDec(true),
    fObjectChilds(nullptr),
    fObjectBlock(0)
 {
@@ -161,6 +168,7 @@ void dabc::Object::SetAutoDestroy(bool on)
 {
    LockGuard lock(fObjectMutex);
    SetFlag(flAutoDestroy, on);
+   _UpdateFastDec();
 }
 
 
@@ -219,6 +227,8 @@ void dabc::Object::Constructor()
 
    SetState(stNormal);
 
+   _UpdateFastDec();
+
    fObjectParent.AddChild(this);
 }
 
@@ -238,13 +248,13 @@ void dabc::Object::Destructor()
       LockGuard lock(fObjectMutex);
 
       if ((GetState() != stDestructor) && (fObjectRefCnt!=0)) {
-         EOUT("Object %p %s deleted not via Destroy method refcounter %u", this, GetName(), fObjectRefCnt);
+         EOUT("Object %p %s deleted not via Destroy method refcounter %u", this, GetName(), fObjectRefCnt.load());
       }
 
       SetState(stDestructor);
 
       if (fObjectRefCnt!=0) {
-         EOUT("!!!!!!!!!!!! Destructor called when refcounter %u obj:%s %p", fObjectRefCnt, GetName(), this);
+         EOUT("!!!!!!!!!!!! Destructor called when refcounter %u obj:%s %p", fObjectRefCnt.load(), GetName(), this);
 //         Object* obj = (Object*) 29387898;
 //         delete obj;
       }
@@ -277,6 +287,18 @@ void dabc::Object::Destructor()
 
 bool dabc::Object::IncReference(bool withmutex)
 {
+   if (withmutex) {
+      // fast path - when counter is not 0, somebody already has reference on the object
+      // and it cannot be in destructor state; therefore counter can be incremented without mutex
+      int cnt = fObjectRefCnt.load(std::memory_order_relaxed);
+      while (cnt > 0)
+         if (fObjectRefCnt.compare_exchange_weak(cnt, cnt + 1, std::memory_order_relaxed)) {
+            if (GetFlag(flLogging))
+               DOUT0("Obj:%s %p Class:%s IncReference +----- %u thrd:%s", GetName(), this, ClassName(), cnt + 1, dabc::mgr.CurrentThread().GetName());
+            return true;
+         }
+   }
+
    dabc::LockGuard lock(withmutex ? fObjectMutex : nullptr);
 
    if (GetState() == stDestructor) {
@@ -289,7 +311,7 @@ bool dabc::Object::IncReference(bool withmutex)
    fObjectRefCnt++;
 
    if (GetFlag(flLogging))
-      DOUT0("Obj:%s %p Class:%s IncReference +----- %u thrd:%s", GetName(), this, ClassName(), fObjectRefCnt, dabc::mgr.CurrentThread().GetName());
+      DOUT0("Obj:%s %p Class:%s IncReference +----- %u thrd:%s", GetName(), this, ClassName(), fObjectRefCnt.load(), dabc::mgr.CurrentThread().GetName());
 
    return true;
 }
@@ -321,6 +343,18 @@ bool dabc::Object::DecReference(bool ask_to_destroy, bool do_decrement, bool fro
 
    bool viathrd = false;
 
+   // fast path - simple decrement, which never brings counter to 0 and cannot trigger object destroyment;
+   // not possible for autodestroy object with childs, where last external reference can be any
+   if (do_decrement && !ask_to_destroy && fObjectFastDec.load(std::memory_order_acquire)) {
+      int cnt = fObjectRefCnt.load(std::memory_order_relaxed);
+      while (cnt > 1)
+         if (fObjectRefCnt.compare_exchange_weak(cnt, cnt - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            if (GetFlag(flLogging))
+               DOUT0("Obj:%s %p Class:%s DecReference ----+- %u thrd:%s", GetName(), this, ClassName(), cnt - 1, dabc::mgr.CurrentThread().GetName());
+            return false;
+         }
+   }
+
    {
       dabc::LockGuard lock(fObjectMutex);
 
@@ -346,7 +380,7 @@ bool dabc::Object::DecReference(bool ask_to_destroy, bool do_decrement, bool fro
          fObjectRefCnt--;
 
          if (GetFlag(flLogging))
-            DOUT0("Obj:%s %p Class:%s DecReference ----+- %u thrd:%s", GetName(), this, ClassName(), fObjectRefCnt, dabc::mgr.CurrentThread().GetName());
+            DOUT0("Obj:%s %p Class:%s DecReference ----+- %u thrd:%s", GetName(), this, ClassName(), fObjectRefCnt.load(), dabc::mgr.CurrentThread().GetName());
       }
 
       switch (GetState()) {
@@ -412,7 +446,7 @@ bool dabc::Object::DecReference(bool ask_to_destroy, bool do_decrement, bool fro
          // we delegate reference counter to the thread
          fObjectRefCnt++;
          if (GetFlag(flLogging))
-            DOUT0("Obj:%s %p Class:%s IncReference --+--- %u", GetName(), this, ClassName(), fObjectRefCnt);
+            DOUT0("Obj:%s %p Class:%s IncReference --+--- %u", GetName(), this, ClassName(), fObjectRefCnt.load());
       } else {
          SetState(stDoingDestroy);
       }
@@ -429,7 +463,7 @@ bool dabc::Object::DecReference(bool ask_to_destroy, bool do_decrement, bool fro
       fObjectRefCnt--;
 
       if (GetFlag(flLogging))
-         DOUT0("Obj:%s %p Class:%s DecReference -----+ %u", GetName(), this, ClassName(), fObjectRefCnt);
+         DOUT0("Obj:%s %p Class:%s DecReference -----+ %u", GetName(), this, ClassName(), fObjectRefCnt.load());
    }
 
 
@@ -452,7 +486,7 @@ bool dabc::Object::DecReference(bool ask_to_destroy, bool do_decrement, bool fro
          fObjectRefCnt++;
          SetState(stWaitForDestructor);
          if (GetFlag(flLogging))
-            DOUT0("Obj:%s %p Class:%s IncReference ---+-- %u", GetName(), this, ClassName(), fObjectRefCnt);
+            DOUT0("Obj:%s %p Class:%s IncReference ---+-- %u", GetName(), this, ClassName(), fObjectRefCnt.load());
       } else
       if (fObjectRefCnt==0) {
          // no need to deal with manager - can call destructor immediately
@@ -509,7 +543,7 @@ bool dabc::Object::DestroyCalledFromOwnThread()
 void dabc::Object::DeleteThis()
 {
    if (IsLogging())
-      DOUT1("OBJ:%p %s DELETETHIS cnt %u", this, GetName(), fObjectRefCnt);
+      DOUT1("OBJ:%p %s DELETETHIS cnt %u", this, GetName(), fObjectRefCnt.load());
 
    {
       LockGuard lock(fObjectMutex);
@@ -534,7 +568,7 @@ void dabc::Object::ObjectCleanup()
    RemoveChilds();
 
    if (IsLogging()) {
-      DOUT0("Obj:%p %s refcnt %u Before remove from parent %p", this, GetName(), fObjectRefCnt, fObjectParent());
+      DOUT0("Obj:%p %s refcnt %u Before remove from parent %p", this, GetName(), fObjectRefCnt.load(), fObjectParent());
    }
 
    // Than we remove reference on the object from parent
@@ -547,13 +581,18 @@ void dabc::Object::ObjectCleanup()
    }
 
    if (IsLogging()) {
-      DOUT0("Obj:%p %s refcnt %u after remove from parent", this, GetName(), fObjectRefCnt);
+      DOUT0("Obj:%p %s refcnt %u after remove from parent", this, GetName(), fObjectRefCnt.load());
    }
 
    DOUT3("Obj:%s Class:%s Finish cleanup numrefs %u", GetName(), ClassName(), NumReferences());
 
 }
 
+void dabc::Object::_UpdateFastDec()
+{
+   fObjectFastDec.store(!GetFlag(flAutoDestroy) || !fObjectChilds || (fObjectChilds->GetSize() == 0), std::memory_order_release);
+}
+
 unsigned dabc::Object::NumReferences()
 {
    dabc::LockGuard lock(fObjectMutex);
@@ -596,6 +635,8 @@ bool dabc::Object::AddChildAt(Object* child, unsigned pos, bool withmutex)
    else
       fObjectChilds->AddAt(ref, pos);
 
+   _UpdateFastDec();
+
    _ChildsChanged();
 
    return true;
@@ -627,14 +668,15 @@ bool dabc::Object::RemoveChild(Object* child, bool cleanup) throw()
          // otherwise reference will try to destroy parent
          // IMPORTANT: we are under object mutex and can do anything
 
+         _UpdateFastDec();
+
          _ChildsChanged();
 
          if (child->fObjectParent.fObj==this) {
             child->fObjectParent.fObj = 0; // not very nice, but will work
-            if (fObjectRefCnt>1) {
-               fObjectRefCnt--;
-            } else {
-               fObjectRefCnt = 0;
+            // counter cannot be incremented from 0 without mutex, decrement is safe
+            if (fObjectRefCnt > 0) fObjectRefCnt--;
+            if (fObjectRefCnt == 0) {
                if (fObjectChilds->GetSize() > 0)
                   DOUT0("Object %p %s refcnt==0 when numchild %u", this, GetName(), fObjectChilds->GetSize());
             }
@@ -837,6 +879,7 @@ bool dabc::Object::RemoveChilds(bool cleanup)
       isowner = GetFlag(flIsOwner);
       del_vect = fObjectChilds;
       fObjectChilds = nullptr;
+      _UpdateFastDec();
       break;
    }
 
@@ -873,7 +916,7 @@ void dabc::Object::SetName(const char *name)
    LockGuard guard(fObjectMutex);
 
    if (fObjectRefCnt > 0) {
-      EOUT("Cannot change object name when reference counter %d is not zero!!!", fObjectRefCnt);
+      EOUT("Cannot change object name when reference counter %d is not zero!!!", fObjectRefCnt.load());
       throw dabc::Exception(ex_Object, "Cannot change object name when refcounter is not zero", GetName());
    }
 
@@ -1105,7 +1148,7 @@ void dabc::Object::InspectGarbageCollector()
 
    for (unsigned n=0;n<gObjectGarbageCollector.size();n++) {
       Object* obj = (Object*) gObjectGarbageCollector.at(n);
-      DOUT0("   obj:%p name:%s class:%s refcnt:%u", obj, obj->GetName(), obj->ClassName(), obj->fObjectRefCnt);
+      DOUT0("   obj:%p name:%s class:%s refcnt:%u", obj, obj->GetName(), obj->ClassName(), obj->fObjectRefCnt.load());
    }
 
 #endif
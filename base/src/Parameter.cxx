@@ -83,9 +83,9 @@ dabc::RecordField dabc::ParameterContainer::GetField(const std::string &name) co
 
    std::string n = name.empty() ? DefaultFiledName() : name;
 
-   if (Fields().HasField(n)) return Fields().Field(n);
+   const RecordField *fld = Fields().FindField(n);
 
-   return dabc::RecordField();
+   return fld ? *fld : dabc::RecordField();
 }
 
 
@@ -37,7 +37,7 @@ void dabc::Pointer::long_shift(BufferSize_t len)
    fPtr = 0;
    fSegm++;
 
-   while ((fSegm < fBuf.NumSegments()) && (fBuf.SegmentSize(fSegm) < len)) {
+   while ((fSegm < fBuf.NumSegments()) && (fBuf.SegmentSize(fSegm) <= len)) {
       len -= fBuf.SegmentSize(fSegm);
       fFullSize -= fBuf.SegmentSize(fSegm);
       fSegm++;
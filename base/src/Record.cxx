@@ -18,6 +18,8 @@
 #include <cstring>
 #include <cstdlib>
 #include <fnmatch.h>
+#include <algorithm>
+#include <unordered_set>
 
 #include "dabc/Manager.h"
 
@@ -110,6 +112,57 @@ bool dabc::iostream::read_str(std::string& str)
    return verify_size(pos, sz);
 }
 
+bool dabc::iostream::write_varint(uint64_t v)
+{
+   unsigned char buf[10];
+   unsigned len = 0;
+   while (v >= 0x80) {
+      buf[len++] = (unsigned char) (v & 0x7f) | 0x80;
+      v >>= 7;
+   }
+   buf[len++] = (unsigned char) v;
+   return write(buf, len);
+}
+
+bool dabc::iostream::read_varint(uint64_t& v)
+{
+   v = 0;
+
+   // when data directly accessible, decode without extra calls
+   uint64_t avail = tmpbuf_size();
+   if (avail > 10) avail = 10;
+   if ((avail > 0) && tmpbuf()) {
+      const unsigned char *ptr = (const unsigned char *) tmpbuf();
+      for (unsigned n = 0; n < avail; n++) {
+         v |= ((uint64_t) (ptr[n] & 0x7f)) << (7*n);
+         if ((ptr[n] & 0x80) == 0) return shift(n+1);
+      }
+      return false;
+   }
+
+   unsigned char b = 0;
+   for (unsigned n = 0; n < 10; n++) {
+      if (!read(&b, 1)) return false;
+      v |= ((uint64_t) (b & 0x7f)) << (7*n);
+      if ((b & 0x80) == 0) return true;
+   }
+   return false;
+}
+
+bool dabc::iostream::read_vstr(std::string& str)
+{
+   uint64_t len = 0;
+   if (!read_varint(len) || (len > maxstoresize())) return false;
+
+   if ((len <= tmpbuf_size()) && tmpbuf()) {
+      str.assign(tmpbuf(), len);
+      return shift(len);
+   }
+
+   str.resize(len);
+   return (len == 0) || read(&str[0], len);
+}
+
 // ===========================================================================
 
 bool dabc::memstream::shift(uint64_t len)
@@ -439,9 +492,10 @@ bool dabc::RecordField::Stream(iostream& s)
             uint64_t sz(0);
             s.read_uint64(sz);
             valueBuf = new Buffer;
-            *valueBuf = Buffer::CreateBuffer((storesz-1)*8);
-            s.read(valueBuf->SegmentPtr(), (storesz-1)*8);
-            if (sz != (storesz-1)*8) valueBuf->SetTotalSize(sz);
+            // header and size are 16 bytes, rest is data with padding
+            *valueBuf = Buffer::CreateBuffer((storesz-2)*8);
+            s.read(valueBuf->SegmentPtr(), (storesz-2)*8);
+            if (sz != (storesz-2)*8) valueBuf->SetTotalSize(sz);
             break;
          }
          case kind_reference:
@@ -454,6 +508,150 @@ bool dabc::RecordField::Stream(iostream& s)
    return s.verify_size(pos, sz);
 }
 
+bool dabc::RecordField::StreamCompact(iostream& s)
+{
+   // integers stored as varint, signed values with zigzag coding
+   // strings, arrays and buffers have size in front, no any padding
+
+   if (s.is_output()) {
+      unsigned char kind = (unsigned char) fKind;
+      s.write(&kind, 1);
+      switch (fKind) {
+         case kind_none: break;
+         case kind_bool: {
+            unsigned char v = valueInt ? 1 : 0;
+            s.write(&v, 1);
+            break;
+         }
+         case kind_int: s.write_varint(((uint64_t) valueInt << 1) ^ (uint64_t) (valueInt >> 63)); break;
+         case kind_datime:
+         case kind_uint: s.write_varint(valueUInt); break;
+         case kind_double: s.write_double(valueDouble); break;
+         case kind_arrint:
+            s.write_varint(valueInt);
+            for (int64_t n = 0; n < valueInt; n++)
+               s.write_varint(((uint64_t) arrInt[n] << 1) ^ (uint64_t) (arrInt[n] >> 63));
+            break;
+         case kind_arruint:
+            s.write_varint(valueInt);
+            for (int64_t n = 0; n < valueInt; n++)
+               s.write_varint(arrUInt[n]);
+            break;
+         case kind_arrdouble:
+            s.write_varint(valueInt);
+            s.write(arrDouble, valueInt*sizeof(double));
+            break;
+         case kind_string:
+            s.write_vstr(valueStr, strlen(valueStr));
+            break;
+         case kind_arrstr: {
+            int64_t fulllen = 0;
+            char* ps = valueStr;
+            for (int64_t n=0;n<valueInt;n++) {
+               int len = strlen(ps) + 1;
+               fulllen += len; ps += len;
+            }
+            s.write_varint(valueInt);
+            s.write_vstr(valueStr, fulllen);
+            break;
+         }
+         case kind_buffer:
+            if (valueBuf->null())
+               s.write_varint(0);
+            else
+               s.write_vstr((const char *) valueBuf->SegmentPtr(), valueBuf->SegmentSize());
+            break;
+         case kind_reference:
+            // we do not write reference at all
+            break;
+      }
+      return true;
+   }
+
+   release();
+
+   unsigned char kind = 0;
+   if (!s.read(&kind, 1) || (kind > kind_reference)) return false;
+
+   uint64_t v = 0, len = 0;
+
+   switch (kind) {
+      case kind_none: break;
+      case kind_bool: {
+         unsigned char b = 0;
+         if (!s.read(&b, 1)) return false;
+         valueInt = b ? 1 : 0;
+         break;
+      }
+      case kind_int:
+         if (!s.read_varint(v)) return false;
+         valueInt = (int64_t) (v >> 1) ^ -((int64_t) (v & 1));
+         break;
+      case kind_datime:
+      case kind_uint:
+         if (!s.read_varint(valueUInt)) return false;
+         break;
+      case kind_double:
+         if (!s.read_double(valueDouble)) return false;
+         break;
+      case kind_arrint:
+      case kind_arruint:
+         // each value takes at least one byte
+         if (!s.read_varint(len) || (len > s.maxstoresize())) return false;
+         arrUInt = new uint64_t[len];
+         valueInt = len;
+         fKind = (ValueKind) kind; // set here, array will be released in case of error
+         for (uint64_t n = 0; n < len; n++) {
+            if (!s.read_varint(v)) return false;
+            arrUInt[n] = (kind == kind_arruint) ? v : (uint64_t) ((int64_t) (v >> 1) ^ -((int64_t) (v & 1)));
+         }
+         break;
+      case kind_arrdouble:
+         if (!s.read_varint(len) || (len > s.maxstoresize() / sizeof(double))) return false;
+         arrDouble = new double[len];
+         valueInt = len;
+         fKind = kind_arrdouble;
+         if (!s.read(arrDouble, len*sizeof(double))) return false;
+         break;
+      case kind_string:
+      case kind_arrstr:
+         if (kind == kind_arrstr) {
+            if (!s.read_varint(v)) return false;
+            valueInt = v;
+         }
+         if (!s.read_varint(len) || (len > s.maxstoresize())) return false;
+         valueStr = (char *) std::malloc(len + 1);
+         fKind = (ValueKind) kind;
+         if ((len > 0) && !s.read(valueStr, len)) { valueStr[0] = 0; return false; }
+         valueStr[len] = 0; // for the strings array last terminating zero is already there
+         if (kind == kind_arrstr) {
+            // check that all strings are there
+            uint64_t cnt = 0;
+            for (uint64_t n = 0; n < len; n++)
+               if (valueStr[n] == 0) cnt++;
+            if (cnt < v) return false;
+         }
+         break;
+      case kind_buffer:
+         if (!s.read_varint(len) || (len > s.maxstoresize())) return false;
+         valueBuf = new Buffer;
+         fKind = kind_buffer;
+         if (len > 0) {
+            *valueBuf = Buffer::CreateBuffer(len);
+            if (!s.read(valueBuf->SegmentPtr(), len)) return false;
+         }
+         break;
+      case kind_reference:
+         // also do not read reference
+         valueRef = new Reference;
+         break;
+   }
+
+   fKind = (ValueKind) kind;
+
+   return true;
+}
+
 void dabc::RecordField::release()
 {
    switch (fKind) {
@@ -1369,26 +1567,211 @@ void dabc::RecordField::SetArrStrDirect(int64_t size, char* arr, bool owner)
 
 // =========================================================================
 
+namespace dabc {
+
+   /** Global table of field names.
+    * Names are never removed, therefore pointers can be kept by any fields map */
+   class RecordAtomsTable {
+      protected:
+         Mutex fMutex;
+         std::unordered_set<std::string> fNames;
+      public:
+         RecordAtomsTable() : fMutex(), fNames() {}
+
+         const std::string *get(const std::string &name)
+         {
+            LockGuard lock(fMutex);
+            return &*fNames.insert(name).first;
+         }
+   };
+
+}
+
 dabc::RecordFieldsMap::RecordFieldsMap() :
-   fMap(),
+   fFields(),
+   fIndex(),
+   fSorted(),
+   fSortedValid(false),
    fChanged(false)
 {
 }
 
 dabc::RecordFieldsMap::~RecordFieldsMap()
 {
+   clear();
+}
+
+uint32_t dabc::RecordFieldsMap::name_hash(const std::string &name)
+{
+   // FNV-1a
+   uint32_t h = 2166136261U;
+   for (unsigned n = 0; n < name.length(); n++) {
+      h ^= (unsigned char) name[n];
+      h *= 16777619U;
+   }
+   return h;
+}
+
+const std::string *dabc::RecordFieldsMap::intern(const std::string &name, uint32_t hash)
+{
+   // table is never destroyed, fields maps may exist until very end
+   static RecordAtomsTable *table = new RecordAtomsTable;
+
+   // most names are repeated very often, per-thread cache avoids locking of global table
+   static thread_local const std::string *cache[256];
+
+   const std::string *&cached = cache[hash & 0xff];
+   if (!cached || (*cached != name))
+      cached = table->get(name);
+   return cached;
+}
+
+void dabc::RecordFieldsMap::clear()
+{
+   for (unsigned n = 0; n < fFields.size(); n++)
+      delete fFields[n];
+   fFields.clear();
+   fIndex.clear();
+   fSorted.clear();
+   fSortedValid = false;
+}
+
+int dabc::RecordFieldsMap::find(const std::string &name, uint32_t hash) const
+{
+   // small maps are scanned without index
+   if (fIndex.empty()) {
+      for (unsigned n = 0; n < fFields.size(); n++)
+         if ((fFields[n]->hash == hash) && (*fFields[n]->name == name))
+            return n;
+      return -1;
+   }
+
+   unsigned mask = fIndex.size() - 1;
+
+   for (unsigned i = hash & mask; fIndex[i].pos >= 0; i = (i+1) & mask)
+      if ((fIndex[i].hash == hash) && (*fFields[fIndex[i].pos]->name == name))
+         return fIndex[i].pos;
+
+   return -1;
+}
+
+unsigned dabc::RecordFieldsMap::find_slot(uint32_t hash, int pos) const
+{
+   unsigned mask = fIndex.size() - 1, i = hash & mask;
+   while (fIndex[i].pos != pos) i = (i+1) & mask;
+   return i;
+}
+
+void dabc::RecordFieldsMap::rehash(unsigned size)
+{
+   IndexSlot empty;
+   empty.hash = 0; empty.pos = -1;
+
+   fIndex.assign(size, empty);
+
+   unsigned mask = size - 1;
+   for (unsigned n = 0; n < fFields.size(); n++) {
+      unsigned i = fFields[n]->hash & mask;
+      while (fIndex[i].pos >= 0) i = (i+1) & mask;
+      fIndex[i].hash = fFields[n]->hash;
+      fIndex[i].pos = n;
+   }
+}
+
+dabc::RecordFieldsMap::FieldEntry *dabc::RecordFieldsMap::insert(const std::string &name, uint32_t hash)
+{
+   FieldEntry *entry = new FieldEntry(intern(name, hash), hash);
+
+   if (fIndex.empty() && (fFields.size() < LinearSearchLimit)) {
+      if (fFields.empty()) fFields.reserve(LinearSearchLimit);
+   } else {
+      // index kept at most half-filled
+      if (fIndex.size() < 2*(fFields.size() + 1))
+         rehash(fIndex.empty() ? 4*LinearSearchLimit : fIndex.size()*2);
+
+      unsigned mask = fIndex.size() - 1, i = hash & mask;
+      while (fIndex[i].pos >= 0) i = (i+1) & mask;
+      fIndex[i].hash = hash;
+      fIndex[i].pos = fFields.size();
+   }
+
+   fFields.push_back(entry);
+   fSortedValid = false;
+
+   return entry;
+}
+
+void dabc::RecordFieldsMap::remove_at(int pos)
+{
+   uint32_t hash = fFields[pos]->hash;
+   delete fFields[pos];
+
+   int last = fFields.size() - 1;
+
+   if (fIndex.empty()) {
+      fFields[pos] = fFields[last];
+      fFields.pop_back();
+      fSortedValid = false;
+      return;
+   }
+
+   unsigned mask = fIndex.size() - 1;
+   unsigned i = find_slot(hash, pos);
+
+   // backward shift deletion, no tombstones remain in the index
+   // entry can be moved into the free slot when its home slot is not in range (i, j]
+   for (unsigned j = (i+1) & mask; fIndex[j].pos >= 0; j = (j+1) & mask) {
+      unsigned home = fIndex[j].hash & mask;
+      if (((j - home) & mask) < ((j - i) & mask)) continue;
+      fIndex[i] = fIndex[j];
+      i = j;
+   }
+   fIndex[i].pos = -1;
+
+   // last field moved to the free position
+   if (pos != last) {
+      fIndex[find_slot(fFields[last]->hash, last)].pos = pos;
+      fFields[pos] = fFields[last];
+   }
+   fFields.pop_back();
+   fSortedValid = false;
+}
+
+const dabc::RecordFieldsMap::FieldsVector &dabc::RecordFieldsMap::sorted() const
+{
+   if (!fSortedValid) {
+      fSorted = fFields;
+      std::sort(fSorted.begin(), fSorted.end(),
+                [](const FieldEntry *e1, const FieldEntry *e2) { return *e1->name < *e2->name; });
+      fSortedValid = true;
+   }
+   return fSorted;
+}
+
+dabc::RecordField& dabc::RecordFieldsMap::Field(const std::string &name)
+{
+   uint32_t hash = name_hash(name);
+   int pos = find(name, hash);
+   if (pos >= 0) return fFields[pos]->field;
+   return insert(name, hash)->field;
+}
+
+const dabc::RecordField *dabc::RecordFieldsMap::FindField(const std::string &name) const
+{
+   int pos = find(name, name_hash(name));
+   return pos < 0 ? nullptr : &fFields[pos]->field;
 }
 
 bool dabc::RecordFieldsMap::HasField(const std::string &name) const
 {
-   return fMap.find(name) != fMap.end();
+   return find(name, name_hash(name)) >= 0;
 }
 
 bool dabc::RecordFieldsMap::RemoveField(const std::string &name)
 {
-   FieldsMap::iterator iter = fMap.find(name);
-   if (iter==fMap.end()) return false;
-   fMap.erase(iter);
+   int pos = find(name, name_hash(name));
+   if (pos < 0) return false;
+   remove_at(pos);
    fChanged = true;
    return true;
 }
@@ -1396,22 +1779,17 @@ bool dabc::RecordFieldsMap::RemoveField(const std::string &name)
 
 std::string dabc::RecordFieldsMap::FieldName(unsigned n) const
 {
-   if (n>=fMap.size()) return "";
-
-   for (FieldsMap::const_iterator iter = fMap.begin(); iter!=fMap.end(); iter++) {
-      if (n==0) return iter->first;
-      n--;
-   }
+   if (n >= fFields.size()) return "";
 
-   return "";
+   return *sorted()[n]->name;
 }
 
 bool dabc::RecordFieldsMap::WasChanged() const
 {
    if (fChanged) return true;
 
-   for (FieldsMap::const_iterator iter = fMap.begin(); iter!=fMap.end(); iter++)
-      if (iter->second.IsModified()) return true;
+   for (auto &&entry: fFields)
+      if (entry->field.IsModified()) return true;
 
    return false;
 }
@@ -1421,9 +1799,9 @@ bool dabc::RecordFieldsMap::WasChangedWith(const std::string &prefix)
 {
    // returns true when field with specified prefix was modified
 
-   for (auto &&fld: fMap) {
-      if (fld.second.IsModified())
-         if (fld.first.find(prefix)==0) return true;
+   for (auto &&entry: fFields) {
+      if (entry->field.IsModified())
+         if (entry->name->find(prefix)==0) return true;
    }
 
    return false;
@@ -1433,16 +1811,23 @@ bool dabc::RecordFieldsMap::WasChangedWith(const std::string &prefix)
 void dabc::RecordFieldsMap::ClearChangeFlags()
 {
    fChanged = false;
-   for (auto &&fld: fMap)
-      fld.second.SetModified(false);
+   for (auto &&entry: fFields)
+      entry->field.SetModified(false);
 }
 
 dabc::RecordFieldsMap *dabc::RecordFieldsMap::Clone()
 {
    dabc::RecordFieldsMap *res = new dabc::RecordFieldsMap;
 
-   for (FieldsMap::iterator iter = fMap.begin(); iter!=fMap.end(); iter++)
-      res->Field(iter->first).SetValue(iter->second);
+   res->fFields.reserve(fFields.size());
+   res->fIndex = fIndex;
+
+   // index can be copied while positions are preserved
+   for (auto &&entry: fFields) {
+      FieldEntry *copy = new FieldEntry(entry->name, entry->hash);
+      copy->field.SetValue(entry->field);
+      res->fFields.push_back(copy);
+   }
 
    return res;
 }
@@ -1475,17 +1860,17 @@ bool dabc::RecordFieldsMap::Stream(iostream& s, const std::string &nameprefix)
       sz = s.is_real() ? StoreSize(nameprefix) : 0;
       storesz = sz/8;
       storenum = 0;
-      for (FieldsMap::iterator iter = fMap.begin(); iter!=fMap.end(); iter++) {
-         if (match_prefix(iter->first, nameprefix)) storenum++;
+      for (auto &&entry: fFields) {
+         if (match_prefix(*entry->name, nameprefix)) storenum++;
       }
 
       s.write_uint32(storesz);
       s.write_uint32(storenum  | (storevers<<24));
 
-      for (FieldsMap::iterator iter = fMap.begin(); iter!=fMap.end(); iter++) {
-         if (!match_prefix(iter->first, nameprefix)) continue;
-         s.write_str(iter->first);
-         iter->second.Stream(s);
+      for (auto &&entry: sorted()) {
+         if (!match_prefix(*entry->name, nameprefix)) continue;
+         s.write_str(*entry->name);
+         entry->field.Stream(s);
       }
 
    } else {
@@ -1502,68 +1887,118 @@ bool dabc::RecordFieldsMap::Stream(iostream& s, const std::string &nameprefix)
       storenum = storenum & 0xffffff;
 
       // first clear touch flags
-      for (FieldsMap::iterator iter = fMap.begin(); iter!=fMap.end(); iter++)
-         iter->second.fTouched = false;
+      for (auto &&entry: fFields)
+         entry->field.fTouched = false;
 
+      std::string name;
       for (uint32_t n=0;n<storenum;n++) {
-         std::string name;
          s.read_str(name);
-         RecordField& fld = fMap[name];
+         RecordField& fld = Field(name);
          fld.Stream(s);
          fld.fTouched = true;
       }
 
-      FieldsMap::iterator iter = fMap.begin();
       // now we should remove all fields, which were not touched
-      while (iter!=fMap.end()) {
-         if (iter->second.fTouched) { iter++; continue; }
-         if (!match_prefix(iter->first, nameprefix)) { iter++; continue; }
-         fMap.erase(iter++);
+      // backward loop while last field moved into the place of removed
+      for (int n = (int) fFields.size() - 1; n >= 0; n--) {
+         if (fFields[n]->field.fTouched) continue;
+         if (!match_prefix(*fFields[n]->name, nameprefix)) continue;
+         remove_at(n);
       }
-
    }
 
    return s.verify_size(pos, sz);
 }
 
+bool dabc::RecordFieldsMap::StreamCompact(iostream& s)
+{
+   static const std::string noprefix;
+
+   if (s.is_output()) {
+      uint64_t num = 0;
+      for (auto &&entry: fFields)
+         if (match_prefix(*entry->name, noprefix)) num++;
+
+      s.write_varint(num);
+
+      // order of fields is not important, sorting is not required
+      for (auto &&entry: fFields) {
+         if (!match_prefix(*entry->name, noprefix)) continue;
+         s.write_vstr(entry->name->c_str(), entry->name->length());
+         if (!entry->field.StreamCompact(s)) return false;
+      }
+
+      return true;
+   }
+
+   uint64_t num = 0;
+   if (!s.read_varint(num)) return false;
+
+   for (auto &&entry: fFields)
+      entry->field.fTouched = false;
+
+   std::string name;
+   for (uint64_t n = 0; n < num; n++) {
+      if (!s.read_vstr(name) || name.empty()) return false;
+      RecordField& fld = Field(name);
+      if (!fld.StreamCompact(s)) return false;
+      fld.fTouched = true;
+   }
+
+   for (int n = (int) fFields.size() - 1; n >= 0; n--) {
+      if (fFields[n]->field.fTouched) continue;
+      if (!match_prefix(*fFields[n]->name, noprefix)) continue;
+      remove_at(n);
+   }
+
+   return true;
+}
+
 bool dabc::RecordFieldsMap::SaveTo(HStore& res)
 {
-   for (FieldsMap::const_iterator iter = fMap.begin(); iter!=fMap.end(); iter++) {
+   for (auto &&entry: sorted()) {
+
+      const std::string &name = *entry->name;
 
-      if (iter->first.empty() || (iter->first[0]=='#')) continue;
+      if (name.empty() || (name[0]=='#')) continue;
 
       // discard attributes, which using quotes or any special symbols in the names
-      if (iter->first.find_first_of(" #&\"\'!@%^*()=-\\/|~.,") != std::string::npos) continue;
+      if (name.find_first_of(" #&\"\'!@%^*()=-\\/|~.,") != std::string::npos) continue;
 
-      res.SetField(iter->first.c_str(), iter->second.AsJson().c_str());
+      res.SetField(name.c_str(), entry->field.AsJson().c_str());
    }
    return true;
 }
 
 void dabc::RecordFieldsMap::CopyFrom(const RecordFieldsMap& src, bool overwrite)
 {
-   for (FieldsMap::const_iterator iter = src.fMap.begin(); iter!=src.fMap.end(); iter++)
-      if (overwrite || !HasField(iter->first))
-         fMap[iter->first] = iter->second;
+   for (auto &&entry: src.fFields) {
+      int pos = find(*entry->name, entry->hash);
+      if (pos >= 0) {
+         if (overwrite) fFields[pos]->field = entry->field;
+      } else {
+         insert(*entry->name, entry->hash)->field = entry->field;
+      }
+   }
 }
 
 void dabc::RecordFieldsMap::MoveFrom(RecordFieldsMap& src)
 {
-   std::vector<std::string> delfields;
-
-   for (FieldsMap::iterator iter = fMap.begin(); iter!=fMap.end(); iter++) {
-      if (iter->second.IsProtected()) continue;
-      if (!src.HasField(iter->first)) delfields.push_back(iter->first);
+   for (int n = (int) fFields.size() - 1; n >= 0; n--) {
+      if (fFields[n]->field.IsProtected()) continue;
+      if (src.find(*fFields[n]->name, fFields[n]->hash) < 0) {
+         remove_at(n);
+         fChanged = true;
+      }
    }
 
-   for (unsigned n=0;n<delfields.size();n++)
-      RemoveField(delfields[n]);
-
-   for (FieldsMap::iterator iter = src.fMap.begin(); iter!=src.fMap.end(); iter++) {
+   for (auto &&entry: src.fFields) {
       // should we completely preserve protected fields???
-      // if (iter->second.IsProtected()) continue;
+      // if (entry->field.IsProtected()) continue;
 
-      fMap[iter->first].SetValue(iter->second);
+      int pos = find(*entry->name, entry->hash);
+      FieldEntry *tgt = pos >= 0 ? fFields[pos] : insert(*entry->name, entry->hash);
+      tgt->field.SetValue(entry->field);
    }
 }
 
@@ -1571,26 +2006,33 @@ void dabc::RecordFieldsMap::MakeAsDiffTo(const RecordFieldsMap& current)
 {
    std::vector<std::string> delfields;
 
-   for (auto &&fld : current.fMap) {
-      if (!HasField(fld.first))
-         delfields.push_back(fld.first);
-      else
-         if (!fld.second.fModified) RemoveField(fld.first);
+   for (auto &&entry : current.fFields) {
+      int pos = find(*entry->name, entry->hash);
+      if (pos < 0)
+         delfields.push_back(*entry->name);
+      else if (!entry->field.fModified) {
+         remove_at(pos);
+         fChanged = true;
+      }
    }
 
    // we remember fields, which should be delete when we start to reconstruct history
-   if (delfields.size() > 0)
+   if (delfields.size() > 0) {
+      std::sort(delfields.begin(), delfields.end());
       Field("dabc:del").SetStrVect(delfields);
+   }
 }
 
 void dabc::RecordFieldsMap::ApplyDiff(const RecordFieldsMap& diff)
 {
-   for (FieldsMap::const_iterator iter = diff.fMap.begin(); iter!=diff.fMap.end(); iter++) {
-      if (iter->first != "dabc:del") {
-         fMap[iter->first] = iter->second;
-         fMap[iter->first].fModified = true;
+   for (auto &&entry: diff.sorted()) {
+      if (*entry->name != "dabc:del") {
+         int pos = find(*entry->name, entry->hash);
+         RecordField &fld = pos >= 0 ? fFields[pos]->field : insert(*entry->name, entry->hash)->field;
+         fld = entry->field;
+         fld.fModified = true;
       } else {
-         std::vector<std::string> delfields = iter->second.AsStrVect();
+         std::vector<std::string> delfields = entry->field.AsStrVect();
          for (unsigned n=0;n<delfields.size();n++)
             RemoveField(delfields[n]);
       }
@@ -1709,20 +2151,46 @@ bool dabc::Record::Stream(iostream& s)
    return s.verify_size(pos, sz);
 }
 
-dabc::Buffer dabc::Record::SaveToBuffer()
+bool dabc::Record::StreamCompact(iostream& s)
+{
+   if (s.is_output()) {
+      unsigned char version = storeversion_Compact;
+      std::string name = GetName();
+      return s.write(&version, 1) &&
+             s.write_vstr(name.c_str(), name.length()) &&
+             GetObject()->Fields().StreamCompact(s);
+   }
+
+   unsigned char version = 0;
+   if (!s.read(&version, 1) || (version != storeversion_Compact)) return false;
+
+   std::string objname;
+   if (!s.read_vstr(objname)) return false;
+
+   if (null())
+      CreateRecord(objname);
+   else
+      GetObject()->SetName(objname.c_str());
+
+   return GetObject()->Fields().StreamCompact(s);
+}
+
+dabc::Buffer dabc::Record::SaveToBuffer(unsigned version)
 {
    if (null()) return dabc::Buffer();
 
+   bool compact = (version == storeversion_Compact);
+
    // first define size we need
    sizestream s;
-   Stream(s);
+   if (compact) StreamCompact(s); else Stream(s);
 
    dabc::Buffer res = dabc::Buffer::CreateBuffer(s.size());
    if (res.null()) return res;
 
    memstream outs(false, (char*) res.SegmentPtr(), res.SegmentSize());
 
-   if (Stream(outs)) {
+   if (compact ? StreamCompact(outs) : Stream(outs)) {
       if (s.size() != outs.size()) { EOUT("Stream sizes mismatch %u %u", (unsigned) s.size(), (unsigned) outs.size()); }
       res.SetTotalSize(s.size());
    } else {
@@ -1732,13 +2200,13 @@ dabc::Buffer dabc::Record::SaveToBuffer()
    return res;
 }
 
-bool dabc::Record::ReadFromBuffer(const dabc::Buffer& buf)
+bool dabc::Record::ReadFromBuffer(const dabc::Buffer& buf, unsigned version)
 {
    if (buf.null()) return false;
 
    memstream inps(true, (char*) buf.SegmentPtr(), buf.SegmentSize());
 
-   if (!Stream(inps)) {
+   if (!(version == storeversion_Compact ? StreamCompact(inps) : Stream(inps))) {
       EOUT("Cannot reconstruct record from the binary data!");
       return false;
    }
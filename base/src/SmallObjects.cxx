@@ -0,0 +1,187 @@
+// $Id$
+
+/************************************************************
+ * The Data Acquisition Backbone Core (DABC)                *
+ ************************************************************
+ * Copyright (C) 2009 -                                     *
+ * GSI Helmholtzzentrum fuer Schwerionenforschung GmbH      *
+ * Planckstr. 1, 64291 Darmstadt, Germany                   *
+ * Contact:  http://dabc.gsi.de                             *
+ ************************************************************
+ * This software can be used under the GPL license          *
+ * agreements as stated in LICENSE.txt file                 *
+ * which is part of the distribution.                       *
+ ************************************************************/
+
+#include "dabc/SmallObjects.h"
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "dabc/threads.h"
+
+namespace dabc {
+
+   /** Free lists of single thread.
+    * Structure has no constructor and destructor - it is zero-initialized and remains
+    * accessible even after thread-local objects of the thread are destroyed */
+   struct SmallObjectsLists {
+      void    *heads[SmallObjects::NumClasses];   ///< first free block in each class
+      unsigned counts[SmallObjects::NumClasses];  ///< number of free blocks in each class
+      std::atomic<uint64_t> allocated, reused, released, freed;  ///< modified only by own thread
+      bool     registered;                        ///< lists are registered in global table
+      bool     closed;                            ///< thread finished, lists no longer used
+
+      void inc(std::atomic<uint64_t> &cnt) { cnt.store(cnt.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+   };
+
+   /** Global table with lists of all threads, used only for statistic */
+   struct SmallObjectsTable {
+      Mutex fMutex;
+      std::vector<SmallObjectsLists*> fLists;
+      SmallObjects::Statistic fFinished;   ///< counters of already finished threads
+
+      SmallObjectsTable() : fMutex(), fLists(), fFinished() {}
+   };
+
+   /** Object releases thread lists when thread finishes */
+   struct SmallObjectsCleanup {
+      SmallObjectsLists *fLists{nullptr};
+      ~SmallObjectsCleanup();
+   };
+
+   static std::atomic<unsigned> gSmallObjectsMaxKeep(1024);
+
+   static thread_local SmallObjectsLists gSmallObjectsLists;
+
+   static thread_local SmallObjectsCleanup gSmallObjectsCleanup;
+
+   static SmallObjectsTable &SmallObjectsGlobal()
+   {
+      // table is never destroyed, threads may finish very late
+      static SmallObjectsTable *table = new SmallObjectsTable;
+      return *table;
+   }
+
+   static SmallObjectsLists &SmallObjectsThreadLists()
+   {
+      SmallObjectsLists &lists = gSmallObjectsLists;
+      if (!lists.registered) {
+         lists.registered = true;
+         gSmallObjectsCleanup.fLists = &lists;
+         SmallObjectsTable &table = SmallObjectsGlobal();
+         LockGuard lock(table.fMutex);
+         table.fLists.push_back(&lists);
+      }
+      return lists;
+   }
+}
+
+
+dabc::SmallObjectsCleanup::~SmallObjectsCleanup()
+{
+   if (!fLists) return;
+
+   for (unsigned n = 0; n < SmallObjects::NumClasses; n++) {
+      while (fLists->heads[n]) {
+         void *next = *((void **) fLists->heads[n]);
+         std::free(fLists->heads[n]);
+         fLists->heads[n] = next;
+         fLists->inc(fLists->freed);
+      }
+      fLists->counts[n] = 0;
+   }
+
+   fLists->closed = true;
+
+   SmallObjectsTable &table = SmallObjectsGlobal();
+   LockGuard lock(table.fMutex);
+   table.fFinished.allocated += fLists->allocated.load();
+   table.fFinished.reused += fLists->reused.load();
+   table.fFinished.released += fLists->released.load();
+   table.fFinished.freed += fLists->freed.load();
+   fLists->allocated = fLists->reused = fLists->released = fLists->freed = 0;
+   table.fLists.erase(std::remove(table.fLists.begin(), table.fLists.end(), fLists), table.fLists.end());
+   fLists = nullptr;
+}
+
+void *dabc::SmallObjects::Allocate(size_t sz)
+{
+   void *res = nullptr;
+
+   if ((sz > 0) && (sz <= MaxSize)) {
+      SmallObjectsLists &lists = SmallObjectsThreadLists();
+      unsigned cl = (sz - 1) / ClassSize;
+
+      if (lists.heads[cl]) {
+         res = lists.heads[cl];
+         lists.heads[cl] = *((void **) res);
+         lists.counts[cl]--;
+         lists.inc(lists.reused);
+         return res;
+      }
+
+      // allocate full class size that block can be reused for any object of the class
+      res = std::malloc((cl + 1) * ClassSize);
+      if (!lists.closed) lists.inc(lists.allocated);
+   } else {
+      res = std::malloc(sz);
+   }
+
+   if (!res) throw std::bad_alloc();
+
+   return res;
+}
+
+void dabc::SmallObjects::Release(void *ptr, size_t sz)
+{
+   if (!ptr) return;
+
+   if ((sz > 0) && (sz <= MaxSize)) {
+      SmallObjectsLists &lists = SmallObjectsThreadLists();
+      unsigned cl = (sz - 1) / ClassSize;
+
+      if (!lists.closed && (lists.counts[cl] < gSmallObjectsMaxKeep.load(std::memory_order_relaxed))) {
+         *((void **) ptr) = lists.heads[cl];
+         lists.heads[cl] = ptr;
+         lists.counts[cl]++;
+         lists.inc(lists.released);
+         return;
+      }
+
+      if (!lists.closed) lists.inc(lists.freed);
+   }
+
+   std::free(ptr);
+}
+
+void dabc::SmallObjects::SetMaxKeep(unsigned num)
+{
+   gSmallObjectsMaxKeep = num;
+}
+
+unsigned dabc::SmallObjects::GetMaxKeep()
+{
+   return gSmallObjectsMaxKeep;
+}
+
+dabc::SmallObjects::Statistic dabc::SmallObjects::GetStatistic()
+{
+   SmallObjectsTable &table = SmallObjectsGlobal();
+
+   LockGuard lock(table.fMutex);
+
+   Statistic res = table.fFinished;
+
+   for (auto &&lists : table.fLists) {
+      res.allocated += lists->allocated.load(std::memory_order_relaxed);
+      res.reused += lists->reused.load(std::memory_order_relaxed);
+      res.released += lists->released.load(std::memory_order_relaxed);
+      res.freed += lists->freed.load(std::memory_order_relaxed);
+   }
+
+   return res;
+}
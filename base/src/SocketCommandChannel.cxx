@@ -32,16 +32,18 @@ dabc::SocketCommandClient::SocketCommandClient(Reference parent, const std::stri
    fRemoteHostName(hostname),
    fReconnectPeriod(reconnect),
    fState(stConnecting),
-   fSendHdr(),
-   fSendBuf(),
-   fSendRawData(),
+   fSendRecs(),
+   fSendRecsNum(0),
+   fSendIOV(),
    fSendingActive(true), // mark as active until I/O object is not yet assigned
+   fSendActivated(false),
+   fSendVersion(storeversion_Aligned),
    fRecvHdr(),
    fRecvBuf(0),
    fRecvBufSize(0),
+   fRecvFill(0),
    fSendQueue(),
    fWaitQueue(),
-   fRecvState(recvInit),
    fRemoteObserver(false),
    fRemoteName(),
    fMasterConn(false),
@@ -58,8 +60,7 @@ dabc::SocketCommandClient::SocketCommandClient(Reference parent, const std::stri
    if (io) {
       fState = stWorking;
       fSendingActive = false;
-      fRecvState = recvHeader;
-      io->StartRecv(&fRecvHdr, sizeof(fRecvHdr));
+      StartRecvData();
    }
 }
 
@@ -81,32 +82,129 @@ void dabc::SocketCommandClient::OnThreadAssigned()
 
 bool dabc::SocketCommandClient::EnsureRecvBuffer(unsigned strsize)
 {
-   if ((strsize>0) && (strsize< fRecvBufSize)) return true;
+   // already received data are preserved when buffer is reallocated
 
-   if (fRecvBufSize > 0) {
+   if ((strsize>0) && (strsize <= fRecvBufSize)) return true;
+
+   if (strsize == 0) {
       delete [] fRecvBuf;
       fRecvBuf = nullptr;
       fRecvBufSize = 0;
+      fRecvFill = 0;
+      return true;
    }
 
-   if (strsize == 0) return true;
-
-   fRecvBufSize = 2048;
-   while (fRecvBufSize <= strsize) fRecvBufSize *=2;
+   unsigned newsize = 16384;
+   while (newsize < strsize) newsize *= 2;
 
-   fRecvBuf = new char[fRecvBufSize];
+   char* newbuf = new char[newsize];
 
-   if (fRecvBuf==0) {
-      EOUT("Cannot allocate buffer %u", fRecvBufSize);
-      fRecvBufSize = 0;
+   if (newbuf==0) {
+      EOUT("Cannot allocate buffer %u", newsize);
       return false;
    }
 
+   if (fRecvFill > 0) memcpy(newbuf, fRecvBuf, fRecvFill);
+   delete [] fRecvBuf;
+
+   fRecvBuf = newbuf;
+   fRecvBufSize = newsize;
+
    DOUT3("%s ALLOCATE %u", ItemName().c_str(), fRecvBufSize);
 
    return true;
 }
 
+void dabc::SocketCommandClient::StartRecvData()
+{
+   SocketIOAddon* io = dynamic_cast<SocketIOAddon*> (fAddon());
+   if (!io) return;
+
+   // buffer should be large enough for the whole next packet
+   unsigned need = fRecvFill + sizeof(SocketCmdPacket);
+   if (fRecvFill >= sizeof(SocketCmdPacket)) {
+      memcpy(&fRecvHdr, fRecvBuf, sizeof(fRecvHdr));
+      if (fRecvHdr.dabc_header == dabc::SocketDevice::headerConnect)
+         need = dabc::SocketDevice::ProtocolMsgSize;
+      else
+         need = sizeof(SocketCmdPacket) + fRecvHdr.data_size;
+   }
+
+   if (!EnsureRecvBuffer(need)) {
+      CloseClient(true, "memory allocation");
+      return;
+   }
+
+   io->StartRecvAny(fRecvBuf + fRecvFill, fRecvBufSize - fRecvFill);
+}
+
+void dabc::SocketCommandClient::ProcessRecvData()
+{
+   SocketIOAddon* io = dynamic_cast<SocketIOAddon*> (fAddon());
+   if (!io) return;
+
+   fRecvFill += io->GetRecvSize();
+
+   unsigned pos = 0;
+
+   while (fRecvFill - pos >= sizeof(SocketCmdPacket)) {
+      memcpy(&fRecvHdr, fRecvBuf + pos, sizeof(fRecvHdr));
+
+      if (fRecvHdr.dabc_header == dabc::SocketDevice::headerConnect) {
+
+         if (fDebugMode)
+            DOUT0("cmdclnt: get header with connect request via socket %d", io->Socket());
+
+         SocketCommandChannel* ch = dynamic_cast<SocketCommandChannel*> (GetParent());
+         if ((pos > 0) || !ch || ch->fRedirectDevice.empty()) {
+            CloseClient(true, "Wrong socket device connect from network");
+            return;
+         }
+
+         // wait until full connect request is received
+         if (fRecvFill < dabc::SocketDevice::ProtocolMsgSize) break;
+
+         // here we get all data for connection, redirect it to the device
+
+         if (fDebugMode)
+            DOUT0("cmdclnt: get full connect request, redirect socket %d", io->Socket());
+
+         dabc::Command cmd("RedirectConnect");
+         cmd.SetInt("Socket", io->TakeSocket());
+         cmd.SetRawData(dabc::Buffer::CreateBuffer(fRecvBuf, dabc::SocketDevice::ProtocolMsgSize, false, true));
+
+         cmd.SetReceiver(ch->fRedirectDevice);
+         dabc::mgr.Submit(cmd);
+
+         CloseClient(false, "redirect connect");
+         return;
+      }
+
+      if ((fRecvHdr.dabc_header != headerDabc) && (fRecvHdr.dabc_header != headerDabcCompact)) {
+         CloseClient(true, "Wrong packet from network");
+         return;
+      }
+
+      unsigned pktsize = sizeof(SocketCmdPacket) + fRecvHdr.data_size;
+      if (fRecvFill - pos < pktsize) break;
+
+      ProcessRecvPacket(fRecvBuf + pos + sizeof(SocketCmdPacket));
+
+      // connection may be closed or reinitialized when processing packet
+      if ((fState != stWorking) || (fAddon() != io)) return;
+
+      pos += pktsize;
+   }
+
+   // move incomplete packet to the buffer begin
+   if (pos > 0) {
+      fRecvFill -= pos;
+      if (fRecvFill > 0) memmove(fRecvBuf, fRecvBuf + pos, fRecvFill);
+   }
+
+   StartRecvData();
+}
+
 void dabc::SocketCommandClient::CloseClient(bool iserr, const char* msg)
 {
    if (msg) {
@@ -118,6 +216,14 @@ void dabc::SocketCommandClient::CloseClient(bool iserr, const char* msg)
 
    if (!fRemoteHostName.empty() && (fReconnectPeriod>0)) {
       AssignAddon(nullptr); // we destroy current addon
+      // commands from not completed send operation will be timed out
+      for (unsigned n = 0; n < fSendRecsNum; n++) {
+         fSendRecs[n].buf.Release();
+         fSendRecs[n].raw.Release();
+      }
+      fSendRecsNum = 0;
+      fSendingActive = true; // no sending until connection established again
+      fRecvFill = 0;
       DOUT2("Try to reconnect worker %s to remote node %s", ItemName().c_str(), fRemoteHostName.c_str());
       fState = stConnecting;
       ActivateTimeout(fReconnectPeriod);
@@ -154,9 +260,13 @@ int dabc::SocketCommandClient::ExecuteCommand(Command cmd)
 
       // DOUT0("Did addon assign numrefs:%u", NumReferences());
 
-      fRecvState = recvHeader;
-      // start receiving of header immediately
-      addon->StartRecv(&fRecvHdr, sizeof(fRecvHdr));
+      // start receiving immediately
+      fRecvFill = 0;
+      StartRecvData();
+
+      // remote side may not support compact encoding, always start with original one
+      fSendVersion = storeversion_Aligned;
+      RequestCompactEncoding();
 
       if (fMasterConn) {
          dabc::Command cmd("AcceptClient");
@@ -171,7 +281,7 @@ int dabc::SocketCommandClient::ExecuteCommand(Command cmd)
          // this name will be used to identify our node and deliver commands
          cmd.SetStr("globalname", dabc::mgr.GetLocalAddress());
 
-         SendCommand(cmd);
+         PrepareCommand(cmd);
       }
 
       SendSubmittedCommands();
@@ -182,8 +292,28 @@ int dabc::SocketCommandClient::ExecuteCommand(Command cmd)
    return dabc::Worker::ExecuteCommand(cmd);
 }
 
+void dabc::SocketCommandClient::RequestCompactEncoding()
+{
+   // command sent in original encoding, older remote just replies it with failure
+   // reply from newer remote is delivered to ReplyCommand and switches encoding for next commands
+   dabc::Command cmd("SocketCmdEncoding");
+   cmd.SetUInt("version", storeversion_Compact);
+   cmd.SetTimeout(10.);
+   PrepareCommand(Assign(cmd));
+}
+
 bool dabc::SocketCommandClient::ExecuteCommandByItself(Command cmd)
 {
+   if (cmd.IsName("SocketCmdEncoding")) {
+      // both sides can always decode both encodings, therefore switch immediately
+      fSendVersion = cmd.GetUInt("version") >= storeversion_Compact ? storeversion_Compact : storeversion_Aligned;
+      cmd.SetUInt("version", fSendVersion);
+      cmd.SetResult(cmd_true);
+      if (fDebugMode)
+         DOUT0("cmdclnt: %s use commands encoding %u", ItemName().c_str(), fSendVersion);
+      return true;
+   }
+
    if (cmd.IsName("AcceptClient")) {
       DOUT0("We allow to transform connection to the monitoring channel");
       cmd.SetResult(cmd_true);
@@ -208,7 +338,7 @@ bool dabc::SocketCommandClient::ExecuteCommandByItself(Command cmd)
    return false;
 }
 
-void dabc::SocketCommandClient::ProcessRecvPacket()
+void dabc::SocketCommandClient::ProcessRecvPacket(const char* data)
 {
    if (fRecvHdr.data_kind == kindDisconnect) {
       CloseClient(false, "disconnect packet");
@@ -222,8 +352,8 @@ void dabc::SocketCommandClient::ProcessRecvPacket()
       return;
    }
 
-   dabc::Buffer cmddata = dabc::Buffer::CreateBuffer(fRecvBuf, fRecvHdr.data_cmdsize, false, true);
-   if (!cmd.ReadFromBuffer(cmddata)) {
+   dabc::Buffer cmddata = dabc::Buffer::CreateBuffer(data, fRecvHdr.data_cmdsize, false, true);
+   if (!cmd.ReadFromBuffer(cmddata, fRecvHdr.dabc_header == headerDabcCompact ? storeversion_Compact : storeversion_Aligned)) {
       CloseClient(true, "cannot decode command");
       return;
    }
@@ -235,7 +365,7 @@ void dabc::SocketCommandClient::ProcessRecvPacket()
       case kindCommand:
 
          if (fRecvHdr.data_rawsize > 0) {
-            dabc::Buffer rawdata = dabc::Buffer::CreateBuffer(fRecvBuf + fRecvHdr.data_cmdsize, fRecvHdr.data_rawsize, false, true);
+            dabc::Buffer rawdata = dabc::Buffer::CreateBuffer(data + fRecvHdr.data_cmdsize, fRecvHdr.data_rawsize, false, true);
             cmd.SetRawData(rawdata);
          }
 
@@ -278,7 +408,7 @@ void dabc::SocketCommandClient::ProcessRecvPacket()
             maincmd.AddValuesFrom(cmd);
 
             if (fRecvHdr.data_rawsize>0) {
-               dabc::Buffer rawdata = dabc::Buffer::CreateBuffer(fRecvBuf + fRecvHdr.data_cmdsize, fRecvHdr.data_rawsize, false, true);
+               dabc::Buffer rawdata = dabc::Buffer::CreateBuffer(data + fRecvHdr.data_cmdsize, fRecvHdr.data_rawsize, false, true);
                maincmd.SetRawData(rawdata);
             }
 
@@ -288,11 +418,6 @@ void dabc::SocketCommandClient::ProcessRecvPacket()
          break;
       }
    }
-
-   fRecvState = recvHeader;
-   // first of all, sumbit next recv header operation
-   SocketIOAddon *io = dynamic_cast<SocketIOAddon*> (fAddon());
-   io->StartRecv(&fRecvHdr, sizeof(fRecvHdr));
 }
 
 bool dabc::SocketCommandClient::ReplyCommand(Command cmd)
@@ -305,6 +430,14 @@ bool dabc::SocketCommandClient::ReplyCommand(Command cmd)
       return true;
    }
 
+   if (cmd.IsName("SocketCmdEncoding")) {
+      if (cmd.GetResult() == cmd_true)
+         fSendVersion = cmd.GetUInt("version") >= storeversion_Compact ? storeversion_Compact : storeversion_Aligned;
+      if (fDebugMode)
+         DOUT0("cmdclnt: %s use commands encoding %u", ItemName().c_str(), fSendVersion);
+      return true;
+   }
+
    return dabc::Worker::ReplyCommand(cmd);
 }
 
@@ -314,6 +447,12 @@ void dabc::SocketCommandClient::ProcessEvent(const EventId& evnt)
    switch (evnt.GetCode()) {
       case SocketAddon::evntSocketSendInfo:
 
+         for (unsigned n = 0; n < fSendRecsNum; n++) {
+            fSendRecs[n].buf.Release();
+            fSendRecs[n].raw.Release();
+         }
+         fSendRecsNum = 0;
+
          fSendingActive = false;
 
          // immediately try to send next commands
@@ -321,88 +460,14 @@ void dabc::SocketCommandClient::ProcessEvent(const EventId& evnt)
 
          break;
 
-      case SocketAddon::evntSocketRecvInfo: {
-
-         if (fRecvState == recvInit) {
-            CloseClient(true, "Receive data in init state");
-            return;
-         }
-
-         if (fRecvState == recvData) {
-            fRecvState = recvInit;
-            // here raw buffer is received and must be processed
-            ProcessRecvPacket();
-            return;
-         }
-
-         if (fRecvState == recvHeader) {
-            // received header
-
-            SocketIOAddon* io = dynamic_cast<SocketIOAddon*> (fAddon());
-
-            if (fRecvHdr.dabc_header == dabc::SocketDevice::headerConnect) {
-
-               if (fDebugMode)
-                  DOUT0("cmdclnt: get header with connect request via socket %d", io->Socket());
-
-               SocketCommandChannel* ch = dynamic_cast<SocketCommandChannel*> (GetParent());
-               if (!ch || ch->fRedirectDevice.empty()) {
-                  CloseClient(true, "Wrong socket device connect from network");
-                  return;
-               }
-
-               EnsureRecvBuffer(dabc::SocketDevice::ProtocolMsgSize);
-               memcpy(fRecvBuf, &fRecvHdr, sizeof(fRecvHdr));
-               fRecvState = recvDevConnect;
-               io->StartRecv(fRecvBuf + sizeof(fRecvHdr), dabc::SocketDevice::ProtocolMsgSize - sizeof(fRecvHdr));
-               return;
-            }
-
-            if (fRecvHdr.dabc_header != headerDabc) {
-               CloseClient(true, "Wrong packet from network");
-               return;
-             }
-
-            if (fRecvHdr.data_size == 0) {
-               fRecvState = recvInit;
-               // when no additional data, process packet
-               ProcessRecvPacket();
-               return;
-            }
-
-            if (!EnsureRecvBuffer(fRecvHdr.data_size)) {
-               CloseClient(true, "memory allocation");
-               return;
-            }
-
-            fRecvState = recvData;
-            io->StartRecv(fRecvBuf, fRecvHdr.data_size);
-
-            // DOUT0("Start command recv data_size %u", fRecvHdr.data_size);
-         }
-
-         if (fRecvState == recvDevConnect) {
-            // here we should get all data for connection
-            // redirect it to the device
-
-            SocketCommandChannel* ch = dynamic_cast<SocketCommandChannel*> (GetParent());
-            SocketIOAddon* io = dynamic_cast<SocketIOAddon*> (fAddon());
-
-            if (fDebugMode)
-               DOUT0("cmdclnt: get full connect request, redirect socket %d", io->Socket());
-
-            dabc::Command cmd("RedirectConnect");
-            cmd.SetInt("Socket", io->TakeSocket());
-            cmd.SetRawData(dabc::Buffer::CreateBuffer(fRecvBuf, dabc::SocketDevice::ProtocolMsgSize, false, true));
-
-            cmd.SetReceiver(ch->fRedirectDevice);
-            dabc::mgr.Submit(cmd);
-
-            CloseClient(false, "redirect connect");
-         }
+      case evntActivate:
+         fSendActivated = false;
+         SendSubmittedCommands();
+         break;
 
+      case SocketAddon::evntSocketRecvInfo:
+         ProcessRecvData();
          break;
-      }
 
       case SocketAddon::evntSocketErrorInfo:
          CloseClient(true, "Socket error");
@@ -424,19 +489,69 @@ void dabc::SocketCommandClient::AddCommand(dabc::Command cmd, bool asreply)
 {
    fSendQueue.Push(cmd, asreply ? CommandsQueue::kindReply : CommandsQueue::kindSubmit);
 
-   SendSubmittedCommands();
+   // do not send immediately, commands submitted in the meantime will be sent together
+   if (!fSendingActive && !fSendActivated) {
+      fSendActivated = true;
+      FireEvent(evntActivate);
+   }
 }
 
 
 void dabc::SocketCommandClient::SendSubmittedCommands()
 {
-   while (!fSendingActive && (fSendQueue.Size()>0)) {
+   if (fSendingActive) return;
+
+   while ((fSendQueue.Size()>0) && (fSendRecsNum < MaxSendBatch)) {
       bool isreply = (fSendQueue.FrontKind() == CommandsQueue::kindReply);
-      SendCommand(fSendQueue.Pop(), isreply);
+      PrepareCommand(fSendQueue.Pop(), isreply);
+   }
+
+   if (fSendRecsNum == 0) return;
+
+   SocketIOAddon* addon = dynamic_cast<SocketIOAddon*> (fAddon());
+
+   if (!addon) {
+      EOUT("Cannot send %u commands addon %p", fSendRecsNum, fAddon());
+
+      CloseClient(true, "I/O object missing");
+      return;
    }
+
+   // all headers and data are sent with single operation
+   // replies are matched with __send_cmdid__, therefore order of execution on remote side is not important
+   fSendIOV.clear();
+
+   for (unsigned n = 0; n < fSendRecsNum; n++) {
+      SendRec &rec = fSendRecs[n];
+      struct iovec iov;
+      iov.iov_base = &rec.hdr;
+      iov.iov_len = sizeof(rec.hdr);
+      fSendIOV.push_back(iov);
+
+      if (rec.hdr.data_cmdsize > 0) {
+         iov.iov_base = rec.buf.SegmentPtr();
+         iov.iov_len = rec.hdr.data_cmdsize;
+         fSendIOV.push_back(iov);
+      }
+
+      for (unsigned nseg = 0; nseg < rec.raw.NumSegments(); nseg++) {
+         iov.iov_base = rec.raw.SegmentPtr(nseg);
+         iov.iov_len = rec.raw.SegmentSize(nseg);
+         fSendIOV.push_back(iov);
+      }
+   }
+
+   // DOUT0("Start send of %u commands fullsize:%u", fSendRecsNum, fSendIOV.size());
+
+   if (!addon->StartSendV(fSendIOV.data(), fSendIOV.size())) {
+      CloseClient(true, "Fail to send command");
+      return;
+   }
+
+   fSendingActive = true;
 }
 
-void dabc::SocketCommandClient::SendCommand(dabc::Command cmd, bool asreply)
+void dabc::SocketCommandClient::PrepareCommand(dabc::Command cmd, bool asreply)
 {
    double send_tmout = 0;
 
@@ -452,51 +567,26 @@ void dabc::SocketCommandClient::SendCommand(dabc::Command cmd, bool asreply)
       cmd.SetUInt("__send_cmdid__", cmdid);
    }
 
-   //   DOUT0("RAWSEND cmd %s debugid %d", fSendQueue.Front().GetName(), fSendQueue.Front().GetInt("debugid"));
-
-   fSendHdr.dabc_header = headerDabc;
-   fSendHdr.data_kind = asreply ? kindReply : kindCommand;
-   fSendHdr.data_timeout = send_tmout > 0 ? (unsigned) send_tmout*1000. : 0;
-   fSendHdr.data_size = 0;
-   fSendHdr.data_cmdsize = 0;
-   fSendHdr.data_rawsize = 0;
-
-   fSendBuf.Release();
-   fSendRawData.Release();
-
-   if (cmd.IsCanceled()) fSendHdr.data_kind = kindCancel;
+   if (fSendRecsNum == fSendRecs.size())
+      fSendRecs.emplace_back();
 
-   fSendBuf = cmd.SaveToBuffer();
-
-   fSendRawData = cmd.GetRawData();
-
-   fSendHdr.data_cmdsize = fSendBuf.GetTotalSize(); // transport 0-terminated string as is
-   fSendHdr.data_rawsize = fSendRawData.GetTotalSize();
-   void* rawdata = nullptr;
-   if (fSendHdr.data_rawsize > 0) rawdata = fSendRawData.SegmentPtr();
-   fSendHdr.data_size = fSendHdr.data_cmdsize + fSendHdr.data_rawsize;
-
-   SocketIOAddon* addon = dynamic_cast<SocketIOAddon*> (fAddon());
+   SendRec &rec = fSendRecs[fSendRecsNum++];
 
-   if (!addon) {
-      EOUT("Cannot send command %s addon %p", cmd.GetName(), fAddon());
+   rec.hdr.dabc_header = (fSendVersion == storeversion_Compact) ? headerDabcCompact : headerDabc;
+   rec.hdr.data_kind = asreply ? kindReply : kindCommand;
+   rec.hdr.data_timeout = send_tmout > 0 ? (unsigned) (send_tmout*1000.) : 0;
 
-      CloseClient(true, "I/O object missing");
-      return;
-   }
+   if (cmd.IsCanceled()) rec.hdr.data_kind = kindCancel;
 
-   // DOUT0("Start command send fullsize:%u cmd:%u raw:%u", fSendHdr.data_size, fSendHdr.data_cmdsize, fSendHdr.data_rawsize);
+   rec.buf = cmd.SaveToBuffer(fSendVersion);
 
-   if (!addon->StartSend(&fSendHdr, sizeof(fSendHdr),
-         fSendBuf.SegmentPtr(), fSendHdr.data_cmdsize,
-         rawdata, fSendHdr.data_rawsize)) {
-      CloseClient(true, "Fail to send command");
-      return;
-   }
+   rec.raw = cmd.GetRawData();
 
-   // DOUT0("Send command %s asreply %s", cmd.GetName(), DBOOL(asreply));
+   rec.hdr.data_cmdsize = rec.buf.GetTotalSize(); // transport 0-terminated string as is
+   rec.hdr.data_rawsize = rec.raw.GetTotalSize();
+   rec.hdr.data_size = rec.hdr.data_cmdsize + rec.hdr.data_rawsize;
 
-   fSendingActive = true;
+   // DOUT0("Prepare command %s asreply %s", cmd.GetName(), DBOOL(asreply));
 }
 
 
@@ -194,10 +194,12 @@ dabc::SocketDevice::SocketDevice(const std::string &name, Command cmd) :
    fProtocols(),
    fConnCounter(0),
    fCmdChannelId(),
-   fDebugMode(false)
+   fDebugMode(false),
+   fZeroCopy(0)
 {
    fBindHost = Cfg("host", cmd).AsStr();
    fBindPort = Cfg("port", cmd).AsInt(-1);
+   fZeroCopy = Cfg("zerocopy", cmd).AsUInt(0);
 
    if (fBindHost.empty() && (fBindPort < 0)) {
       dabc::WorkerRef chl = dabc::mgr.GetCommandChannel();
@@ -550,6 +552,8 @@ bool dabc::SocketDevice::ProtocolCompleted(SocketProtocolAddon* proc, const char
 
       SocketNetworkInetrface* addon = new SocketNetworkInetrface(fd);
 
+      if (fZeroCopy > 0) addon->SetZeroCopy(fZeroCopy);
+
       res = dabc::NetworkTransport::Make(req, addon, ThreadName());
 
       DOUT0("Create socket transport for fd %d res %s", fd, DBOOL(res));
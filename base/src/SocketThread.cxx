@@ -21,11 +21,20 @@
 #include <fcntl.h>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <unistd.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <linux/errqueue.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define DABC_SOCKET_ZEROCOPY
+#endif
+#endif
+
 #include "dabc/Configuration.h"
 
 #if defined(__MACH__) /* Apple OSX section */
@@ -77,9 +86,12 @@ dabc::SocketAddon::SocketAddon(int fd) :
    fSocket(fd),
    fDoingInput(false),
    fDoingOutput(false),
+   fDoingErrQueue(false),
    fIOPriority(1),
    fDeliverEventsToWorker(false),
-   fDeleteWorkerOnClose(false)
+   fDeleteWorkerOnClose(false),
+   fEpollThrd(nullptr),
+   fEpollIndx(0)
 {
 }
 
@@ -102,19 +114,40 @@ void dabc::SocketAddon::ProcessEvent(const EventId& evnt)
          OnSocketError(-1, "get error event");
          break;
 
+      case evntSocketErrQueue:
+         break;
+
       default:
          WorkerAddon::ProcessEvent(evnt);
    }
 }
 
+void dabc::SocketAddon::InterestChanged()
+{
+   if (fEpollThrd) fEpollThrd->EpollMarkChanged(fEpollIndx);
+}
+
+void dabc::SocketAddon::SocketWouldBlock(bool input)
+{
+#if defined(__linux__)
+   if (fEpollThrd && (fEpollIndx < fEpollThrd->fEpollRecs.size()))
+      fEpollThrd->fEpollRecs[fEpollIndx].fired &= input ? ~(uint32_t) (EPOLLIN | EPOLLPRI) : ~(uint32_t) EPOLLOUT;
+#else
+   (void) input;
+#endif
+}
+
 void dabc::SocketAddon::SetSocket(int fd)
 {
    CloseSocket();
    fSocket = fd;
+   InterestChanged();
 }
 
 int dabc::SocketAddon::TakeSocket()
 {
+   if (fEpollThrd) fEpollThrd->EpollRemoveSocket(fEpollIndx);
+
    int fd = fSocket;
    fSocket = -1;
    return fd;
@@ -124,6 +157,9 @@ void dabc::SocketAddon::CloseSocket()
 {
    if (fSocket<0) return;
 
+   // socket must be removed from epoll before it is closed - handle can be reused immediately
+   if (fEpollThrd) fEpollThrd->EpollRemoveSocket(fEpollIndx);
+
    DOUT3("~~~~~~~~~~~~~~~~ Close socket %d", fSocket);
    close(fSocket);
    fSocket = -1;
@@ -167,6 +203,7 @@ ssize_t dabc::SocketAddon::DoRecvBuffer(void* buf, ssize_t len)
    if (res==0) OnSocketError(0, "closed during recv()"); else
    if (res<0) {
       if (errno!=EAGAIN) OnSocketError(errno, "when recv()");
+                    else SocketWouldBlock(true);
    }
 
    return res;
@@ -197,6 +234,7 @@ ssize_t dabc::SocketAddon::DoRecvBufferHdr(void* hdr, ssize_t hdrlen, void* buf,
    if (res==0) OnSocketError(0, "when recvmsg()"); else
    if (res<0) {
       if (errno!=EAGAIN) OnSocketError(errno, "when recvmsg()");
+                    else SocketWouldBlock(true);
    }
 
    return res;
@@ -209,6 +247,7 @@ ssize_t dabc::SocketAddon::DoSendBuffer(void* buf, ssize_t len)
    if (res==0) OnSocketError(0, "when send()"); else
    if (res<0) {
       if (errno!=EAGAIN) OnSocketError(errno, "When send()");
+                    else SocketWouldBlock(false);
    }
 
    return res;
@@ -240,6 +279,7 @@ ssize_t dabc::SocketAddon::DoSendBufferHdr(void* hdr, ssize_t hdrlen, void* buf,
    if (res==0) OnSocketError(0, "when sendmsg()"); else
    if (res<0) {
       if (errno!=EAGAIN) OnSocketError(errno, "When sendmsg()");
+                    else SocketWouldBlock(false);
    }
 
    return res;
@@ -263,7 +303,15 @@ dabc::SocketIOAddon::SocketIOAddon(int fd, bool isdatagram, bool usemsg) :
    fRecvIOVSize(0),
    fRecvIOVFirst(0),
    fRecvIOVNumber(0),
-   fLastRecvSize(0)
+   fLastRecvSize(0),
+   fRecvAnySize(false),
+   fZeroCopyMin(0),
+   fSendZCFirst(0),
+   fSendZCBuf(),
+   fZCCounter(0),
+   fZCStart(0),
+   fZCDone(0),
+   fZCPending()
 {
    if (IsDatagramSocket() && !fUseMsgOper) {
       EOUT("Dangerous - datagram socket MUST use sendmsg()/recvmsg() operation to be able send/recv segmented buffers, force");
@@ -294,6 +342,11 @@ dabc::SocketIOAddon::~SocketIOAddon()
 
    DOUT4("Destroying SocketIOAddon %p fd:%d", this, Socket());
 
+   if (!fZCPending.empty())
+      DOUT2("Socket %d release %u buffers without zero-copy completion", Socket(), (unsigned) fZCPending.size());
+   fZCPending.clear();
+   fSendZCBuf.Release();
+
    AllocateSendIOV(0);
    AllocateRecvIOV(0);
 }
@@ -411,6 +464,35 @@ bool dabc::SocketIOAddon::StartRecv(void* buf, size_t size)
    return StartRecvHdr(0, 0, buf, size);
 }
 
+bool dabc::SocketIOAddon::StartSendV(const struct iovec* iov, unsigned num)
+{
+   if (fSendIOVNumber>0) {
+      EOUT("Current send operation not yet completed");
+      return false;
+   }
+
+   if (fSendIOVSize<num) AllocateSendIOV(num < 8 ? 8 : num);
+
+   unsigned indx = 0;
+   for (unsigned n=0;n<num;n++) {
+      if (!iov[n].iov_base || (iov[n].iov_len==0)) continue;
+      fSendIOV[indx++] = iov[n];
+   }
+
+   if (indx==0) {
+      EOUT("No buffer specified");
+      return false;
+   }
+
+   fSendUseMsg = fUseMsgOper;
+   fSendIOVFirst = 0;
+   fSendIOVNumber = indx;
+
+   SetDoingOutput(true);
+
+   return true;
+}
+
 bool dabc::SocketIOAddon::StartSend(const Buffer& buf)
 {
    // this is simple version,
@@ -443,6 +525,7 @@ bool dabc::SocketIOAddon::StartRecvHdr(void* hdr, unsigned hdrsize, void* buf, s
    fRecvUseMsg = fUseMsgOper;
    fRecvIOVFirst = 0;
    fRecvIOVNumber = indx;
+   fRecvAnySize = false;
 
    // TODO: Should we inform thread directly that we want to recv data??
    SetDoingInput(true);
@@ -450,6 +533,42 @@ bool dabc::SocketIOAddon::StartRecvHdr(void* hdr, unsigned hdrsize, void* buf, s
    return true;
 }
 
+bool dabc::SocketIOAddon::StartRecvV(const struct iovec* iov, unsigned num)
+{
+   if (fRecvIOVNumber>0) {
+      EOUT("Current recv operation not yet completed");
+      return false;
+   }
+
+   if (fRecvIOVSize<num) AllocateRecvIOV(num < 8 ? 8 : num);
+
+   unsigned indx = 0;
+   for (unsigned n=0;n<num;n++) {
+      if (!iov[n].iov_base || (iov[n].iov_len==0)) continue;
+      fRecvIOV[indx++] = iov[n];
+   }
+
+   if (indx==0) {
+      EOUT("No buffer specified");
+      return false;
+   }
+
+   fRecvUseMsg = fUseMsgOper;
+   fRecvIOVFirst = 0;
+   fRecvIOVNumber = indx;
+   fRecvAnySize = false;
+
+   SetDoingInput(true);
+
+   return true;
+}
+
+bool dabc::SocketIOAddon::StartRecvAny(void* buf, size_t size)
+{
+   if (!StartRecvHdr(0, 0, buf, size)) return false;
+   fRecvAnySize = true;
+   return true;
+}
 
 bool dabc::SocketIOAddon::StartRecv(Buffer& buf, BufferSize_t datasize)
 {
@@ -493,6 +612,7 @@ bool dabc::SocketIOAddon::StartNetRecv(void* hdr, unsigned hdrsize, Buffer& buf,
    }
 
    fRecvIOVNumber = indx;
+   fRecvAnySize = false;
 
    // TODO: Should we inform thread directly that we want to recv data??
    SetDoingInput(true);
@@ -530,12 +650,96 @@ bool dabc::SocketIOAddon::StartNetSend(void* hdr, unsigned hdrsize, const Buffer
 
    fSendIOVNumber = indx;
 
+   // buffer memory used by kernel after send is completed, keep reference until completion is confirmed
+   if (IsZeroCopy() && fSendUseMsg && (buf.GetTotalSize() >= fZeroCopyMin)) {
+      fSendZCFirst = indx - buf.NumSegments();
+      fSendZCBuf = buf;
+      fZCStart = fZCCounter;
+   }
+
    // TODO: Should we inform thread that we want to send data??
    SetDoingOutput(true);
 
    return true;
 }
 
+bool dabc::SocketIOAddon::SetZeroCopy(unsigned minsize)
+{
+   fZeroCopyMin = 0;
+
+   if (minsize == 0) return true;
+
+#ifdef DABC_SOCKET_ZEROCOPY
+   int on = 1;
+   if (!IsDatagramSocket() && fUseMsgOper && (Socket() >= 0) &&
+       (setsockopt(Socket(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0)) {
+      fZeroCopyMin = minsize;
+      return true;
+   }
+   DOUT1("Socket %d does not support zero-copy send, use normal send", Socket());
+#else
+   DOUT1("Zero-copy send not supported on this platform, use normal send");
+#endif
+
+   return false;
+}
+
+void dabc::SocketIOAddon::FinishZeroCopySend()
+{
+   if (fSendZCBuf.null()) return;
+
+   // when no call was done with MSG_ZEROCOPY, buffer can be released immediately
+   if (fZCCounter == fZCStart) {
+      fSendZCBuf.Release();
+      return;
+   }
+
+   fZCPending.push_back(ZeroCopyRec());
+   fZCPending.back().buf << fSendZCBuf;
+   fZCPending.back().last = fZCCounter - 1;
+}
+
+void dabc::SocketIOAddon::ProcessZeroCopyCompl()
+{
+#ifdef DABC_SOCKET_ZEROCOPY
+   char control[128];
+
+   while (fSocket >= 0) {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+
+      if (recvmsg(fSocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+
+      for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+         if (!(((cm->cmsg_level == SOL_IP) && (cm->cmsg_type == IP_RECVERR)) ||
+               ((cm->cmsg_level == SOL_IPV6) && (cm->cmsg_type == IPV6_RECVERR)))) continue;
+
+         struct sock_extended_err *serr = (struct sock_extended_err *) CMSG_DATA(cm);
+         if ((serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)) continue;
+
+         // notification covers range of calls [ee_info, ee_data], completions are delivered in order
+         if ((int32_t) (serr->ee_data + 1 - fZCDone) > 0) fZCDone = serr->ee_data + 1;
+
+         // kernel was forced to copy data (for instance, loopback device) - no gain from zero-copy
+         if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && IsZeroCopy()) {
+            DOUT2("Socket %d data copied by kernel, disable zero-copy send", fSocket);
+            fZeroCopyMin = 0;
+         }
+      }
+   }
+#endif
+
+   while (!fZCPending.empty() && ((int32_t) (fZCPending.front().last - fZCDone) < 0))
+      fZCPending.pop_front();
+
+   SetDoingErrQueue(fZCDone != fZCCounter);
+
+   int err = TakeSocketError();
+   if (err > 0) OnSocketError(err, "socket error queue");
+}
+
 void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
 {
 //   DOUT0("IO addon:%p process event %u", this, evnt.GetCode());
@@ -606,6 +810,7 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
              } else {
                 // we indicating that we want to receive data but there is nothing to read
                 // why we get message at all?
+                SocketWouldBlock(true);
                 SetDoingInput(true);
                 EOUT("Why socket read message produce but we do not get any data??");
              }
@@ -615,8 +820,9 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
 
           fLastRecvSize = res;
 
-          if (IsDatagramSocket()) {
+          if (IsDatagramSocket() || fRecvAnySize) {
              // for datagram the only recv message is possible
+             // also operation completes with any portion of data when requested
              fRecvIOVFirst = 0;
              fRecvIOVNumber = 0;
 
@@ -657,6 +863,8 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
           }
 
           // there is still some portion of data should be read from the socket, indicate this for the thread
+          // partial read of stream socket means that socket is empty now
+          SocketWouldBlock(true);
           SetDoingInput(true);
 
           break;
@@ -675,21 +883,53 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
              EOUT("HARD PROBLEM when trying write socket");
           }
 
+          unsigned sendlast = fSendIOVNumber;
+
+       do_send:
+
           ssize_t res = 0;
 
           if (fSendUseMsg) {
 
              struct msghdr msg;
 
+             int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+             sendlast = fSendIOVNumber;
+
+#ifdef DABC_SOCKET_ZEROCOPY
+             // header memory can be reused by caller immediately, therefore it always copied by separate call
+             if (!fSendZCBuf.null()) {
+                if (fSendIOVFirst < fSendZCFirst) {
+                   sendlast = fSendZCFirst;
+                   flags |= MSG_MORE;
+                } else {
+                   flags |= MSG_ZEROCOPY;
+                }
+             }
+#endif
+
              msg.msg_name = fSendUseAddr ? &fSendAddr : 0;
              msg.msg_namelen = fSendUseAddr ? sizeof(fSendAddr) : 0;
              msg.msg_iov = &(fSendIOV[fSendIOVFirst]);
-             msg.msg_iovlen = fSendIOVNumber - fSendIOVFirst;
+             msg.msg_iovlen = sendlast - fSendIOVFirst;
              msg.msg_control = 0;
              msg.msg_controllen = 0;
              msg.msg_flags = 0;
 
-             res = sendmsg(fSocket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+             res = sendmsg(fSocket, &msg, flags);
+
+#ifdef DABC_SOCKET_ZEROCOPY
+             if (flags & MSG_ZEROCOPY) {
+                if (res >= 0) {
+                   // every successful call produces completion notification
+                   fZCCounter++;
+                   SetDoingErrQueue(true);
+                } else if (errno == ENOBUFS) {
+                   // limit of locked memory or notifications reached, send with copy
+                   res = sendmsg(fSocket, &msg, flags & ~MSG_ZEROCOPY);
+                }
+             }
+#endif
           } else
              res = send(fSocket, fSendIOV[fSendIOVFirst].iov_base, fSendIOV[fSendIOVFirst].iov_len, MSG_DONTWAIT | MSG_NOSIGNAL);
 
@@ -713,6 +953,7 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
              } else {
                 // we indicating that we want to receive data but there is nothing to read
                 // why we get message at all?
+                SocketWouldBlock(false);
                 SetDoingOutput(true);
                 EOUT("Why socket write message produce but we did not send any bytes?");
              }
@@ -735,6 +976,8 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
                    fSendIOVFirst = 0;
                    fSendIOVNumber = 0;
 
+                   FinishZeroCopySend();
+
                    OnSendCompleted();
 
                    return;
@@ -746,11 +989,21 @@ void dabc::SocketIOAddon::ProcessEvent(const EventId& evnt)
              }
           }
 
+          // header was sent completely, continue with zero-copy part
+          if ((fSendIOVFirst == sendlast) && (sendlast < fSendIOVNumber)) goto do_send;
+
           // we are informing that there is some data still to send
+          // partial send means that socket buffer is full now
+          SocketWouldBlock(false);
           SetDoingOutput(true);
 
           break;
        }
+
+       case evntSocketErrQueue:
+          ProcessZeroCopyCompl();
+          break;
+
        default:
           SocketAddon::ProcessEvent(evnt);
     }
@@ -760,6 +1013,9 @@ void dabc::SocketIOAddon::CancelIOOperations()
 {
    fSendIOVNumber = 0;
    fRecvIOVNumber = 0;
+
+   // memory of partially sent buffer still can be used by the kernel
+   FinishZeroCopySend();
 }
 
 // ___________________________________________________________________
@@ -1081,7 +1337,14 @@ dabc::SocketThread::SocketThread(Reference parent, const std::string &name, Comm
    f_recs(0),
    fIsAnySocket(false),
    fCheckNewEvents(true),
-   fBalanceCnt(0)
+   fBalanceCnt(0),
+   fEpoll(-1),
+   fEpollEdge(false),
+   f_sizeevnts(0),
+   f_evnts(nullptr),
+   fEpollRecs(),
+   fEpollChanged(),
+   fEpollPending()
 {
 
 #ifdef SOCKET_PROFILING
@@ -1090,6 +1353,7 @@ dabc::SocketThread::SocketThread(Reference parent, const std::string &name, Comm
    fWaitTime = 0;
    fFillTime = 0;
    fPipeCalled = 0;
+   fCtlCalls = 0;
 #endif
 
    fPipe[0] = 0;
@@ -1097,6 +1361,35 @@ dabc::SocketThread::SocketThread(Reference parent, const std::string &name, Comm
    auto res = pipe(fPipe);
    (void) res; // ignore compiler warnings
 
+   std::string backend = ThreadCfg("poll", cmd).AsStr("poll");
+
+   if ((backend == "epoll") || (backend == "epollet")) {
+#if defined(__linux__)
+      fEpoll = epoll_create1(EPOLL_CLOEXEC);
+      if (fEpoll < 0) {
+         EOUT("Thread %s fail to create epoll handle %s, use poll", GetName(), strerror(errno));
+      } else {
+         fEpollEdge = (backend == "epollet");
+
+         struct epoll_event ev;
+         memset(&ev, 0, sizeof(ev));
+         ev.events = EPOLLIN;
+         ev.data.u64 = 0; // pipe always has index 0
+         if (epoll_ctl(fEpoll, EPOLL_CTL_ADD, fPipe[0], &ev) != 0) {
+            EOUT("Thread %s fail to register pipe in epoll %s, use poll", GetName(), strerror(errno));
+            close(fEpoll);
+            fEpoll = -1;
+         } else {
+            DOUT2("Thread %s uses %s backend", GetName(), backend.c_str());
+         }
+      }
+#else
+      EOUT("Thread %s epoll backend not supported on this platform, use poll", GetName());
+#endif
+   } else if (backend != "poll") {
+      EOUT("Thread %s unknown poll backend %s, use poll", GetName(), backend.c_str());
+   }
+
    // by this call we rebuild ufds array, for now only for the pipe
    WorkersSetChanged();
 
@@ -1120,10 +1413,23 @@ dabc::SocketThread::~SocketThread()
       f_sizeufds = 0;
    }
 
+   // addons may live longer than thread, they should not inform it anymore
+   for (auto &rec : fEpollRecs)
+      if (rec.addon) rec.addon->fEpollThrd = nullptr;
+   fEpollRecs.clear();
+
+   if (fEpoll >= 0) { close(fEpoll); fEpoll = -1; }
+
+   #if defined(__linux__)
+   delete[] f_evnts;
+   #endif
+   f_evnts = nullptr;
+   f_sizeevnts = 0;
+
    #ifdef SOCKET_PROFILING
      DOUT1("Thrd:%s Wait called %ld done %ld ratio %5.3f %s  Pipe:%ld", GetName(), fWaitCalls, fWaitDone, (fWaitCalls>0 ? 100.*fWaitDone/fWaitCalls : 0.) ,"%", fPipeCalled);
      if (fWaitDone>0)
-        DOUT1("Aver times fill:%5.1f microsec wait:%5.1f microsec", fFillTime*1e6/fWaitDone, fWaitTime*1e6/fWaitDone);
+        DOUT1("Aver times fill:%5.1f microsec wait:%5.1f microsec epoll_ctl calls:%ld", fFillTime*1e6/fWaitDone, fWaitTime*1e6/fWaitDone, fCtlCalls);
    #endif
 }
 
@@ -1480,6 +1786,29 @@ void dabc::SocketThread::_Fire(const dabc::EventId& arg, int nq)
 }
 
 bool dabc::SocketThread::WaitEvent(EventId& evnt, double tmout_sec)
+{
+   // events, drained before from the queues, processed without locking
+   if (TakeDrainedEvent(evnt)) return true;
+
+   if ((fSpinTime != 0.) && (tmout_sec != 0.)) {
+      // spin-then-block mode, sockets are checked without blocking until spin limit is reached
+      TimeStamp start = dabc::Now();
+      double limit = SpinLimit(tmout_sec);
+
+      do {
+         if (WaitSocketEvent(evnt, 0.)) return true;
+      } while ((limit < 0.) || (start.SpentTillNow() < limit));
+
+      if (tmout_sec > 0.) {
+         tmout_sec -= start.SpentTillNow();
+         if (tmout_sec <= 0.) return false;
+      }
+   }
+
+   return WaitSocketEvent(evnt, tmout_sec);
+}
+
+bool dabc::SocketThread::WaitSocketEvent(EventId& evnt, double tmout_sec)
 {
    // first check, if we have already event, which must be processed
 
@@ -1514,9 +1843,12 @@ bool dabc::SocketThread::WaitEvent(EventId& evnt, double tmout_sec)
 
       if (f_ufds==0) return false;
 
-      fWaitFire = true;
+      // pipe is only required when thread may block
+      fWaitFire = (tmout_sec != 0.);
    }
 
+   if (fEpoll >= 0) return EpollWaitEvent(evnt, tmout_sec);
+
    // here we wait for next event from any socket, including pipe
 
    int numufds = 1;
@@ -1529,7 +1861,7 @@ bool dabc::SocketThread::WaitEvent(EventId& evnt, double tmout_sec)
       if (!f_recs[n].use) continue;
       SocketAddon* addon = (SocketAddon*) fWorkers[n]->addon;
 
-      if (addon->Socket()<=0) continue;
+      if (addon->Socket()<0) continue;
 
       short events = 0;
 
@@ -1539,6 +1871,10 @@ bool dabc::SocketThread::WaitEvent(EventId& evnt, double tmout_sec)
       if (addon->IsDoingOutput())
          events |= POLLOUT;
 
+      // POLLERR always reported, flag only keeps socket in the list
+      if (addon->IsDoingErrQueue())
+         events |= POLLERR;
+
       if (events==0) continue;
 
       f_ufds[numufds].fd = addon->Socket();
@@ -1605,7 +1941,13 @@ bool dabc::SocketThread::WaitEvent(EventId& evnt, double tmout_sec)
          }
 
 
-         if (f_ufds[n].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+         if (((f_ufds[n].revents & (POLLERR | POLLHUP | POLLNVAL)) == POLLERR) && addon->IsDoingErrQueue()) {
+            // error flag set while socket error queue has zero-copy completions
+            _PushEvent(EventId(SocketAddon::evntSocketErrQueue, f_recs[n].indx), addon->fIOPriority);
+            addon->SetDoingErrQueue(false);
+            IncWorkerFiredEvents(worker);
+            isany = true;
+         } else if (f_ufds[n].revents & (POLLERR | POLLHUP | POLLNVAL)) {
 //            EOUT("Error on the socket %d", f_ufds[n].fd);
             _PushEvent(EventId(SocketAddon::evntSocketError, f_recs[n].indx), 0);
             addon->SetDoingInput(false);
@@ -1691,9 +2033,270 @@ void dabc::SocketThread::WorkersSetChanged()
       }
    }
 
+   if (fEpoll >= 0) {
+      if (fEpollRecs.size() < fWorkers.size())
+         fEpollRecs.resize(fWorkers.size());
+
+      for (unsigned indx = 1; indx < fEpollRecs.size(); indx++) {
+         SocketAddon* addon = (indx < fWorkers.size()) && f_recs[indx].use ? (SocketAddon*) fWorkers[indx]->addon : nullptr;
+
+         EpollRec &rec = fEpollRecs[indx];
+         if (rec.addon == addon) continue;
+
+         // old addon still exists, but no longer belongs to the worker
+         if (rec.addon) {
+            EpollRemoveSocket(indx);
+            rec.addon->fEpollThrd = nullptr;
+         }
+
+         rec.addon = addon;
+         rec.ready = 0;
+         rec.fired = 0;
+
+         if (addon) {
+            addon->fEpollThrd = this;
+            addon->fEpollIndx = indx;
+            EpollMarkChanged(indx);
+         }
+      }
+
+#if defined(__linux__)
+      if (f_sizeevnts < fWorkers.size() + 1) {
+         delete[] f_evnts;
+         f_sizeevnts = fWorkers.size() + 16;
+         f_evnts = new epoll_event[f_sizeevnts];
+      }
+#endif
+   }
+
    // any time new processor is added, check for new socket events
    fCheckNewEvents = fIsAnySocket;
 
 //   DOUT0("SocketThread %s WorkersNumberChanged %u done", GetName(), fWorkers.size());
 
 }
+
+void dabc::SocketThread::EpollRemoveSocket(unsigned indx)
+{
+   if (indx >= fEpollRecs.size()) return;
+
+   EpollRec &rec = fEpollRecs[indx];
+
+#if defined(__linux__)
+   if ((fEpoll >= 0) && (rec.fd >= 0)) {
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      if ((epoll_ctl(fEpoll, EPOLL_CTL_DEL, rec.fd, &ev) != 0) && (errno != EBADF) && (errno != ENOENT))
+         EOUT("Thread %s fail to remove socket %d from epoll %s", GetName(), rec.fd, strerror(errno));
+      #ifdef SOCKET_PROFILING
+         fCtlCalls++;
+      #endif
+   }
+#endif
+
+   rec.fd = -1;
+   rec.mask = 0;
+   rec.ready = 0;
+   rec.fired = 0;
+
+   // socket can be replaced by the addon
+   EpollMarkChanged(indx);
+}
+
+void dabc::SocketThread::EpollApplyChanges()
+{
+#if defined(__linux__)
+   // records can be marked as changed during processing
+   for (unsigned n = 0; n < fEpollChanged.size(); n++) {
+      unsigned indx = fEpollChanged[n];
+      EpollRec &rec = fEpollRecs[indx];
+      rec.changed = false;
+
+      SocketAddon *addon = rec.addon;
+
+      int fd = addon && (addon->Socket() >= 0) ? addon->Socket() : -1;
+      uint32_t mask = 0, want = 0;
+
+      if (fd >= 0) {
+         if (addon->IsDoingInput()) want |= EPOLLIN | EPOLLPRI;
+         if (addon->IsDoingOutput()) want |= EPOLLOUT;
+         if (addon->IsDoingErrQueue()) want |= EPOLLERR;
+         // in edge-triggered mode socket registered once, interest is checked when events are delivered
+         mask = fEpollEdge ? EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLET : want;
+      }
+
+      if ((rec.fd >= 0) && (rec.fd != fd)) EpollRemoveSocket(indx);
+
+      // in edge-triggered mode new edge only comes when addon read/write socket until EAGAIN,
+      // otherwise one should modify registration to let kernel check socket state again
+      bool rearm = fEpollEdge && (rec.mask != 0) && (rec.fd == fd) && ((rec.fired & want) != 0);
+      rec.fired &= ~want;
+
+      if ((rec.mask != mask) || rearm) {
+         struct epoll_event ev;
+         memset(&ev, 0, sizeof(ev));
+         ev.events = mask;
+         ev.data.u64 = ((uint64_t) fd) << 32 | indx;
+
+         int op = EPOLL_CTL_MOD;
+         if (mask == 0) op = EPOLL_CTL_DEL; else
+         if (rec.mask == 0) op = EPOLL_CTL_ADD;
+
+         int res = epoll_ctl(fEpoll, op, fd, &ev);
+
+         // socket may be registered with other worker index before
+         if ((res != 0) && (op == EPOLL_CTL_ADD) && (errno == EEXIST))
+            res = epoll_ctl(fEpoll, EPOLL_CTL_MOD, fd, &ev);
+         else if ((res != 0) && (op == EPOLL_CTL_MOD) && (errno == ENOENT))
+            res = epoll_ctl(fEpoll, EPOLL_CTL_ADD, fd, &ev);
+
+         #ifdef SOCKET_PROFILING
+            fCtlCalls++;
+         #endif
+
+         if ((res != 0) && (op != EPOLL_CTL_DEL))
+            EOUT("Thread %s fail to register socket %d in epoll %s", GetName(), fd, strerror(errno));
+
+         rec.fd = (mask != 0) && (res == 0) ? fd : -1;
+         rec.mask = (rec.fd >= 0) ? mask : 0;
+      }
+
+      if (fEpollEdge && (rec.ready & (want | EPOLLERR | EPOLLHUP)) && want)
+         fEpollPending.push_back(indx);
+   }
+
+   fEpollChanged.clear();
+#endif
+}
+
+bool dabc::SocketThread::_EpollDeliver(unsigned indx)
+{
+   bool isany = false;
+
+#if defined(__linux__)
+   if (indx >= fEpollRecs.size()) return false;
+
+   EpollRec &rec = fEpollRecs[indx];
+
+   SocketAddon *addon = rec.addon;
+   Worker *worker = (indx < fWorkers.size()) ? fWorkers[indx]->work : nullptr;
+
+   if (!addon || !worker) { rec.ready = 0; return false; }
+
+   uint32_t want = 0;
+   if (addon->IsDoingInput()) want |= EPOLLIN | EPOLLPRI;
+   if (addon->IsDoingOutput()) want |= EPOLLOUT;
+   if (want) want |= EPOLLERR | EPOLLHUP;
+   if (addon->IsDoingErrQueue()) want |= EPOLLERR;
+
+   uint32_t fire = rec.ready & want;
+
+   // in level-triggered mode kernel will report not delivered events again
+   rec.ready = fEpollEdge ? rec.ready & ~fire : 0;
+   if (fEpollEdge) rec.fired |= fire & (EPOLLIN | EPOLLPRI | EPOLLOUT);
+
+   if (((fire & (EPOLLERR | EPOLLHUP)) == EPOLLERR) && addon->IsDoingErrQueue()) {
+      // error flag set while socket error queue has zero-copy completions
+      _PushEvent(EventId(SocketAddon::evntSocketErrQueue, indx), addon->fIOPriority);
+      addon->SetDoingErrQueue(false);
+      IncWorkerFiredEvents(worker);
+      isany = true;
+   } else if (fire & (EPOLLERR | EPOLLHUP)) {
+      _PushEvent(EventId(SocketAddon::evntSocketError, indx), 0);
+      addon->SetDoingInput(false);
+      addon->SetDoingOutput(false);
+      IncWorkerFiredEvents(worker);
+      isany = true;
+   }
+
+   if (fire & (EPOLLIN | EPOLLPRI)) {
+      _PushEvent(EventId(SocketAddon::evntSocketRead, indx), addon->fIOPriority);
+      addon->SetDoingInput(false);
+      IncWorkerFiredEvents(worker);
+      isany = true;
+   }
+
+   if (fire & EPOLLOUT) {
+      _PushEvent(EventId(SocketAddon::evntSocketWrite, indx), addon->fIOPriority);
+      addon->SetDoingOutput(false);
+      IncWorkerFiredEvents(worker);
+      isany = true;
+   }
+#endif
+
+   return isany;
+}
+
+bool dabc::SocketThread::EpollWaitEvent(EventId& evnt, double tmout_sec)
+{
+   int epoll_res = 0;
+
+#if defined(__linux__)
+
+   #ifdef SOCKET_PROFILING
+     TimeStamp tm1 = dabc::Now();
+   #endif
+
+   EpollApplyChanges();
+
+   // pending events in edge-triggered mode must be delivered immediately
+   if (!fEpollPending.empty()) tmout_sec = 0.;
+
+   int tmout = tmout_sec < 0. ? -1 : int(tmout_sec*1000.);
+
+   #ifdef SOCKET_PROFILING
+     fWaitDone++;
+     TimeStamp tm2 = dabc::Now();
+     fFillTime += (tm2-tm1);
+   #endif
+
+   epoll_res = epoll_wait(fEpoll, f_evnts, f_sizeevnts, tmout);
+
+   #ifdef SOCKET_PROFILING
+     TimeStamp tm3 = dabc::Now();
+     fWaitTime += (tm3-tm2);
+   #endif
+
+#endif
+
+   dabc::LockGuard lock(ThreadMutex());
+
+   fWaitFire = false;
+
+   if (fPipeFired) {
+      char sbuf;
+      auto res = read(fPipe[0], &sbuf, 1);
+      (void) res; // suppress compiler warnings
+      fPipeFired = false;
+   }
+
+   bool isany = false;
+
+#if defined(__linux__)
+   for (int n = 0; n < epoll_res; n++) {
+      unsigned indx = f_evnts[n].data.u64 & 0xffffffffLU;
+      int fd = f_evnts[n].data.u64 >> 32;
+
+      if (indx == 0) continue; // pipe
+
+      // ignore events from sockets which were already removed
+      if ((indx >= fEpollRecs.size()) || (fEpollRecs[indx].fd != fd)) continue;
+
+      fEpollRecs[indx].ready |= f_evnts[n].events;
+
+      if (_EpollDeliver(indx)) isany = true;
+   }
+
+   for (auto indx : fEpollPending)
+      if (_EpollDeliver(indx)) isany = true;
+   fEpollPending.clear();
+#endif
+
+   // we put additional event to enable again sockets checking
+   if (isany) {
+      fCheckNewEvents = false;
+      _PushEvent(evntEnableCheck, 1);
+   }
+
+   return _GetNextEvent(evnt);
+}
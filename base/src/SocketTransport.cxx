@@ -25,6 +25,13 @@ dabc::SocketNetworkInetrface::SocketNetworkInetrface(int fd, bool datagram) :
    fRecvRecid(0),
    fSendStatus(0),
    fSendRecid(0),
+   fSendBatch(),
+   fSendBatchHdr(),
+   fRecvTable(),
+   fRecvBatchIndx(0),
+   fRecvHdrRec(false),
+   fRecvBatch(),
+   fBatchIOV(),
    fMcastAddr()
 {
 }
@@ -79,7 +86,8 @@ void dabc::SocketNetworkInetrface::SubmitRecv(uint32_t recid)
    fRecvQueue.Push(recid);
 
    // we are in transport thread and can call event-processing methods directly
-   if ((fRecvQueue.Size()==1) && (fRecvStatus==0)) OnRecvCompleted();
+   // batch receiving may wait for new records
+   if ((fRecvQueue.Size()==1) && ((fRecvStatus==0) || (fRecvStatus==5))) OnRecvCompleted();
 }
 
 
@@ -108,9 +116,26 @@ void dabc::SocketNetworkInetrface::OnSendCompleted()
       fSendStatus = 0;
    }
 
+   if (fSendStatus==2) {
+      for (unsigned n = 0; n < fSendBatch.size(); n++)
+         tr->ProcessSendCompl(fSendBatch[n]);
+      fSendBatch.clear();
+      fSendStatus = 0;
+   }
+
    // nothing to do, just wait for new submitted recv operation
    if (fSendQueue.Size() == 0) return;
 
+   // several records are waiting - send them together
+   if ((tr->GetBatchSize() > 1) && (fSendQueue.Size() > 1) && !IsDatagramSocket()) {
+      fSendStatus = 2;
+      if (!StartBatchSend(tr)) {
+         EOUT("Cannot start batch send - fatal error");
+         tr->CloseTransport(true);
+      }
+      return;
+   }
+
    fSendRecid = fSendQueue.Pop();
 
    fSendStatus = 1;
@@ -159,6 +184,25 @@ do_compl:
       fRecvStatus = 0;
    }
 
+   if (fRecvStatus==4) {
+      // complete all records of batch, received with last operation
+      for (unsigned n = 0; n < fRecvBatch.size(); n++)
+         tr->ProcessRecvCompl(fRecvBatch[n]);
+      fRecvBatch.clear();
+      fRecvStatus = (fRecvBatchIndx < fRecvTable.size()) ? 5 : 0;
+   }
+
+   if (fRecvStatus==3) {
+      // batch table is received, start with data of first entry
+      fRecvBatchIndx = 0;
+      fRecvStatus = 5;
+   }
+
+   if (fRecvStatus==5) {
+      if (StartBatchRecv(tr) == 2) goto do_compl;
+      return;
+   }
+
    if (fRecvStatus==1) {
       // analyze header, set new recv operation and so on
 
@@ -173,6 +217,22 @@ do_compl:
 
       NetworkTransport::NetworkHeader* nethdr = (NetworkTransport::NetworkHeader*) rec->header;
 
+      if (nethdr->kind & NetworkTransport::netot_Batch) {
+         unsigned num = nethdr->typid;
+         if ((num == 0) || (nethdr->size != num * sizeof(NetworkTransport::NetworkBatchEntry))) {
+            EOUT("Wrong batch header num %u size %u", num, nethdr->size);
+            tr->CloseTransport(true);
+            return;
+         }
+
+         // record used for header will get data of first entry
+         fRecvHdrRec = true;
+         fRecvStatus = 3;
+         fRecvTable.resize(num);
+         StartRecv(fRecvTable.data(), nethdr->size);
+         return;
+      }
+
       if (nethdr->typid == dabc::mbt_EOL) {
          DOUT1("Receive buffer with EOL bufsize = %u resthdr = %lu",
                  nethdr->size, (long unsigned) (tr->GetFullHeaderSize() - sizeof(NetworkTransport::NetworkHeader)));
@@ -223,3 +283,145 @@ do_compl:
    }
 }
 
+bool dabc::SocketNetworkInetrface::StartBatchSend(NetworkTransport* tr)
+{
+   unsigned num = fSendQueue.Size();
+   if (num > tr->GetBatchSize()) num = tr->GetBatchSize();
+
+   unsigned hdrsize = tr->GetFullHeaderSize(),
+            tblsize = num * sizeof(NetworkTransport::NetworkBatchEntry);
+
+   if (fSendBatchHdr.size() < hdrsize + tblsize)
+      fSendBatchHdr.resize(hdrsize + tblsize, 0);
+
+   NetworkTransport::NetworkHeader* hdr = (NetworkTransport::NetworkHeader*) fSendBatchHdr.data();
+   hdr->chkword = 123;
+   hdr->kind = NetworkTransport::netot_Batch;
+   hdr->typid = num;
+   hdr->size = tblsize;
+
+   NetworkTransport::NetworkBatchEntry* tbl = (NetworkTransport::NetworkBatchEntry*) (fSendBatchHdr.data() + hdrsize);
+
+   fBatchIOV.clear();
+   struct iovec iov;
+   iov.iov_base = fSendBatchHdr.data();
+   iov.iov_len = hdrsize + tblsize;
+   fBatchIOV.push_back(iov);
+
+   fSendBatch.clear();
+
+   for (unsigned n = 0; n < num; n++) {
+      uint32_t recid = fSendQueue.Pop();
+      fSendBatch.push_back(recid);
+
+      int sendtyp = tr->PackHeader(recid);
+      NetworkTransport::NetIORec* rec = tr->GetRec(recid);
+
+      if ((sendtyp==0) || (rec==0)) {
+         EOUT("record %u failed", recid);
+         return false;
+      }
+
+      NetworkTransport::NetworkHeader* rechdr = (NetworkTransport::NetworkHeader*) rec->header;
+      tbl[n].kind = rechdr->kind;
+      tbl[n].typid = rechdr->typid;
+      tbl[n].size = rechdr->size;
+
+      if ((rechdr->kind & NetworkTransport::netot_HdrSend) || (rechdr->size == 0)) continue;
+
+      if (sendtyp == 1) {
+         // data was copied into inline buffer
+         iov.iov_base = rec->inlinebuf;
+         iov.iov_len = rechdr->size;
+         fBatchIOV.push_back(iov);
+         continue;
+      }
+
+      BufferSize_t datasize = rechdr->size;
+      for (unsigned nseg = 0; (nseg < rec->buf.NumSegments()) && (datasize > 0); nseg++) {
+         iov.iov_base = rec->buf.SegmentPtr(nseg);
+         iov.iov_len = rec->buf.SegmentSize(nseg) < datasize ? rec->buf.SegmentSize(nseg) : datasize;
+         fBatchIOV.push_back(iov);
+         datasize -= iov.iov_len;
+      }
+   }
+
+   return StartSendV(fBatchIOV.data(), fBatchIOV.size());
+}
+
+int dabc::SocketNetworkInetrface::StartBatchRecv(NetworkTransport* tr)
+{
+   fBatchIOV.clear();
+   fRecvBatch.clear();
+
+   struct iovec iov;
+
+   while (fRecvBatchIndx < fRecvTable.size()) {
+      uint32_t recid;
+
+      if (fRecvHdrRec) {
+         recid = fRecvRecid;
+         fRecvHdrRec = false;
+      } else {
+         // wait until new records are submitted
+         if (fRecvQueue.Size() == 0) break;
+         recid = fRecvQueue.Pop();
+      }
+
+      NetworkTransport::NetIORec* rec = tr->GetRec(recid);
+      if (rec==0) {
+         EOUT("Completely wrong recv recid %u", recid);
+         exit(432);
+      }
+
+      fRecvBatch.push_back(recid);
+
+      // fill header of the record, as it would be received directly
+      const NetworkTransport::NetworkBatchEntry &entry = fRecvTable[fRecvBatchIndx++];
+      NetworkTransport::NetworkHeader* nethdr = (NetworkTransport::NetworkHeader*) rec->header;
+      nethdr->chkword = 123;
+      nethdr->kind = entry.kind;
+      nethdr->typid = entry.typid;
+      nethdr->size = entry.size;
+
+      if ((entry.kind & NetworkTransport::netot_HdrSend) || (entry.size == 0)) continue;
+
+      if (entry.size <= tr->GetInlineDataSize()) {
+         // small data was sent from inline buffer and will be copied from it
+         iov.iov_base = rec->inlinebuf;
+         iov.iov_len = entry.size;
+         fBatchIOV.push_back(iov);
+         continue;
+      }
+
+      if (entry.size > rec->buf.GetTotalSize()) {
+         EOUT("Fatal - no buffer to receive batch data rec %u  sz1:%u sz2:%u",
+               recid, entry.size, rec->buf.GetTotalSize());
+         tr->CloseTransport(true);
+         return 0;
+      }
+
+      BufferSize_t datasize = entry.size;
+      for (unsigned nseg = 0; (nseg < rec->buf.NumSegments()) && (datasize > 0); nseg++) {
+         iov.iov_base = rec->buf.SegmentPtr(nseg);
+         iov.iov_len = rec->buf.SegmentSize(nseg) < datasize ? rec->buf.SegmentSize(nseg) : datasize;
+         fBatchIOV.push_back(iov);
+         datasize -= iov.iov_len;
+      }
+   }
+
+   // no records available, SubmitRecv will continue
+   if (fRecvBatch.size() == 0) return 0;
+
+   fRecvStatus = 4;
+
+   if (fBatchIOV.size() == 0) return 2;
+
+   if (!StartRecvV(fBatchIOV.data(), fBatchIOV.size())) {
+      EOUT("Cannot start batch recv - fatal error");
+      tr->CloseTransport(true);
+      return 0;
+   }
+
+   return 1;
+}
@@ -18,6 +18,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
@@ -56,11 +57,16 @@ class dabc::Thread::ExecWorker : public dabc::Worker {
 
       int fCnt;
 
+      uint64_t fLastEvents;  ///! events counter at previous publishing
+      uint64_t fLastLocks;   ///! locks counter at previous publishing
+
    public:
       ExecWorker(Thread* parent, Command cmd) :
          dabc::Worker(parent, "Exec"),
          fPublish(false),
-         fCnt(0)
+         fCnt(0),
+         fLastEvents(0),
+         fLastLocks(0)
       {
          SetWorkerPriority(0);
          // special case - thread keep only pointer
@@ -151,6 +157,10 @@ class dabc::Thread::ExecWorker : public dabc::Worker {
                item.SetField("min", 0);
                item.SetField("max", 1);
                item.EnableHistory(100);
+
+               item = fWorkerHierarchy.CreateHChild("EventsPerLock");
+               item.SetField(dabc::prop_kind, "rate");
+               item.EnableHistory(100);
             }
 
             Publish(fWorkerHierarchy, std::string("$MGR$") + fThread.ItemName());
@@ -197,6 +207,14 @@ class dabc::Thread::ExecWorker : public dabc::Worker {
                if (load > 1) load  = 1.;
                fWorkerHierarchy.GetHChild("Load").SetField("value", load);
             }
+
+            // number of events, delivered by single lock of the queues
+            uint64_t nevents = fThread()->fStatEvents - fLastEvents,
+                     nlocks = fThread()->fStatLocks - fLastLocks;
+            fLastEvents = fThread()->fStatEvents;
+            fLastLocks = fThread()->fStatLocks;
+            if (nlocks > 0)
+               fWorkerHierarchy.GetHChild("EventsPerLock").SetField("value", 1.*nevents/nlocks);
          }
 
          fWorkerHierarchy.MarkChangedItems();
@@ -218,8 +236,17 @@ dabc::Thread::Thread(Reference parent, const std::string &name, Command cmd) :
    fWorkCond(fObjectMutex),
    fQueues(0),
    fNumQueues(3),
+   fDrainBuf(nullptr),
+   fDrainSize(1),
+   fDrainNum(0),
+   fDrainPos(0),
+   fStatEvents(0),
+   fStatLocks(0),
+   fNumPending(0),
+   fSpinTime(0.),
    fNextTimeout(),
    fProcessingTimeouts(0),
+   fTimeouts(),
    fWorkers(),
    fExplicitLoop(0),
    fExec(0),
@@ -253,6 +280,15 @@ dabc::Thread::Thread(Reference parent, const std::string &name, Command cmd) :
      }
    }
 
+   // number of events, taken from queues with single lock, by default one event per lock
+   fDrainSize = fExec->Cfg("drain", cmd).AsUInt(1);
+   if (fDrainSize < 1) fDrainSize = 1;
+   fDrainBuf = new EventId[fDrainSize];
+
+   // time in microseconds to spin before blocking, negative value - busy polling
+   int spin = fExec->Cfg("spin", cmd).AsInt(0);
+   fSpinTime = (spin < 0) ? -1. : spin*1e-6;
+
    std::string affinity = fExec->Cfg(xmlAffinity, cmd).AsStr();
 
    if (!affinity.empty()) {
@@ -333,6 +369,9 @@ dabc::Thread::~Thread()
    delete [] fQueues; fQueues = 0;
    fNumQueues = 0;
 
+   delete [] fDrainBuf; fDrainBuf = nullptr;
+   fDrainNum = fDrainPos = 0;
+
    DOUT3("~~~~~~~~~~~~~~ THRD %s destroyed cnt:%d", GetName(), fThreadInstances);
 
    fThreadInstances--;
@@ -349,7 +388,7 @@ unsigned dabc::Thread::_TotalNumberOfEvents()
    unsigned totalsize = 0;
    for (int n=0;n<fNumQueues;n++)
       totalsize+=fQueues[n].Size();
-   return totalsize;
+   return totalsize + fDrainNum - fDrainPos;
 }
 
 unsigned dabc::Thread::TotalNumberOfEvents()
@@ -383,7 +422,7 @@ void dabc::Thread::ProcessNoneEvent()
    if (new_size==fWorkers.size()) return;
 
    fWorkers.resize(new_size);
-   DOUT3("Thrd:%s Shrink processors size to %u normal state %s refcnt %d", GetName(), new_size, DBOOL(_IsNormalState()), fObjectRefCnt);
+   DOUT3("Thrd:%s Shrink processors size to %u normal state %s refcnt %d", GetName(), new_size, DBOOL(_IsNormalState()), fObjectRefCnt.load());
 
    // we check that object is in normal state,
    // otherwise it means that destroyment is already started and will be done in other means
@@ -393,7 +432,7 @@ void dabc::Thread::ProcessNoneEvent()
    }
 }
 
-bool dabc::Thread::_GetNextEvent(dabc::EventId& evnt)
+bool dabc::Thread::_PopEvent(dabc::EventId& evnt)
 {
    // return next event from the queues
    // in general, events returned according their priority
@@ -408,6 +447,7 @@ bool dabc::Thread::_GetNextEvent(dabc::EventId& evnt)
       if (fQueues[nq].Size()>0) {
          if (--(fQueues[nq].scaler)>0) {
             evnt = fQueues[nq].Pop();
+            fNumPending.fetch_sub(1, std::memory_order_relaxed);
             return true;
          }
          fQueues[nq].scaler = 8;
@@ -418,12 +458,29 @@ bool dabc::Thread::_GetNextEvent(dabc::EventId& evnt)
    for(int nq=0; nq<fNumQueues; nq++)
       if (fQueues[nq].Size()>0) {
          evnt = fQueues[nq].Pop();
+         fNumPending.fetch_sub(1, std::memory_order_relaxed);
          return true;
       }
 
    return false;
 }
 
+bool dabc::Thread::_GetNextEvent(dabc::EventId& evnt)
+{
+   if (!_PopEvent(evnt)) return false;
+
+   // take more events with same lock, they will be processed without locking
+   // events must be taken from drain buffer before queues are accessed again
+
+   fDrainNum = fDrainPos = 0;
+   while ((fDrainNum + 1 < fDrainSize) && _PopEvent(fDrainBuf[fDrainNum])) fDrainNum++;
+
+   fStatLocks++;
+   fStatEvents += fDrainNum + 1;
+
+   return true;
+}
+
 
 bool dabc::Thread::CompatibleClass(const std::string &clname) const
 {
@@ -1041,15 +1098,42 @@ void dabc::Thread::_Fire(const EventId& arg, int nq)
 
 }
 
+void dabc::Thread::SpinForEvents(double& tmout)
+{
+   TimeStamp start = dabc::Now();
+
+   double limit = SpinLimit(tmout);
+
+   while (fNumPending.load(std::memory_order_acquire) == 0) {
+      if ((limit >= 0.) && (start.SpentTillNow() >= limit)) break;
+      #if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+      #endif
+   }
+
+   if (tmout > 0.) {
+      tmout -= start.SpentTillNow();
+      if (tmout < 0.) tmout = 0.;
+   }
+}
+
 bool dabc::Thread::WaitEvent(EventId& evid, double tmout)
 {
+   if (TakeDrainedEvent(evid)) return true;
+
+   // spin-then-block mode, thread does not sleep when events come fast enough
+   if ((fSpinTime != 0.) && (tmout != 0.)) SpinForEvents(tmout);
 
    LockGuard lock(ThreadMutex());
 
-   if (fWorkCond._DoWait(tmout))
-      return _GetNextEvent(evid);
+   if (!fWorkCond._DoWait(tmout)) return false;
 
-   return false;
+   bool res = _GetNextEvent(evid);
+
+   // drained events also should be removed from condition counter
+   if (fDrainNum > 0) fWorkCond._DoTake(fDrainNum);
+
+   return res;
 }
 
 
@@ -1124,7 +1208,10 @@ void dabc::Thread::ProcessEvent(const EventId& evnt)
             break;
          }
 
-         if (rec->tmout_worker.CheckEvent(ThreadMutex())) CheckTimeouts(true);
+         if (rec->tmout_worker.CheckEvent(ThreadMutex())) {
+            PushTimeout(evnt.GetArg(), false, rec->tmout_worker.next_fire);
+            CheckTimeouts(true);
+         }
 
          break;
       }
@@ -1142,7 +1229,10 @@ void dabc::Thread::ProcessEvent(const EventId& evnt)
             break;
          }
 
-         if (rec->tmout_addon.CheckEvent(ThreadMutex())) CheckTimeouts(true);
+         if (rec->tmout_addon.CheckEvent(ThreadMutex())) {
+            PushTimeout(evnt.GetArg(), true, rec->tmout_addon.next_fire);
+            CheckTimeouts(true);
+         }
 
          break;
       }
@@ -1185,7 +1275,7 @@ void dabc::Thread::ProcessEvent(const EventId& evnt)
                EOUT("Thread cannot be normally destroyed, just leave main loop");
                fThrdWorking = false;
             } else {
-               DOUT3(" -------- THRD %s refcnt %u DESTROYMENT GOES TO MANAGER", GetName(), fObjectRefCnt);
+               DOUT3(" -------- THRD %s refcnt %u DESTROYMENT GOES TO MANAGER", GetName(), fObjectRefCnt.load());
             }
          }
 
@@ -1210,6 +1300,11 @@ void dabc::Thread::ProcessEvent(const EventId& evnt)
 }
 
 
+dabc::RecordField dabc::Thread::ThreadCfg(const std::string &name, Command cmd) const
+{
+   return fExec ? fExec->Cfg(name, cmd) : cmd.GetField(name);
+}
+
 bool dabc::Thread::AddWorker(Reference ref, bool sync)
 {
    Command cmd("AddWorker");
@@ -1281,6 +1376,38 @@ bool dabc::Thread::InvokeWorkerDestroy(Worker* work)
    return fExec->Submit(cmd);
 }
 
+dabc::Thread::TimeoutRec* dabc::Thread::GetTimeoutRec(const TimeoutEntry& entry)
+{
+   if (entry.workerid >= fWorkers.size()) return nullptr;
+
+   WorkerRec* rec = fWorkers[entry.workerid];
+   if (!rec || !rec->work) return nullptr;
+
+   TimeoutRec* tmout = entry.addon ? &rec->tmout_addon : &rec->tmout_worker;
+
+   // timeout was changed after entry was created
+   if (tmout->next_fire.null() || !(tmout->next_fire == entry.fire)) return nullptr;
+
+   return tmout;
+}
+
+void dabc::Thread::PushTimeout(unsigned workerid, bool addon, const TimeStamp& fire)
+{
+   // outdated entries normally removed when they reach top of the heap,
+   // but workers which often reschedule timeouts may accumulate many of them
+   if (fTimeouts.size() > 4*fWorkers.size() + 16) {
+      unsigned len = 0;
+      for (unsigned n = 0; n < fTimeouts.size(); n++)
+         if (GetTimeoutRec(fTimeouts[n]))
+            fTimeouts[len++] = fTimeouts[n];
+      fTimeouts.resize(len, fTimeouts[0]);
+      std::make_heap(fTimeouts.begin(), fTimeouts.end());
+   }
+
+   fTimeouts.push_back(TimeoutEntry(fire, workerid, addon));
+   std::push_heap(fTimeouts.begin(), fTimeouts.end());
+}
+
 double dabc::Thread::CheckTimeouts(bool forcerecheck)
 {
    if (fProcessingTimeouts>0) return -1.;
@@ -1297,38 +1424,48 @@ double dabc::Thread::CheckTimeouts(bool forcerecheck)
    } else
       now.GetNow();
 
-   double min_tmout(-1.), last_diff(0.);
+   // only expired timeouts are extracted from the heap, rest is not touched
+   while (!fTimeouts.empty()) {
+      TimeoutEntry entry = fTimeouts.front();
 
-   for (unsigned n=1;n<fWorkers.size();n++) {
-      WorkerRec* rec = fWorkers[n];
-      if ((rec==0) || (rec->work==0)) continue;
+      TimeoutRec* tmout = GetTimeoutRec(entry);
 
-      if (rec->tmout_worker.CheckNextProcess(now, min_tmout, last_diff)) {
+      if (tmout && (entry.fire - now >= 0.)) break;
 
-         double dist = rec->work->ProcessTimeout(last_diff);
+      std::pop_heap(fTimeouts.begin(), fTimeouts.end());
+      fTimeouts.pop_back();
 
-         rec->tmout_worker.SetNextFire(now, dist, min_tmout);
-      }
+      if (!tmout) continue;
 
-      if (rec->tmout_addon.CheckNextProcess(now, min_tmout, last_diff)) {
+      double last_diff = tmout->LastDiff(now);
 
-         double dist = rec->work->ProcessAddonTimeout(last_diff);
+      Worker* work = fWorkers[entry.workerid]->work;
 
-         rec->tmout_addon.SetNextFire(now, dist, min_tmout);
-      }
+      double dist = entry.addon ? work->ProcessAddonTimeout(last_diff) : work->ProcessTimeout(last_diff);
+
+      // workers vector may be changed during timeout processing
+      tmout = GetTimeoutRec(entry);
+
+      if (tmout && tmout->SetNextFire(now, dist))
+         PushTimeout(entry.workerid, entry.addon, tmout->next_fire);
    }
 
-   if (min_tmout>=0.)
-      fNextTimeout = now + min_tmout;
-   else
+   double min_tmout = -1.;
+
+   if (!fTimeouts.empty()) {
+      min_tmout = fTimeouts.front().fire - now;
+      if (min_tmout < 0.) min_tmout = 0.;
+      fNextTimeout = fTimeouts.front().fire;
+   } else {
       fNextTimeout.Reset();
+   }
 
    return min_tmout;
 }
 
 void dabc::Thread::ObjectCleanup()
 {
-   DOUT3("---- THRD %s ObjectCleanup refcnt %u", GetName(), fObjectRefCnt);
+   DOUT3("---- THRD %s ObjectCleanup refcnt %u", GetName(), fObjectRefCnt.load());
 
    // FIXME: should we wait until all commands and all events are processed
    // FIXME: can we delete worker already here??
@@ -1375,6 +1512,7 @@ void dabc::Thread::Print(int lvl)
    LockGuard guard(ThreadMutex());
 
    dabc::lgr()->Debug(lvl, "file", 1, "func", dabc::format("   Workers vector size: %lu", (long unsigned) fWorkers.size()).c_str());
+   dabc::lgr()->Debug(lvl, "file", 1, "func", dabc::format("   Events: %lu locks: %lu drain size: %u", (long unsigned) fStatEvents, (long unsigned) fStatLocks, fDrainSize).c_str());
 
    for (unsigned n=1;n<fWorkers.size();n++) {
       Worker* work = fWorkers[n]->work;
@@ -239,7 +239,7 @@ void dabc::Worker::ObjectCleanup()
 {
    // TODO: that is correct sequence - first delete child, than clean ourself  (current) or vice-versa
 
-   DOUT4("START worker %s class %s cleanup refcnt = %d thrd %s publ %p publthrd %s", GetName(), ClassName(), fObjectRefCnt, thread().GetName(), fPublisher(), WorkerRef(fPublisher).thread().GetName());
+   DOUT4("START worker %s class %s cleanup refcnt = %d thrd %s publ %p publthrd %s", GetName(), ClassName(), fObjectRefCnt.load(), thread().GetName(), fPublisher(), WorkerRef(fPublisher).thread().GetName());
 
    CleanupPublisher(false);
 
@@ -270,7 +270,7 @@ void dabc::Worker::ObjectCleanup()
    // DOUT0("Worker:%s Destroy addon:%p in ObjectCleanup", GetName(), fAddon());
    fAddon.Release();
 
-   DOUT4("DID worker %s class %s cleanup refcnt = %d", GetName(), ClassName(), fObjectRefCnt);
+   DOUT4("DID worker %s class %s cleanup refcnt = %d", GetName(), ClassName(), fObjectRefCnt.load());
 }
 
 
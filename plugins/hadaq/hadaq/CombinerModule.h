@@ -92,6 +92,10 @@ namespace hadaq {
          {
             for (int i=0;i<HADAQ_RINGSIZE;i++)
                fTrigNumRing[i]=0;
+            // subevents headers of received buffer decoded in single pass
+            fIter.SetIndexing();
+            // resort takes position of fIter without index, only further buffers are indexed
+            fResortIter.SetIndexing();
          }
 
          void Reset(bool complete = false)
@@ -146,6 +150,19 @@ namespace hadaq {
          }
       };
 
+      /** Worker module, which builds part of events when several builders are used */
+      struct WorkerCfg {
+         std::string fName;              ///< name of worker module
+         unsigned fInput{0};             ///< input with build events from worker
+         ReadIterator fIter;             ///< iterator over build events
+         hadaq::RawEvent *evnt{nullptr}; ///< current event, used for merging
+         uint32_t fTrigNr{0};            ///< trigger number of current event
+         uint64_t fMergedEvents{0};      ///< number of events, taken from worker
+         uint64_t fBuildEvents{0};       ///< number of events, build by worker
+         uint64_t fBuildData{0};         ///< amount of data, build by worker
+         uint64_t fDiscEvents{0};        ///< number of events, discarded by worker
+         int      fInpQueue{0};          ///< maximal input queue of worker
+      };
 
          /* master stream for event building*/
          //unsigned fMasterChannel;
@@ -192,9 +209,19 @@ namespace hadaq {
          dabc::Command      fBnetCalibrCmd;  ///< current running bnet calibration command
 
          double             fFlushTimeout;
+         unsigned           fZeroCopy;      ///< max number of segments in output buffer when events built without copy, 0 - off
          dabc::Command      fBnetFileCmd;  ///< current running bnet file command
          dabc::Command      fBnetRefreshCmd; ///< current running refresh command
 
+         int                fNumWorkers{0};      ///< number of parallel builders, 0 - events build by module itself
+         int                fWorkerIndx{-1};     ///< index of worker, -1 when module is not a worker
+         unsigned           fWorkersBunch{16};   ///< number of consecutive triggers delivered to same worker
+         bool               fOrderedMerge{true}; ///< merge events from workers in trigger order
+         unsigned           fNumDataOutputs{0};  ///< number of outputs for build events, others deliver data to workers
+         std::vector<WorkerCfg> fWorkers;        ///< workers, used by the master module
+         dabc::TimeStamp    fLastMergeTm;        ///< last time when data from all workers was available
+         unsigned           fMergeWorker{0};     ///< worker used for last merged event
+
          std::string        fDataRateName;
          std::string        fDataDroppedRateName;
          std::string        fEventRateName;
@@ -312,6 +339,31 @@ namespace hadaq {
 
          void StartEventsBuilding();
 
+         bool IsWorkersMaster() const { return (fNumWorkers > 0) && (fWorkerIndx < 0); }
+         bool IsWorker() const { return fWorkerIndx >= 0; }
+
+         /** Returns true if trigger belongs to the bunches of this worker */
+         bool IsWorkerTrigger(uint32_t trignr) const
+         {
+            return ((trignr >> 8) & fTriggerRangeMask) / fWorkersBunch % fNumWorkers == (unsigned) fWorkerIndx;
+         }
+
+         /** Number of outputs, where build events are delivered */
+         unsigned NumDataOutputs() const { return IsWorkersMaster() ? fNumDataOutputs : NumOutputs(); }
+
+         int ExcludeBunchesGap(int diff, int bunch, int numbuilders);
+
+         void CreateWorkers();
+         void ConnectWorkers();
+         bool ProcessWorkers();
+         bool DistributeInputs();
+         bool ShiftToNextWorkerEvent(unsigned nw);
+         bool MergeWorkersEvent();
+         bool ForwardWorkersBuffer();
+         void CollectWorkersStatistic();
+
+         void OnThreadAssigned() override;
+
       public:
          CombinerModule(const std::string &name, dabc::Command cmd = nullptr);
          virtual ~CombinerModule();
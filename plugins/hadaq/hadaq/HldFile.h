@@ -64,6 +64,10 @@ namespace hadaq {
           * User must be aware about correct formatting of data.
           * Returns true if data was written.*/
          bool WriteBuffer(void* buf, uint32_t bufsize);
+
+         /** Write several user buffers with single call of file interface
+          * Returns true if all data was written.*/
+         bool WriteBuffers(const void* const* bufs, const size_t* sizes, unsigned num);
    };
 
 } // end of namespace
@@ -24,18 +24,34 @@
 #include "hadaq/HldFile.h"
 #endif
 
+#ifndef DABC_MappedFile
+#include "dabc/MappedFile.h"
+#endif
+
 namespace hadaq {
 
-   /** \brief Implementation of file input for HLD files */
+   /** \brief Implementation of file input for HLD files
+    *
+    * With url option mmap=<MB> file is memory-mapped in windows of specified size
+    * and produced buffers point directly into the mapped memory */
 
    class HldInput : public dabc::FileInput {
       protected:
 
          hadaq::HldFile   fFile;
 
+         dabc::MappedFile fMapped;       ///< memory-mapped file, used when fMapWindow>0
+         uint64_t         fMapWindow;    ///< size of mapped window
+         bool             fMapEOF;       ///< stop event found in mapped file
+
          bool CloseFile();
          bool OpenNextFile();
 
+         bool isReading() const { return fMapWindow ? fMapped.isOpened() : fFile.isReading(); }
+         bool isEOF() const { return fMapWindow ? fMapEOF || fMapped.eof() : fFile.eof(); }
+
+         unsigned ReadMapped(dabc::Buffer& buf);
+
          virtual std::string GetListFileExtension() { return ".hll"; }
 
       public:
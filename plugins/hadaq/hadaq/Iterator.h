@@ -32,8 +32,31 @@
 #include "dabc/eventsapi.h"
 #endif
 
+#include <vector>
+
 namespace hadaq {
 
+   /** \brief Decoded header of HADAQ subevent
+    *
+    * Produced by \ref ReadIterator when indexing is enabled. Header words are swapped once
+    * when container is scanned, consumers do not need to access subevent memory again */
+
+   struct SubeventInfo {
+      hadaq::RawSubevent *subevnt{nullptr}; ///< direct pointer on subevent
+      uint32_t offset{0};     ///< offset of subevent in the container
+      uint32_t size{0};       ///< subevent size, including header
+      uint32_t trignr{0};     ///< trigger number, lowest byte is trigger tag
+      uint32_t id{0};         ///< subevent id, msb indicates data error
+      uint32_t decoding{0};   ///< decoding word
+      uint32_t errbits{0};    ///< last data word with error bits, 0 for empty subevent
+
+      uint32_t GetPaddedSize() const { return (size + 7) & ~7U; }
+      uint32_t GetTrigTag() const { return trignr & 0xFF; }
+      bool GetDataError() const { return (id & 0x80000000) != 0; }
+      bool IsEmpty() const { return size <= sizeof(hadaq::RawSubevent); }
+      uint8_t GetTrigTypeTrb3() const { return (decoding & 0xF0) >> 4; }
+   };
+
    /** \brief Read iterator for HADAQ events/subevents */
 
    class ReadIterator {
@@ -43,6 +66,16 @@ namespace hadaq {
          dabc::Pointer  fSubPtr;
          dabc::Pointer  fRawPtr;
          unsigned       fBufType;
+         bool           fIndexing{false};  ///< when true, subevents headers of complete buffer decoded at once
+         bool           fIndexed{false};   ///< index of current buffer is used
+         std::vector<SubeventInfo> fIndex; ///< decoded subevents of current buffer
+         unsigned       fIndexNext{0};     ///< next entry in fIndex
+         int            fIndexPos{-1};     ///< entry of current subevent, -1 when index not used
+         const char    *fContEnd{nullptr}; ///< end of current container when index is used
+         SubeventInfo   fInfo;             ///< decoded current subevent when index cannot be used
+
+         bool GetContainerSize(dabc::BufferSize_t &headsize, dabc::BufferSize_t &containersize) const;
+         bool NextIndexedSubEvent();
 
       public:
          ReadIterator();
@@ -53,6 +86,10 @@ namespace hadaq {
 
          ReadIterator& operator=(const ReadIterator& src);
 
+         /** Take current position of other iterator without copying its index.
+          * Rest of current buffer iterated without index, subevents headers decoded one by one */
+         void AssignPosition(const ReadIterator& src);
+
          ~ReadIterator() { Close(); }
 
          /** Initialize iterator on the beginning of the buffer, buffer instance should exists until
@@ -78,6 +115,18 @@ namespace hadaq {
          /** Used for sub-events iteration inside current block */
          bool NextSubEvent();
 
+         /** Enable decoding of all subevents headers of the buffer in single pass, done in \ref Reset.
+          * Index used only for contiguous buffers without format errors, otherwise
+          * subevents are decoded one by one. Decoded header provided by \ref subevnt_info */
+         void SetIndexing(bool on = true) { fIndexing = on; }
+
+         /** Decoded header of current subevent, valid after NextSubEvent() when indexing is enabled */
+         const SubeventInfo &subevnt_info() const { return fIndexPos < 0 ? fInfo : fIndex[fIndexPos]; }
+
+         /** Decode headers of all subevents in the buffer of given type.
+          * Returns false if buffer is not contiguous or has format errors */
+         static bool IndexBuffer(const dabc::Buffer &buf, std::vector<SubeventInfo> &index);
+
          hadaq::RawEvent* evnt() const { return (hadaq::RawEvent*) fEvPtr(); }
          unsigned evntsize() const { return evnt() ? evnt()->GetPaddedSize() : 0; }
 
@@ -89,6 +138,10 @@ namespace hadaq {
          bool AssignEventPointer(dabc::Pointer& ptr);
          hadaq::RawSubevent* subevnt() const { return (hadaq::RawSubevent*) fSubPtr(); }
          void* rawdata() const { return fRawPtr(); }
+
+         /** Position of current event/subevent in the buffer, used to reference data without copy */
+         const dabc::Pointer& evnt_ptr() const { return fEvPtr; }
+         dabc::Pointer subevnt_ptr() const;
          uint32_t rawdatasize() const { return fRawPtr.fullsize(); }
 
          /** Try to define maximal length for the raw data */
@@ -109,6 +162,13 @@ namespace hadaq {
 
          bool Reset(const dabc::Buffer& buf);
 
+         /** Prepare zero-copy event building. Only event headers are written into hdrbuf,
+          * subevents added with \ref AddSubeventRef are referenced in their buffers.
+          * Produced buffer contains list of segments and cannot be larger than hdrbuf */
+         bool ResetZeroCopy(const dabc::Buffer& hdrbuf, unsigned maxsegments, unsigned maxsubevents);
+
+         bool IsZeroCopy() const { return !fHdrBuf.null(); }
+
          bool IsBuffer() const { return !fBuffer.null(); }
          bool IsEmpty() const { return fFullSize == 0; }
          bool IsPlaceForEvent(uint32_t subeventsize);
@@ -126,8 +186,21 @@ namespace hadaq {
          {
             return AddSubevent(evnt->FirstSubevent(), evnt->AllSubeventsSize());
          }
+
+         /** Add len bytes from source position. In zero-copy mode data is only referenced,
+          * when not possible (other memory pool) data is copied */
+         bool AddSubeventRef(const dabc::Pointer &source, unsigned len);
+
+         /** Reference complete event (with header and padding) in zero-copy mode.
+          * Used instead of NewEvent()/FinishEvent() when event already build in other buffer */
+         bool AddEventRef(const dabc::Pointer &source, unsigned len);
+
          bool FinishEvent();
 
+         /** Bytes of subevents, referenced and copied in zero-copy mode */
+         uint64_t NumRefBytes() const { return fRefBytes; }
+         uint64_t NumCopyBytes() const { return fCopyBytes; }
+
          dabc::Buffer Close();
 
          hadaq::RawEvent* evnt() const { return (hadaq::RawEvent*) fEvPtr(); }
@@ -140,6 +213,15 @@ namespace hadaq {
          dabc::Pointer  fEvPtr;
          dabc::Pointer  fSubPtr;
          dabc::BufferSize_t fFullSize;
+
+         // zero-copy mode, fEvPtr and fSubPtr point into headers buffer
+         bool AddZeroCopyData(const dabc::Pointer* source, const void* ptr, unsigned len, bool ref);
+
+         dabc::Buffer   fHdrBuf;          ///< buffer for events headers, copied and padding data
+         unsigned       fMaxSubevents;    ///< maximal number of subevents in single event
+         dabc::BufferSize_t fEvSize;      ///< size of current event
+         uint64_t       fRefBytes;        ///< statistic - referenced bytes
+         uint64_t       fCopyBytes;       ///< statistic - copied bytes
    };
 
    // _______________________________________________________________________________________________
@@ -24,34 +24,166 @@
 #include "dabc/Pointer.h"
 #endif
 
+#ifndef HADAQ_Iterator
+#include "hadaq/Iterator.h"
+#endif
+
 #include <vector>
+#include <algorithm>
 
 namespace hadaq {
 
-
-/** \brief Sorts HADAQ subevents according to trigger number
+/** \brief Queue of subevents records, which provides them in order of trigger numbers
  *
- * Need to be applied when TRB send provides events not in order they appear
- * Or when network adapter provides UDP packets not in order
+ * Records are placed into ring, indexed by trigger number modulo ring size.
+ * Ring starts from next expected trigger number, therefore records which are in order
+ * are inserted and taken out without any comparison with other records.
+ * Records which do not fit into the ring (too far ahead, older than ring start or with
+ * duplicated trigger number) are kept in the min-heap.
+ * Trigger numbers are compared with wrap-around inside triggers range,
+ * therefore all kept records should be within half of the range.
  */
 
-   class SorterModule : public dabc::ModuleAsync {
-
-   public:
-         struct SubsRec {
+   class SubeventsQueue {
+      public:
+         struct Rec {
             void*     subevnt;  //!< direct pointer on subevent
             uint32_t  trig;     //!< trigger number
-            uint32_t  buf;      //!< buffer indx
+            uint32_t  buf;      //!< buffer id
             uint32_t  sz;       //!< padded size
          };
 
-         struct SubsComp {
-            SorterModule* m;
-            SubsComp(SorterModule* _m) : m(_m) {}
-            // use in std::sort for sorting elements of std::vector<SubsRec>
-            bool operator() (const SubsRec& l,const SubsRec& r) { return m->Diff(l.trig, r.trig) > 0; }
+      protected:
+         struct Comp {
+            int range;
+            Comp(uint32_t _range) : range((int) _range) {}
+            // used in std heap functions, record with smaller trigger goes to the top
+            bool operator() (const Rec &l, const Rec &r) const
+            {
+               int res = (int) (l.trig - r.trig);
+               if (res > range/2) res -= range; else
+               if (res < range/-2) res += range;
+               return res > 0;
+            }
          };
 
+         uint32_t fRange;          //!< valid range for the triggers
+         std::vector<Rec> fRing;   //!< ring with records, subevnt==nullptr for empty entries
+         unsigned fRingMask;       //!< ring size - 1
+         unsigned fRingCnt;        //!< number of records in the ring
+         unsigned fBasePos;        //!< ring position of base trigger
+         uint32_t fBaseTrig;       //!< trigger number of first ring entry, 0xffffffff when not defined
+         std::vector<Rec> fHeap;   //!< heap with records outside the ring
+         bool fTopRing;            //!< true if top record is from the ring
+
+         int Diff(uint32_t trig1, uint32_t trig2) const
+         {
+            int res = (int) (trig2) - trig1;
+            if (res > ((int) fRange)/2) return res - fRange;
+            if (res < ((int) fRange)/-2) return res + fRange;
+            return res;
+         }
+
+      public:
+         SubeventsQueue(uint32_t range = 0x1000000, unsigned window = 1024) :
+            fRange(range), fRing(), fRingMask(0), fRingCnt(0), fBasePos(0), fBaseTrig(0xffffffff), fHeap(), fTopRing(false)
+         {
+            SetWindow(window);
+         }
+
+         void SetRange(uint32_t range) { fRange = range; }
+
+         /** Set ring size, rounded up to power of two. Only can be done when queue is empty */
+         void SetWindow(unsigned window)
+         {
+            unsigned sz = 1;
+            while (sz < window) sz *= 2;
+            Rec empty = { nullptr, 0, 0, 0 };
+            fRing.assign(sz, empty);
+            fRingMask = sz - 1;
+            fRingCnt = 0;
+            fBasePos = 0;
+         }
+
+         unsigned GetWindow() const { return fRing.size(); }
+
+         /** Set trigger number, expected as next, only when ring is empty */
+         void SetNext(uint32_t trig) { if (fRingCnt == 0) fBaseTrig = trig; }
+
+         void reserve(unsigned sz) { fHeap.reserve(sz); }
+         unsigned size() const { return fRingCnt + fHeap.size(); }
+         bool empty() const { return (fRingCnt == 0) && fHeap.empty(); }
+         unsigned heap_size() const { return fHeap.size(); }
+
+         void clear()
+         {
+            while (fRingCnt > 0) pop();
+            fHeap.clear();
+         }
+
+         void push(const Rec &rec)
+         {
+            if (fBaseTrig == 0xffffffff) fBaseTrig = rec.trig;
+            int diff = Diff(fBaseTrig, rec.trig);
+            if ((diff >= 0) && (diff <= (int) fRingMask)) {
+               Rec &entry = fRing[(fBasePos + diff) & fRingMask];
+               if (!entry.subevnt) {
+                  entry = rec;
+                  fRingCnt++;
+                  return;
+               }
+            }
+            fHeap.push_back(rec);
+            std::push_heap(fHeap.begin(), fHeap.end(), Comp(fRange));
+         }
+
+         /** Returns record with smallest trigger number, queue should not be empty */
+         const Rec &top()
+         {
+            if (fRingCnt > 0) {
+               // skip empty entries, base moves to first filled entry
+               while (!fRing[fBasePos].subevnt) {
+                  fBasePos = (fBasePos + 1) & fRingMask;
+                  fBaseTrig = (fBaseTrig + 1) & (fRange - 1);
+               }
+               fTopRing = fHeap.empty() || !Comp(fRange)(fRing[fBasePos], fHeap.front());
+            } else {
+               fTopRing = false;
+            }
+            return fTopRing ? fRing[fBasePos] : fHeap.front();
+         }
+
+         void pop()
+         {
+            top();
+            if (fTopRing) {
+               fRing[fBasePos].subevnt = nullptr;
+               fRingCnt--;
+               fBasePos = (fBasePos + 1) & fRingMask;
+               fBaseTrig = (fBaseTrig + 1) & (fRange - 1);
+            } else {
+               // when ring is empty, it can start from next expected trigger
+               if (fRingCnt == 0) fBaseTrig = (fHeap.front().trig + 1) & (fRange - 1);
+               std::pop_heap(fHeap.begin(), fHeap.end(), Comp(fRange));
+               fHeap.pop_back();
+            }
+         }
+   };
+
+
+/** \brief Sorts HADAQ subevents according to trigger number
+ *
+ * Need to be applied when TRB send provides events not in order they appear
+ * Or when network adapter provides UDP packets not in order.
+ * Subevents of scanned buffers are kept in hadaq::SubeventsQueue and emitted as soon as
+ * they are in order. Gaps in trigger numbers are accepted when subevent waits longer
+ * than two input buffers
+ */
+
+   class SorterModule : public dabc::ModuleAsync {
+
+   public:
+      typedef SubeventsQueue::Rec SubsRec;
 
       int       fFlushCnt;
       int       fBufCnt;          //!< total number of buffers
@@ -60,13 +192,23 @@ namespace hadaq {
       uint32_t  fLastTrigger;     //!< last trigger copied into output
       unsigned  fNextBufIndx;     //!< next buffer which could be processed
       unsigned  fReadyBufIndx;    //!< input buffer index which could be send directly
-      std::vector<SubsRec> fSubs; //!< vector with subevents data in the buffers
+      uint32_t  fFirstBufId;      //!< id of first buffer in input queue, used in SubsRec::buf
+      SubeventsQueue fSubs;       //!< queue with subevents data in the buffers
+      std::vector<unsigned> fBufSubs; //!< number of not yet used subevents in each scanned input buffer
+      std::vector<SubsRec> fScan; //!< subevents of currently scanned buffer
       dabc::Buffer fOutBuf;       //!< output buffer
       dabc::Pointer fOutPtr;      //!< place for new data
+      hadaq::ReadIterator fIter;  //!< iterator to scan input buffers, keeps index memory
 
       void DecremntInputIndex(unsigned cnt=1);
 
-      bool RemoveUsedSubevents(unsigned num);
+      bool RemoveUsedSubevents();
+
+      void UseSubevent(const SubsRec &rec)
+      {
+         fBufSubs[rec.buf - fFirstBufId]--;
+         fSubs.pop();
+      }
 
       bool retransmit();
 
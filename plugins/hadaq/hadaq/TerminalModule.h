@@ -58,6 +58,7 @@ namespace hadaq {
          dabc::Command   fLastFileCmd;    ///< last received data from file transport
          bool            fFileReqRunning; ///< is file request running
          int             fRingSize;       ///< number of last IDs shown
+         std::vector<uint64_t> fWorkersEvents; ///< last seen number of events build by each worker
 
          std::string     fModuleName;    ///< name of hadaq combiner module
 
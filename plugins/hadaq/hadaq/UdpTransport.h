@@ -33,6 +33,8 @@
 #include "hadaq/HadaqTypeDefs.h"
 #endif
 
+struct mmsghdr;
+
 namespace hadaq {
 
    class DataTransport;
@@ -50,6 +52,9 @@ namespace hadaq {
       uint64_t           fTotalRecvBytes;
       uint64_t           fTotalDiscardBytes;
       uint64_t           fTotalProducedBuffers;
+      uint64_t           fTotalBatches;        ///< number of recvmmsg calls which delivered packets
+      uint64_t           fTotalBatchPackets;   ///< number of packets received with recvmmsg
+      unsigned           fMaxBatchPackets;     ///< maximal number of packets received with single recvmmsg
 
       void ClearCounters()
       {
@@ -61,6 +66,9 @@ namespace hadaq {
          fTotalRecvBytes = 0;
          fTotalDiscardBytes = 0;
          fTotalProducedBuffers = 0;
+         fTotalBatches = 0;
+         fTotalBatchPackets = 0;
+         fMaxBatchPackets = 0;
       }
 
       TransportInfo(int port) : fNPort(port) { ClearCounters(); }
@@ -86,6 +94,13 @@ namespace hadaq {
          return res;
       }
 
+      std::string GetBatchString()
+      {
+         if (fTotalBatches == 0) return "-";
+
+         return dabc::format("%4.1f", 1.*fTotalBatchPackets/fTotalBatches);
+      }
+
    };
 
    // ==================================================================================
@@ -110,6 +125,10 @@ namespace hadaq {
          bool               fRunning;         ///< is transport running
          dabc::TimeStamp    fLastProcTm;      ///< last time when udp reading was performed
          double             fMaxProcDist;     ///< maximal time between calls to BuildEvent method
+         unsigned           fBatchSize;       ///< maximal number of packets read with single recvmmsg, 0 - disabled
+         double             fBatchTmout;      ///< maximal time spent in single ReadUdp call in batch mode, 0 - no limit
+         struct mmsghdr    *fBatchMsgs;       ///< messages headers for recvmmsg
+         struct iovec      *fBatchIOV;        ///< io vectors for recvmmsg
 
          virtual void ProcessEvent(const dabc::EventId&);
 
@@ -119,10 +138,16 @@ namespace hadaq {
          /* Use codes which are valid for Read_Start */
          bool ReadUdp();
 
+         /** Read packets with recvmmsg directly into the buffer, used when batch mode is enabled */
+         bool ReadUdpBatch(hadaq::NewTransport* tr);
+
+         /** Verify received packet, returns padded size of HadTu or 0 when packet should be discarded */
+         unsigned CheckPacket(hadaq::HadTu* hadTu, ssize_t res);
+
          bool CloseBuffer();
 
       public:
-         NewAddon(int fd, int nport, int mtu, bool debug, int maxloop, double reduce, double lost);
+         NewAddon(int fd, int nport, int mtu, bool debug, int maxloop, double reduce, double lost, int batch = 0, double batchtm = 0.);
          virtual ~NewAddon();
 
          bool HasBuffer() const { return !fTgtPtr.null(); }
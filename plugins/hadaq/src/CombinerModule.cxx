@@ -72,6 +72,18 @@ hadaq::CombinerModule::CombinerModule(const std::string &name, dabc::Command cmd
    fBNETNumRecv = Cfg("BNET_NUMRECEIVERS", cmd).AsInt(1);
    fBNETNumSend = Cfg("BNET_NUMSENDERS", cmd).AsInt(1);
 
+   // events can be build by several workers, each takes own bunches of triggers
+   fNumWorkers = Cfg("BuildWorkers", cmd).AsInt(0);
+   fWorkerIndx = cmd.GetInt("WorkerIndex", -1);
+   fWorkersBunch = Cfg("WorkersBunch", cmd).AsUInt(16);
+   fOrderedMerge = Cfg("OrderedMerge", cmd).AsBool(true);
+   if (fWorkersBunch < 1) fWorkersBunch = 1;
+   if ((fNumWorkers > 1) && (fBNETsend || fBNETrecv)) {
+      EOUT("HADAQ %s several build workers not supported in BNET mode", GetName());
+      fNumWorkers = 0;
+   }
+   if (fNumWorkers < 2) { fNumWorkers = 0; fWorkerIndx = -1; }
+
    fExtraDebug = Cfg("ExtraDebug", cmd).AsBool(true);
 
    fCheckTag = Cfg("CheckTag", cmd).AsBool(true);
@@ -108,11 +120,42 @@ hadaq::CombinerModule::CombinerModule(const std::string &name, dabc::Command cmd
       fCfg.emplace_back();
       fCfg[n].Reset(true);
       fCfg[n].fResort = FindPort(InputName(n)).Cfg("resort").AsBool(false);
+      // resort marks used subevents in the input buffers, which are shared by all workers
+      if (fCfg[n].fResort && (fNumWorkers > 0)) {
+         EOUT("HADAQ %s resort on input %u not supported with build workers, disable it", GetName(), n);
+         fCfg[n].fResort = false;
+      }
       if (fCfg[n].fResort) DOUT0("Do resort on input %u",n);
    }
 
+   if (IsWorkersMaster()) {
+      // second output always reserved for hld file, outputs to workers created after it
+      EnsurePorts(0, 2);
+      fNumDataOutputs = NumOutputs();
+
+      for (int w = 0; w < fNumWorkers; w++) {
+         fWorkers.emplace_back();
+         fWorkers[w].fName = dabc::format("%sWorker%d", GetName(), w);
+         fWorkers[w].fInput = CreateInput(dabc::format("Worker%d", w));
+      }
+
+      // for every input - one output to each worker
+      for (unsigned n = 0; n < fCfg.size(); n++)
+         for (int w = 0; w < fNumWorkers; w++)
+            CreateOutput(dabc::format("Input%uWorker%d", n, w));
+
+      DOUT0("HADAQ %s build events in %d workers, bunch %u %s merge", GetName(), fNumWorkers, fWorkersBunch, fOrderedMerge ? "ordered" : "unordered");
+   }
+
    fFlushTimeout = Cfg(dabc::xmlFlushTimeout, cmd).AsDouble(1.);
 
+   // events assembled from references on input buffers, only headers are written
+   fZeroCopy = Cfg("ZeroCopy", cmd).AsUInt(0);
+   if (fZeroCopy > 0) {
+      if (fZeroCopy < fCfg.size() + 2) fZeroCopy = fCfg.size() + 2;
+      DOUT0("HADAQ %s build events without copy, up to %u segments in output buffer", GetName(), fZeroCopy);
+   }
+
    // provide timeout with period/2, but trigger flushing after 3 counts
    // this will lead to effective flush time between FlushTimeout and FlushTimeout*1.5
    CreateTimer("FlushTimer", (fFlushTimeout > 0) ? fFlushTimeout/2. : 1.);
@@ -148,7 +191,7 @@ hadaq::CombinerModule::CombinerModule(const std::string &name, dabc::Command cmd
    } else if (fBNETsend) {
       CreateCmdDef("BnetCalibrControl").SetField("_hidden", true);
       CreateCmdDef("BnetCalibrRefresh").SetField("_hidden", true);
-   } else {
+   } else if (!IsWorker()) {
       CreateCmdDef("StartHldFile")
          .AddArg("filename", "string", true, "file.hld")
          .AddArg(dabc::xml_maxsize, "int", false, 1500)
@@ -238,6 +281,8 @@ void hadaq::CombinerModule::ProcessTimerEvent(unsigned timer)
 
    fTimerCalls++;
 
+   if (IsWorkersMaster()) CollectWorkersStatistic();
+
    Par(fDataRateName).SetValue(fDataRateCnt/1024./1024.);
    Par(fEventRateName).SetValue(fEventRateCnt);
    Par(fLostEventRateName).SetValue(fLostEventRateCnt);
@@ -265,7 +310,7 @@ void hadaq::CombinerModule::StartEventsBuilding()
 
    while (IsRunning() && (cnt-- > 0)) {
       // no need to continue
-      if (!BuildEvent()) return;
+      if (!(IsWorkersMaster() ? ProcessWorkers() : BuildEvent())) return;
    }
 
    if (!fSpecialFired) {
@@ -299,6 +344,7 @@ void hadaq::CombinerModule::BeforeModuleStart()
 
    fLastProcTm = fLastDropTm;
    fLastBuildTm = fLastDropTm;
+   fLastMergeTm = fLastDropTm;
 
    // activate BNET checks
    if (fBNETsend)
@@ -307,11 +353,16 @@ void hadaq::CombinerModule::BeforeModuleStart()
    // direct addon pointers can be used for terminal printout
    for (unsigned ninp=0;ninp<fCfg.size();ninp++) {
       fCfg[ninp].fQueueCapacity = InputQueueCapacity(ninp);
-      if (fBNETrecv) continue;
+      if (fBNETrecv || IsWorker()) continue;
       dabc::Command cmd("GetHadaqTransportInfo");
       cmd.SetInt("id", ninp);
       SubmitCommandToTransport(InputName(ninp), Assign(cmd));
    }
+
+   if (IsWorkersMaster()) ConnectWorkers();
+
+   for (auto &wrk : fWorkers)
+      dabc::mgr.FindModule(wrk.fName).Start();
 }
 
 void hadaq::CombinerModule::AfterModuleStop()
@@ -323,6 +374,13 @@ void hadaq::CombinerModule::AfterModuleStop()
    SetInfo(info, true);
    DOUT0(info.c_str());
 
+   if ((fZeroCopy > 0) || (IsWorkersMaster() && fOrderedMerge))
+      DOUT0("HADAQ %s zero-copy building referenced %s, copied %s", GetName(),
+            dabc::size_to_str(fOut.NumRefBytes()).c_str(), dabc::size_to_str(fOut.NumCopyBytes()).c_str());
+
+   for (auto &wrk : fWorkers)
+      dabc::mgr.FindModule(wrk.fName).Stop();
+
    // when BNET receiver module stopped, lead to application stop
    if (fBNETrecv) dabc::mgr.StopApplication();
 }
@@ -337,7 +395,7 @@ bool hadaq::CombinerModule::FlushOutputBuffer()
 
    int dest = DestinationPort(fLastTrigNr);
    if (dest<0) {
-      if (!CanSendToAllOutputs()) return false;
+      if (!CanSendToOutputs(0, NumDataOutputs())) return false;
    } else {
       if (!CanSend(dest)) return false;
    }
@@ -347,7 +405,7 @@ bool hadaq::CombinerModule::FlushOutputBuffer()
    // if (fBNETsend) DOUT0("%s FLUSH buffer", GetName());
 
    if (dest<0)
-      SendToAllOutputs(buf);
+      SendToOutputs(0, NumDataOutputs(), buf);
    else
       Send(dest, buf);
 
@@ -731,10 +789,17 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
          return false;
       }
 
+      // subevent header decoded when buffer was indexed
+      const SubeventInfo &info = iter.subevnt_info();
+
+      // worker takes only subevents from own bunches of triggers
+      if (IsWorker() && !IsWorkerTrigger(info.trignr)) continue;
+
       // no need to analyze data
       if (fast) return true;
 
       if (tryresort && (cfg.fLastTrigNr!=0xffffffff)) {
+         // read from memory, processed subevents are marked after buffer was indexed
          uint32_t trignr = iter.subevnt()->GetTrigNr();
          if (trignr==0xffffffff) continue; // this is processed trigger, exclude it
 
@@ -744,7 +809,7 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
 
             if (cfg.fResortIndx < 0) {
                cfg.fResortIndx = 0;
-               cfg.fResortIter = cfg.fIter;
+               cfg.fResortIter.AssignPosition(cfg.fIter);
             }
             continue;
          }
@@ -755,10 +820,10 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
       // this is selected subevent
       cfg.subevnt = iter.subevnt();
       cfg.has_data = true;
-      cfg.data_size = cfg.subevnt->GetPaddedSize();
+      cfg.data_size = info.GetPaddedSize();
 
-      cfg.fTrigNr = (cfg.subevnt->GetTrigNr() >> 8) & fTriggerRangeMask;
-      cfg.fTrigTag = cfg.subevnt->GetTrigNr() & 0xFF;
+      cfg.fTrigNr = (info.trignr >> 8) & fTriggerRangeMask;
+      cfg.fTrigTag = info.GetTrigTag();
 
       // try to fix problem with TRB2 readout
       // Produced sequence of trigger numbers are: 0x2bffff, 0x2b0000, 0x2c0001 and repeated every 64k events
@@ -778,15 +843,15 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
       cfg.fTrigNumRing[cfg.fRingCnt] = cfg.fTrigNr;
       cfg.fRingCnt = (cfg.fRingCnt+1) % HADAQ_RINGSIZE;
 
-      cfg.fEmpty = cfg.subevnt->GetSize() <= sizeof(hadaq::RawSubevent);
-      cfg.fDataError = cfg.subevnt->GetDataError();
+      cfg.fEmpty = info.IsEmpty();
+      cfg.fDataError = info.GetDataError();
 
-      cfg.fHubId = cfg.subevnt->GetId() & 0xffff;
+      cfg.fHubId = info.id & 0xffff;
 
       /* Evaluate trigger type:*/
       /* NEW for trb3: trigger type is part of decoding word*/
       if (!fHadesTriggerType) {
-         cfg.fTrigType = cfg.subevnt->GetTrigTypeTrb3();
+         cfg.fTrigType = info.GetTrigTypeTrb3();
       } else if (cfg.fHubId == fHadesTriggerHUB) {
          unsigned wordNr = 2;
          uint32_t bitmask = 0xff000000; /* extended mask to contain spill on/off bit*/
@@ -799,7 +864,7 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
          cfg.fTrigType = 0;
       }
 
-      uint32_t errorBits = cfg.subevnt->GetErrBits();
+      uint32_t errorBits = info.errbits;
 
       if ((errorBits != 0) && (errorBits != 1))
          cfg.fErrorBitsCnt++;
@@ -809,6 +874,8 @@ bool hadaq::CombinerModule::ShiftToNextSubEvent(unsigned ninp, bool fast, bool d
          diff = CalcTrigNumDiff(cfg.fLastTrigNr, cfg.fTrigNr);
       cfg.fLastTrigNr = cfg.fTrigNr;
 
+      if (IsWorker()) diff = ExcludeBunchesGap(diff, fWorkersBunch, fNumWorkers);
+
       if (diff>1) cfg.fLostTrig += (diff-1);
    }
 
@@ -853,6 +920,28 @@ bool hadaq::CombinerModule::DropAllInputBuffers()
    return true;
 }
 
+int hadaq::CombinerModule::ExcludeBunchesGap(int diff, int bunch, int numbuilders)
+{
+   // when bunches of events distributed between several builders,
+   // every builder sees gap in trigger numbers between own bunches
+
+   if ((numbuilders < 2) || (diff <= bunch)) return diff;
+
+   long ncycles = diff / (bunch * numbuilders);
+
+   // substract big cycles
+   diff -= ncycles * (bunch * numbuilders);
+
+   // substract expected gap to previous cycle
+   diff -= bunch * (numbuilders - 1);
+   if (diff <= 0) diff = 1;
+
+   // add lost events from big cycles
+   diff += ncycles * bunch;
+
+   return diff;
+}
+
 int hadaq::CombinerModule::DestinationPort(uint32_t trignr)
 {
    if (!fBNETsend || (NumOutputs()<2)) return -1;
@@ -1084,7 +1173,8 @@ bool hadaq::CombinerModule::BuildEvent()
    // for sync sequence number, check first if we have error from cts:
    uint32_t sequencenumber = fRunBuildEvents + 1; // HADES convention: sequencenumber 0 is "start event" of file
 
-   if (fBNETsend)
+   // worker provides trigger number, master uses it to merge events and assigns new sequence number
+   if (fBNETsend || IsWorker())
       sequencenumber = (fCfg[masterchannel].fTrigNr << 8) | fCfg[masterchannel].fTrigTag;
 
    if (hasCompleteEvent && fCheckTag && tagError) {
@@ -1124,7 +1214,7 @@ bool hadaq::CombinerModule::BuildEvent()
 
             return false;
          }
-         if (!fOut.Reset(buf)) {
+         if (!(fZeroCopy ? fOut.ResetZeroCopy(buf, fZeroCopy, fCfg.size()) : fOut.Reset(buf))) {
             SetInfo("Cannot use buffer for output - hard error!!!!", true);
             buf.Release();
             dabc::mgr.StopApplication();
@@ -1173,8 +1263,13 @@ bool hadaq::CombinerModule::BuildEvent()
       // third input loop: build output event from all not empty subevents
       for (unsigned ninp = 0; ninp < fCfg.size(); ninp++) {
          if (fCfg[ninp].fEmpty && fSkipEmpty) continue;
-         if (fBNETrecv)
+         if (fZeroCopy && fBNETrecv)
+            fOut.AddSubeventRef(dabc::Pointer(fCfg[ninp].fIter.evnt_ptr(), sizeof(hadaq::RawEvent)), fCfg[ninp].data_size);
+         else if (fBNETrecv)
             fOut.AddAllSubevents(fCfg[ninp].evnt);
+         else if (fZeroCopy && (fCfg[ninp].fResortIndx < 0))
+            // subevent from resort iterator will be marked as used, therefore copied
+            fOut.AddSubeventRef(fCfg[ninp].fIter.subevnt_ptr(), fCfg[ninp].data_size);
          else
             fOut.AddSubevent(fCfg[ninp].subevnt);
          DoInputSnapshot(ninp); // record current state of event tag and queue level for control system
@@ -1196,26 +1291,11 @@ bool hadaq::CombinerModule::BuildEvent()
       fprintf(stderr, "BUILD:%6x\n", buildevid);
 #endif
 
-      if (fBNETrecv && fEvnumDiffStatistics && (fBNETNumRecv > 1) && (diff > fBNETbunch)) {
-         // check if we really lost these events
-         // int diff0 = diff;
-
-         long ncycles = diff / (fBNETbunch * fBNETNumRecv);
-
-         // substract big cycles
-         diff -= ncycles * (fBNETbunch * fBNETNumRecv);
-
-         // substract expected gap to previous cycle
-         diff -= fBNETbunch * (fBNETNumRecv - 1);
-         if (diff <= 0) diff = 1;
-
-         // add lost events from big cycles
-         diff += ncycles * fBNETbunch;
-
-         // if (diff != 1) {
-         //   DOUT0("Large EVENT difference %d bunch %ld ncycles %ld final %d", diff0, fBNETbunch, ncycles, diff);
-         //}
-      }
+      // check if we really lost these events
+      if (fBNETrecv && fEvnumDiffStatistics)
+         diff = ExcludeBunchesGap(diff, fBNETbunch, fBNETNumRecv);
+      else if (IsWorker() && fEvnumDiffStatistics)
+         diff = ExcludeBunchesGap(diff, fWorkersBunch, fNumWorkers);
 
       fLastTrigNr = buildevid;
 
@@ -1283,6 +1363,303 @@ bool hadaq::CombinerModule::BuildEvent()
 }
 
 
+void hadaq::CombinerModule::OnThreadAssigned()
+{
+   dabc::ModuleAsync::OnThreadAssigned();
+
+   if (IsWorkersMaster()) CreateWorkers();
+}
+
+void hadaq::CombinerModule::CreateWorkers()
+{
+   for (int w = 0; w < fNumWorkers; w++) {
+      WorkerCfg &wrk = fWorkers[w];
+
+      // each worker runs in own thread, parameters relevant for events building are copied
+      dabc::CmdCreateModule cmd("hadaq::CombinerModule", wrk.fName, wrk.fName + "Thrd");
+      cmd.SetInt(dabc::xmlNumInputs, fCfg.size());
+      cmd.SetInt(dabc::xmlNumOutputs, 1);
+      cmd.SetStr(dabc::xmlPoolName, PoolName());
+      cmd.SetInt("BuildWorkers", fNumWorkers);
+      cmd.SetInt("WorkerIndex", w);
+      cmd.SetUInt("WorkersBunch", fWorkersBunch);
+      cmd.SetUInt("ZeroCopy", fZeroCopy);
+      cmd.SetUInt(hadaq::xmlHadaqTrignumRange, fMaxHadaqTrigger);
+      cmd.SetInt(hadaq::xmlHadaqTriggerTollerance, fTriggerNrTolerance);
+      cmd.SetBool(hadaq::xmlHadaqDiffEventStats, fEvnumDiffStatistics);
+      cmd.SetDouble(hadaq::xmlEvtbuildTimeout, fEventBuildTimeout);
+      cmd.SetBool(hadaq::xmlHadesTriggerType, fHadesTriggerType);
+      cmd.SetUInt(hadaq::xmlHadesTriggerHUB, fHadesTriggerHUB);
+      cmd.SetDouble(dabc::xmlFlushTimeout, fFlushTimeout);
+      cmd.SetBool("CheckTag", fCheckTag);
+      cmd.SetBool("SkipEmpty", fSkipEmpty);
+      cmd.SetBool("ExtraDebug", fExtraDebug);
+
+      dabc::mgr.Execute(cmd);
+
+      if (dabc::mgr.FindModule(wrk.fName).null()) {
+         EOUT("HADAQ %s fail to create worker %s", GetName(), wrk.fName.c_str());
+         dabc::mgr.StopApplication();
+         return;
+      }
+   }
+}
+
+void hadaq::CombinerModule::ConnectWorkers()
+{
+   // ports are connected only before start, while application disconnects all ports without transport
+
+   for (unsigned w = 0; w < fWorkers.size(); w++) {
+      WorkerCfg &wrk = fWorkers[w];
+
+      dabc::ModuleRef m = dabc::mgr.FindModule(wrk.fName);
+      if (m.null()) continue;
+
+      for (unsigned n = 0; n < fCfg.size(); n++) {
+         unsigned nout = fNumDataOutputs + n*fNumWorkers + w;
+         if (!IsOutputConnected(nout))
+            dabc::mgr.Connect(OutputName(nout, true), m.InputName(n));
+      }
+
+      if (!dabc::Module::IsInputConnected(wrk.fInput))
+         dabc::mgr.Connect(m.OutputName(0), InputName(wrk.fInput, true));
+   }
+}
+
+bool hadaq::CombinerModule::ProcessWorkers()
+{
+   dabc::ProfilerGuard grd(fBldProfiler, "dstr", 0);
+
+   fBldCalls++;
+
+   bool res = DistributeInputs();
+
+   grd.Next("merge");
+
+   for (int cnt = 0; cnt < 100; cnt++) {
+      if (!(fOrderedMerge ? MergeWorkersEvent() : ForwardWorkersBuffer())) break;
+      res = true;
+   }
+
+   return res;
+}
+
+bool hadaq::CombinerModule::DistributeInputs()
+{
+   // every input buffer delivered to all workers, each worker uses only own triggers
+
+   bool res = false;
+
+   for (unsigned ninp = 0; ninp < fCfg.size(); ninp++) {
+      unsigned first = fNumDataOutputs + ninp*fNumWorkers;
+
+      while (CanRecv(ninp) && CanSendToOutputs(first, fNumWorkers)) {
+         dabc::Buffer buf = Recv(ninp);
+         fNumReadBuffers++;
+         SendToOutputs(first, fNumWorkers, buf);
+         res = true;
+      }
+
+      DoInputSnapshot(ninp);
+   }
+
+   return res;
+}
+
+bool hadaq::CombinerModule::ShiftToNextWorkerEvent(unsigned nw)
+{
+   WorkerCfg &wrk = fWorkers[nw];
+
+   wrk.evnt = nullptr;
+
+   while (!wrk.fIter.NextEvent()) {
+      wrk.fIter.Close();
+      if (!CanRecv(wrk.fInput)) return false;
+      dabc::Buffer buf = Recv(wrk.fInput);
+      if (buf.GetTypeId() == hadaq::mbt_HadaqEvents)
+         wrk.fIter.Reset(buf);
+   }
+
+   wrk.evnt = wrk.fIter.evnt();
+   wrk.fTrigNr = (wrk.evnt->GetSeqNr() >> 8) & fTriggerRangeMask;
+
+   return true;
+}
+
+bool hadaq::CombinerModule::MergeWorkersEvent()
+{
+   // select event with minimal trigger number, when data from some worker is missing
+   // wait until worker flushes its buffer
+
+   int sel = -1;
+   bool all = true;
+
+   for (unsigned nw = 0; nw < fWorkers.size(); nw++) {
+      if (!fWorkers[nw].evnt && !ShiftToNextWorkerEvent(nw)) {
+         all = false;
+         continue;
+      }
+      if ((sel < 0) || (CalcTrigNumDiff(fWorkers[nw].fTrigNr, fWorkers[sel].fTrigNr) > 0))
+         sel = nw;
+   }
+
+   // waiting time counted from the moment when first worker delivers data
+   if (sel < 0) {
+      fLastMergeTm.GetNow();
+      return false;
+   }
+
+   if (all)
+      fLastMergeTm.GetNow();
+   else if (!fLastMergeTm.Expired((fFlushTimeout > 0) ? 2*fFlushTimeout : 2.))
+      return false;
+
+   WorkerCfg &wrk = fWorkers[sel];
+
+   uint32_t subeventssize = wrk.evnt->AllSubeventsSize();
+
+   if (fOut.IsBuffer() && !fOut.IsPlaceForEvent(subeventssize))
+      if (!FlushOutputBuffer()) return false;
+
+   if (!fOut.IsBuffer()) {
+      dabc::Buffer buf = TakeBuffer();
+      if (buf.null()) return false;
+
+      // events always referenced in worker buffers, otherwise master thread copies all data once again
+      // event of zero-copy worker may consist from header, subevents and paddings segments
+      if (!fOut.ResetZeroCopy(buf, fZeroCopy > 0 ? fZeroCopy : 4096, 2*fCfg.size() + 2)) {
+         SetInfo("Cannot use buffer for output - hard error!!!!", true);
+         buf.Release();
+         dabc::mgr.StopApplication();
+         return false;
+      }
+   }
+
+   if (fOut.IsPlaceForEvent(subeventssize)) {
+      // worker buffer used only by master - event renumbered in place and referenced completely,
+      // consecutive events of same worker become single segment of output buffer
+      wrk.evnt->SetSeqNr(fRunBuildEvents + 1);
+      wrk.evnt->SetRunNr(fRunNumber);
+
+      dabc::Pointer ptr = wrk.fIter.evnt_ptr();
+      unsigned len = wrk.evnt->GetPaddedSize();
+      if (ptr.fullsize() < len) len = wrk.evnt->GetSize();
+
+      if (!fOut.AddEventRef(ptr, len)) {
+         // source from other pool, copy event
+         fOut.NewEvent(fRunBuildEvents + 1, fRunNumber);
+         fOut.evnt()->SetId(wrk.evnt->GetId());
+         fOut.AddSubeventRef(dabc::Pointer(ptr, sizeof(hadaq::RawEvent)), subeventssize);
+         fOut.FinishEvent();
+      }
+
+      fRunBuildEvents++;
+      fAllBuildEvents++;
+      fEventRateCnt++;
+
+      unsigned currentbytes = subeventssize + sizeof(hadaq::RawEvent);
+      fRunRecvBytes += currentbytes;
+      fAllRecvBytes += currentbytes;
+      fDataRateCnt += currentbytes;
+
+      wrk.fMergedEvents++;
+      fLastTrigNr = wrk.fTrigNr;
+   } else {
+      DOUT0("New buffer has not enough space, skip event!");
+   }
+
+   fMergeWorker = sel;
+   wrk.evnt = nullptr;
+
+   return true;
+}
+
+bool hadaq::CombinerModule::ForwardWorkersBuffer()
+{
+   // buffers from workers delivered to outputs as is, only events sequence numbers are changed
+
+   if (!CanSendToOutputs(0, fNumDataOutputs)) return false;
+
+   for (unsigned cnt = 0; cnt < fWorkers.size(); cnt++) {
+      fMergeWorker = (fMergeWorker + 1) % fWorkers.size();
+      WorkerCfg &wrk = fWorkers[fMergeWorker];
+
+      if (!CanRecv(wrk.fInput)) continue;
+
+      dabc::Buffer buf = Recv(wrk.fInput);
+      if (buf.GetTypeId() != hadaq::mbt_HadaqEvents) continue;
+
+      ReadIterator iter(buf);
+      while (iter.NextEvent()) {
+         iter.evnt()->SetSeqNr(++fRunBuildEvents);
+         iter.evnt()->SetRunNr(fRunNumber);
+         fAllBuildEvents++;
+         fEventRateCnt++;
+         wrk.fMergedEvents++;
+         unsigned currentbytes = iter.evnt()->GetSize();
+         fRunRecvBytes += currentbytes;
+         fAllRecvBytes += currentbytes;
+         fDataRateCnt += currentbytes;
+      }
+      iter.Close();
+
+      SendToOutputs(0, fNumDataOutputs, buf);
+      return true;
+   }
+
+   return false;
+}
+
+void hadaq::CombinerModule::CollectWorkersStatistic()
+{
+   // counters of workers summarized to show them in terminal and in rate parameters
+
+   uint64_t disc = 0, dropped = 0;
+
+   for (unsigned n = 0; n < fCfg.size(); n++)
+      fCfg[n].fDroppedTrig = fCfg[n].fLostTrig = fCfg[n].fErrorBitsCnt = 0;
+
+   for (unsigned nw = 0; nw < fWorkers.size(); nw++) {
+      dabc::ModuleRef m = dabc::mgr.FindModule(fWorkers[nw].fName);
+      hadaq::CombinerModule *comb = dynamic_cast<hadaq::CombinerModule *> (m());
+      if (!comb) continue;
+
+      WorkerCfg &wrk = fWorkers[nw];
+      wrk.fBuildEvents = comb->fAllBuildEvents;
+      wrk.fBuildData = comb->fAllRecvBytes;
+      wrk.fDiscEvents = comb->fAllDiscEvents;
+      wrk.fInpQueue = 0;
+
+      disc += comb->fAllDiscEvents;
+      dropped += comb->fAllDroppedData;
+
+      for (unsigned n = 0; (n < fCfg.size()) && (n < comb->fCfg.size()); n++) {
+         InputCfg &src = comb->fCfg[n];
+         fCfg[n].fDroppedTrig += src.fDroppedTrig;
+         fCfg[n].fLostTrig += src.fLostTrig;
+         fCfg[n].fErrorBitsCnt += src.fErrorBitsCnt;
+         if (src.fNumCanRecv > wrk.fInpQueue) wrk.fInpQueue = src.fNumCanRecv;
+         // last seen triggers taken from worker which delivered last event
+         if (nw == fMergeWorker) {
+            std::copy(src.fTrigNumRing, src.fTrigNumRing + HADAQ_RINGSIZE, fCfg[n].fTrigNumRing);
+            fCfg[n].fRingCnt = src.fRingCnt;
+         }
+      }
+   }
+
+   if (disc > fAllDiscEvents) {
+      fLostEventRateCnt += disc - fAllDiscEvents;
+      fRunDiscEvents += disc - fAllDiscEvents;
+   }
+   if (dropped > fAllDroppedData) {
+      fDataDroppedRateCnt += dropped - fAllDroppedData;
+      fRunDroppedData += dropped - fAllDroppedData;
+   }
+
+   fAllDiscEvents = disc;
+   fAllDroppedData = dropped;
+}
+
 void  hadaq::CombinerModule::DoInputSnapshot(unsigned ninp)
 {
    // copy here input properties at the moment of event building to stats:
@@ -1363,6 +1740,9 @@ int hadaq::CombinerModule::ExecuteCommand(dabc::Command cmd)
 
       DropAllInputBuffers();
 
+      for (auto &wrk : fWorkers)
+         dabc::mgr.FindModule(wrk.fName).Submit(dabc::Command("HCMD_DropAllBuffers"));
+
       if (fBNETsend && !fIsTerminating) {
          for (unsigned n = 0; n < NumInputs(); n++) {
             fCfg[n].fErrorBitsCnt = 0;
@@ -1532,8 +1912,8 @@ void hadaq::CombinerModule::ResetInfoCounters()
    fRunTagErrors = 0;
    fRunDataErrors = 0;
 
-   if (!fBNETrecv && !fIsTerminating)
-      for (unsigned n = 0; n < NumInputs(); n++) {
+   if (!fBNETrecv && !IsWorker() && !fIsTerminating)
+      for (unsigned n = 0; n < fCfg.size(); n++) {
          SubmitCommandToTransport(InputName(n), dabc::Command("ResetTransportStat"));
 
          fCfg[n].fLastEvtBuildTrigId = 0;
@@ -158,12 +158,14 @@ dabc::Module* hadaq::Factory::CreateTransport(const dabc::Reference& port, const
    bool debug = url.HasOption("debug");
    int udp_queue = url.GetOptionInt("upd_queue", 0);
    double heartbeat = url.GetOptionDouble("heartbeat", -1.);
+   int batch = url.GetOptionInt("batch", 0);
+   double batchtm = url.GetOptionDouble("batchtm", 0.);
 
    if (udp_queue>0) cmd.SetInt("TransportQueue", udp_queue);
 
    DOUT0("Start HADAQ UDP transport on %s", url.GetHostNameWithPort().c_str());
 
-   NewAddon* addon = new NewAddon(fd, nport, mtu, debug, maxloop, reduce, lost_rate);
+   NewAddon* addon = new NewAddon(fd, nport, mtu, debug, maxloop, reduce, lost_rate, batch, batchtm);
 	return new hadaq::NewTransport(cmd, portref, addon, flush, heartbeat);
 }
 
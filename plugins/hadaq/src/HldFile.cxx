@@ -136,6 +136,19 @@ bool hadaq::HldFile::WriteBuffer(void* buf, uint32_t bufsize)
    return true;
 }
 
+bool hadaq::HldFile::WriteBuffers(const void* const* bufs, const size_t* sizes, unsigned num)
+{
+   if (!isWriting() || (bufs==0) || (sizes==0)) return false;
+
+   if (!io->fwritev(bufs, sizes, num, fd)) {
+      fprintf(stderr, "fail to write %u buffers\n", num);
+      CloseBasicFile();
+      return false;
+   }
+
+   return true;
+}
+
 bool hadaq::HldFile::ReadBuffer(void* ptr, uint32_t* sz, bool onlyevent)
 {
    if (!isReading() || (ptr==0) || (sz==0) || (*sz < sizeof(hadaq::HadTu))) return false;
@@ -25,9 +25,14 @@
 
 hadaq::HldInput::HldInput(const dabc::Url& url) :
    dabc::FileInput(url),
-   fFile()
+   fFile(),
+   fMapped(),
+   fMapWindow(0),
+   fMapEOF(false)
 {
-   if (url.HasOption("rfio"))
+   if (url.HasOption("mmap"))
+      fMapWindow = ((uint64_t) url.GetOptionInt("mmap", 64)) * 1024 * 1024;
+   else if (url.HasOption("rfio"))
      fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("rfio::FileInterface"), true);
    else if (url.HasOption("ltsm"))
      fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("ltsm::FileInterface"), true);
@@ -51,6 +56,25 @@ bool hadaq::HldInput::OpenNextFile()
 
    if (!TakeNextFileName()) return false;
 
+   if (fMapWindow > 0) {
+      const char* ptr = nullptr;
+      if (fMapped.Open(CurrentFileName().c_str(), fMapWindow))
+         ptr = fMapped.Map(sizeof(hadaq::RawEvent));
+
+      if (!ptr || (((hadaq::RawEvent*) ptr)->GetPaddedSize() != sizeof(hadaq::RawEvent)) ||
+          (((hadaq::RawEvent*) ptr)->GetId() != EvtId_runStart)) {
+         EOUT("Cannot find start event in mapped file %s", CurrentFileName().c_str());
+         fMapped.Close();
+         return false;
+      }
+
+      fMapped.Skip(sizeof(hadaq::RawEvent));
+      fMapEOF = false;
+
+      DOUT1("Map hld file %s for reading", CurrentFileName().c_str());
+      return true;
+   }
+
    if (!fFile.OpenRead(CurrentFileName().c_str())) {
       EOUT("Cannot open file %s for reading", CurrentFileName().c_str());
       return false;
@@ -65,22 +89,72 @@ bool hadaq::HldInput::OpenNextFile()
 bool hadaq::HldInput::CloseFile()
 {
    fFile.Close();
+   fMapped.Close();
    ClearCurrentFileName();
    return true;
 }
 
 unsigned hadaq::HldInput::Read_Size()
 {
-   if (!fFile.isReading()) return dabc::di_Error;
+   if (!isReading()) return dabc::di_Error;
 
-   if (fFile.eof())
+   if (isEOF())
       if (!OpenNextFile()) return dabc::di_EndOfStream;
 
    return dabc::di_DfltBufSize;
 }
 
+unsigned hadaq::HldInput::ReadMapped(dabc::Buffer& buf)
+{
+   // buffer from the pool only defines maximal size of produced buffer
+   uint64_t maxsize = ((uint64_t) (buf.SegmentSize(0) * fReduce) / 4) * 4, size = 0;
+
+   while (size < maxsize) {
+      // events are collected only in same window, Map() creates new window when event crosses its boundary
+      const char* ptr = fMapped.Map(size + sizeof(hadaq::HadTu));
+      if (!ptr) { fMapEOF = true; break; }
+
+      hadaq::RawEvent* evnt = (hadaq::RawEvent*) (ptr + size);
+      uint64_t evsize = evnt->GetPaddedSize();
+
+      if (evsize < sizeof(hadaq::HadTu)) {
+         EOUT("Wrong event size %u in file %s", (unsigned) evsize, CurrentFileName().c_str());
+         return dabc::di_Error;
+      }
+
+      // stop event is not delivered to the top
+      if ((evsize == sizeof(hadaq::RawEvent)) && (evnt->GetId() == EvtId_runStop)) { fMapEOF = true; break; }
+
+      if (size + evsize > maxsize) {
+         if (size > 0) break;
+         EOUT("Buffer %u too small to read next event %u from hld file", (unsigned) maxsize, (unsigned) evsize);
+         return dabc::di_Error;
+      }
+
+      if (!fMapped.Map(size + evsize)) {
+         EOUT("Event of size %u truncated in file %s", (unsigned) evsize, CurrentFileName().c_str());
+         fMapEOF = true;
+         break;
+      }
+
+      size += evsize;
+   }
+
+   // let switch file on the next turn
+   if (size == 0) return dabc::di_SkipBuffer;
+
+   buf = fMapped.Take(size);
+   buf.SetTypeId(hadaq::mbt_HadaqEvents);
+
+   DOUT3("HLD file mapped %u bytes from %s file", (unsigned) size, CurrentFileName().c_str());
+
+   return dabc::di_Ok;
+}
+
 unsigned hadaq::HldInput::Read_Complete(dabc::Buffer& buf)
 {
+   if (fMapWindow > 0) return ReadMapped(buf);
+
    if (fFile.eof()) {
       EOUT("EOF should not happen when buffer reading should be started");
       return dabc::di_Error;
@@ -73,6 +73,9 @@ hadaq::HldOutput::HldOutput(const dabc::Url& url) :
 	   } else {
 		   EOUT("Cannot create LTSM object, check if libDabcLtsm.so loaded");
 	   }
+   } else if (url.HasOption("direct") || url.HasOption("prealloc") || url.HasOption("posix")) {
+      // preallocation portion specified in MB
+      fFile.SetIO(new dabc::PosixFileInterface(url.HasOption("direct"), ((uint64_t) url.GetOptionInt("prealloc", 0)) << 20), true);
    }
 }
 
@@ -352,7 +355,9 @@ unsigned hadaq::HldOutput::Write_Buffer(dabc::Buffer& buf)
    if (is_subev) {
       // this is list of subevents in the buffer, one need to add artificial events headers for each subevents
 
-      hadaq::RawEvent evnt;
+      std::vector<hadaq::RawEvent> hdrs;
+      std::vector<const void*> ptrs;
+      std::vector<size_t> sizes;
 
       hadaq::ReadIterator iter(buf);
       while (iter.NextSubeventsBlock()) {
@@ -360,24 +365,37 @@ unsigned hadaq::HldOutput::Write_Buffer(dabc::Buffer& buf)
          if (!iter.NextSubEvent())
             return dabc::do_Error;
 
-         char* write_ptr = (char*) iter.subevnt();
          unsigned write_size = iter.subevnt()->GetPaddedSize();
 
-         evnt.Init(fEventNumber++, fRunNumber);
-         evnt.SetSize(write_size + sizeof(hadaq::RawEvent));
+         hdrs.push_back(hadaq::RawEvent());
+         hdrs.back().Init(fEventNumber++, fRunNumber);
+         hdrs.back().SetSize(write_size + sizeof(hadaq::RawEvent));
 
-         if (!fFile.WriteBuffer(&evnt, sizeof(hadaq::RawEvent)))
-            return dabc::do_Error;
-
-         if (!fFile.WriteBuffer(write_ptr, write_size))
-            return dabc::do_Error;
+         ptrs.push_back(iter.subevnt());
+         sizes.push_back(write_size);
 
          total_write_size += sizeof(hadaq::RawEvent) + write_size;
          num_events ++;
       }
 
+      // artificial headers are interleaved with subevents and written at once
+      std::vector<const void*> wptrs(ptrs.size()*2);
+      std::vector<size_t> wsizes(ptrs.size()*2);
+      for (unsigned n = 0; n < ptrs.size(); n++) {
+         wptrs[n*2] = &hdrs[n];
+         wsizes[n*2] = sizeof(hadaq::RawEvent);
+         wptrs[n*2+1] = ptrs[n];
+         wsizes[n*2+1] = sizes[n];
+      }
+
+      if ((wptrs.size() > 0) && !fFile.WriteBuffers(wptrs.data(), wsizes.data(), wptrs.size()))
+         return dabc::do_Error;
+
    } else if (is_events) {
 
+      std::vector<const void*> ptrs;
+      std::vector<size_t> sizes;
+
       for (unsigned n=0;n<buf.NumSegments();n++) {
 
          unsigned write_size = buf.SegmentSize(n);
@@ -402,15 +420,19 @@ unsigned hadaq::HldOutput::Write_Buffer(dabc::Buffer& buf)
          if (fRunSlave && fRfio && startnewfile)
             DOUT1("HldOutput write %u bytes after new file was started", write_size);
 
-         if (!fFile.WriteBuffer(write_ptr, write_size))
-            return dabc::do_Error;
-
-         if (fRunSlave && fRfio && startnewfile)
-            DOUT1("HldOutput did write %u bytes after new file was started", write_size);
+         ptrs.push_back(write_ptr);
+         sizes.push_back(write_size);
 
          total_write_size += write_size;
       }
 
+      // all segments written with single call
+      if ((ptrs.size() > 0) && !fFile.WriteBuffers(ptrs.data(), sizes.data(), ptrs.size()))
+         return dabc::do_Error;
+
+      if (fRunSlave && fRfio && startnewfile)
+         DOUT1("HldOutput did write %u bytes after new file was started", total_write_size);
+
       num_events = hadaq::ReadIterator::NumEvents(buf);
    }
 
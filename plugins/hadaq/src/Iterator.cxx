@@ -15,8 +15,67 @@
 
 #include "hadaq/Iterator.h"
 
+#include <cstring>
+
 #include "dabc/logging.h"
 
+namespace hadaq {
+
+   static inline uint32_t SwapValue(uint32_t v)
+   {
+#if defined(__GNUC__)
+      return __builtin_bswap32(v);
+#else
+      return ((v & 0xFF) << 24) | ((v & 0xFF00) << 8) | ((v & 0xFF0000) >> 8) | ((v & 0xFF000000) >> 24);
+#endif
+   }
+
+   /** Decode subevent header, maxsize - memory available for the subevent */
+   static void DecodeSubevent(const char *ptr, uint32_t maxsize, SubeventInfo &info)
+   {
+      // all four header words swapped together, compiler can do it with single shuffle
+      uint32_t hdr[4];
+      memcpy(hdr, ptr, sizeof(hdr));
+      bool swapped = hdr[1] > 0xffffff;
+      if (swapped)
+         for (int n = 0; n < 4; n++)
+            hdr[n] = SwapValue(hdr[n]);
+
+      info.subevnt = (hadaq::RawSubevent *) ptr;
+      info.size = hdr[0];
+      info.decoding = hdr[1];
+      info.id = hdr[2];
+      info.trignr = hdr[3];
+      info.errbits = 0;
+
+      if ((info.size <= sizeof(hadaq::RawSubevent)) || (info.size > maxsize)) return;
+
+      // last data word, same as RawSubevent::GetErrBits()
+      const char *data = ptr + sizeof(hadaq::RawSubevent);
+      unsigned datasize = info.size - sizeof(hadaq::RawSubevent);
+
+      switch (1 << ((info.decoding >> 16) & 0xff)) {
+         case 4:
+            if (datasize >= 4) {
+               uint32_t v;
+               memcpy(&v, data + (datasize/4 - 1)*4, 4);
+               info.errbits = swapped ? SwapValue(v) : v;
+            }
+            break;
+         case 2:
+            if (datasize >= 2) {
+               uint16_t v;
+               memcpy(&v, data + (datasize/2 - 1)*2, 2);
+               if (swapped) v = ((v >> 8) & 0xff) | ((v << 8) & 0xff00);
+               info.errbits = v;
+            }
+            break;
+         default:
+            info.errbits = (uint8_t) data[datasize - 1];
+      }
+   }
+}
+
 hadaq::ReadIterator::ReadIterator() :
    fFirstEvent(false),
    fEvPtr(),
@@ -41,7 +100,14 @@ hadaq::ReadIterator::ReadIterator(const ReadIterator& src) :
    fEvPtr(src.fEvPtr),
    fSubPtr(src.fSubPtr),
    fRawPtr(src.fRawPtr),
-   fBufType(src.fBufType)
+   fBufType(src.fBufType),
+   fIndexing(src.fIndexing),
+   fIndexed(src.fIndexed),
+   fIndex(src.fIndex),
+   fIndexNext(src.fIndexNext),
+   fIndexPos(src.fIndexPos),
+   fContEnd(src.fContEnd),
+   fInfo(src.fInfo)
 {
 }
 
@@ -52,10 +118,40 @@ hadaq::ReadIterator& hadaq::ReadIterator::operator=(const ReadIterator& src)
    fSubPtr = src.fSubPtr;
    fRawPtr = src.fRawPtr;
    fBufType = src.fBufType;
+   fIndexing = src.fIndexing;
+   fIndexed = src.fIndexed;
+   fIndex = src.fIndex;
+   fIndexNext = src.fIndexNext;
+   fIndexPos = src.fIndexPos;
+   fContEnd = src.fContEnd;
+   fInfo = src.fInfo;
 
    return *this;
 }
 
+void hadaq::ReadIterator::AssignPosition(const ReadIterator& src)
+{
+   fFirstEvent = src.fFirstEvent;
+   fEvPtr = src.fEvPtr;
+   fBufType = src.fBufType;
+   fIndexing = src.fIndexing;
+   fIndexed = false;
+   fIndex.clear(); // memory is kept
+   fIndexNext = 0;
+   fIndexPos = -1;
+   fContEnd = nullptr;
+   fInfo = src.subevnt_info();
+
+   // pointer with buffer reference, covers rest of the container as in normal iteration
+   fSubPtr = src.subevnt_ptr();
+   if (fSubPtr.null()) {
+      fRawPtr.reset();
+   } else {
+      fRawPtr.reset(fSubPtr, 0, subevnt()->GetPaddedSize());
+      fRawPtr.shift(sizeof(hadaq::RawSubevent));
+   }
+}
+
 bool hadaq::ReadIterator::Reset(const dabc::Buffer& buf)
 {
    Close();
@@ -72,6 +168,9 @@ bool hadaq::ReadIterator::Reset(const dabc::Buffer& buf)
    fEvPtr = buf;
    fFirstEvent = true;
 
+   if (fIndexing)
+      fIndexed = IndexBuffer(buf, fIndex);
+
    return true;
 }
 
@@ -82,6 +181,11 @@ void hadaq::ReadIterator::Close()
    fRawPtr.reset();
    fFirstEvent = false;
    fBufType = dabc::mbt_Null;
+   fIndexed = false;
+   fIndex.clear(); // memory is kept for next buffer
+   fIndexNext = 0;
+   fIndexPos = -1;
+   fContEnd = nullptr;
 }
 
 
@@ -196,25 +300,70 @@ bool hadaq::ReadIterator::AssignEventPointer(dabc::Pointer& ptr)
 }
 
 
+bool hadaq::ReadIterator::GetContainerSize(dabc::BufferSize_t &headsize, dabc::BufferSize_t &containersize) const
+{
+   // this function is used both in hadtu and in event mode. Check out mode:
+   if (fBufType == mbt_HadaqEvents) {
+      headsize = sizeof(hadaq::RawEvent);
+      containersize = evnt()->GetPaddedSize();
+   } else if (fBufType == mbt_HadaqTransportUnit) {
+      headsize = sizeof(hadaq::HadTu);
+      containersize = hadtu()->GetPaddedSize();
+   } else if (fBufType == mbt_HadaqSubevents) {
+      headsize = 0;
+      containersize = fEvPtr.fullsize();
+   } else {
+      EOUT("NextSubEvent not allowed for buffer type %u. Check your code!", (unsigned) fBufType);
+      return false;
+   }
+
+   return true;
+}
+
+bool hadaq::ReadIterator::NextIndexedSubEvent()
+{
+   if (fSubPtr.null()) {
+      if (fEvPtr.null()) return false;
+
+      dabc::BufferSize_t headsize(0), containersize(0);
+      if (!GetContainerSize(headsize, containersize) || (containersize < headsize)) return false;
+
+      // skip entries of containers which were not iterated
+      const char *begin = (const char *) fEvPtr() + headsize;
+      while ((fIndexNext < fIndex.size()) && ((const char *) fIndex[fIndexNext].subevnt < begin))
+         fIndexNext++;
+
+      if (containersize > fEvPtr.fullsize()) containersize = fEvPtr.fullsize();
+      fContEnd = (const char *) fEvPtr() + containersize;
+   }
+
+   if ((fIndexNext >= fIndex.size()) || ((const char *) fIndex[fIndexNext].subevnt >= fContEnd)) {
+      fSubPtr.reset();
+      fRawPtr.reset();
+      fIndexPos = -1;
+      return false;
+   }
+
+   fIndexPos = fIndexNext++;
+
+   const SubeventInfo &info = fIndex[fIndexPos];
+
+   // pointers without buffer reference, subevnt_ptr() provides pointer with reference
+   // as in normal iteration, subevent pointer covers rest of the container
+   fSubPtr.reset(info.subevnt, fContEnd - (const char *) info.subevnt);
+   fRawPtr.reset((char *) info.subevnt + sizeof(hadaq::RawSubevent), info.GetPaddedSize() - sizeof(hadaq::RawSubevent));
+
+   return true;
+}
+
 bool hadaq::ReadIterator::NextSubEvent()
 {
+   if (fIndexed) return NextIndexedSubEvent();
+
    if (fSubPtr.null()) {
       if (fEvPtr.null()) return false;
-      // this function is used both in hadtu and in event mode. Check out mode:
       dabc::BufferSize_t headsize(0), containersize(0);
-      if (fBufType == mbt_HadaqEvents) {
-         headsize = sizeof(hadaq::RawEvent);
-         containersize = evnt()->GetPaddedSize();
-      } else if (fBufType == mbt_HadaqTransportUnit) {
-         headsize = sizeof(hadaq::HadTu);
-         containersize = hadtu()->GetPaddedSize();
-      } else if (fBufType == mbt_HadaqSubevents) {
-         headsize = 0;
-         containersize = fEvPtr.fullsize();
-      } else {
-         EOUT("NextSubEvent not allowed for buffer type %u. Check your code!", (unsigned) fBufType);
-         return false;
-      }
+      if (!GetContainerSize(headsize, containersize)) return false;
 
       if (containersize == 0) return false; // typical problem of artifical generated events
 
@@ -246,16 +395,89 @@ bool hadaq::ReadIterator::NextSubEvent()
    fRawPtr.reset(fSubPtr, 0, subevnt()->GetPaddedSize());
    fRawPtr.shift(sizeof(hadaq::RawSubevent));
 
+   if (fIndexing)
+      DecodeSubevent((const char *) subevnt(), fSubPtr.rawsize(), fInfo);
+
    return true;
 }
 
+dabc::Pointer hadaq::ReadIterator::subevnt_ptr() const
+{
+   if (fIndexPos < 0) return fSubPtr;
+
+   const SubeventInfo &info = fIndex[fIndexPos];
+
+   return dabc::Pointer(fEvPtr, (const char *) info.subevnt - (const char *) fEvPtr(), fSubPtr.fullsize());
+}
+
 unsigned hadaq::ReadIterator::rawdata_maxsize() const
 {
    unsigned sz0 = fEvPtr.rawsize(), sz1 = 0;
-   if (!fSubPtr.null()) sz1 = fEvPtr.distance_to(fSubPtr);
+   if (fIndexPos >= 0)
+      sz1 = (const char *) fSubPtr() - (const char *) fEvPtr();
+   else if (!fSubPtr.null())
+      sz1 = fEvPtr.distance_to(fSubPtr);
    return sz0>sz1 ? sz0-sz1 : 0;
 }
 
+bool hadaq::ReadIterator::IndexBuffer(const dabc::Buffer &buf, std::vector<SubeventInfo> &index)
+{
+   index.clear();
+
+   // index only possible for contiguous memory
+   if (buf.null() || (buf.NumSegments() != 1)) return false;
+
+   long headsize = 0;
+   bool single = false;
+
+   switch (buf.GetTypeId()) {
+      case mbt_HadaqEvents: headsize = sizeof(hadaq::RawEvent); break;
+      case mbt_HadaqTransportUnit: headsize = sizeof(hadaq::HadTu); break;
+      case mbt_HadaqSubevents: single = true; break;
+      default: return false;
+   }
+
+   const char *begin = (const char *) buf.SegmentPtr(0), *ptr = begin,
+              *end = ptr + buf.SegmentSize(0);
+
+   // same sequence of containers as produced by NextEvent() or NextHadTu(),
+   // any format problem means that iterator should analyze data itself
+   while (ptr < end) {
+      const char *contend = end;
+
+      if (!single) {
+         if (end - ptr < headsize) break;
+
+         const hadaq::HadTu *tu = (const hadaq::HadTu *) ptr;
+         if ((tu->GetSize() < headsize) || (tu->GetSize() > end - ptr)) {
+            index.clear();
+            return false;
+         }
+
+         if (tu->GetPaddedSize() < end - ptr)
+            contend = ptr + tu->GetPaddedSize();
+         ptr += headsize;
+      }
+
+      while (contend - ptr >= (long) sizeof(hadaq::RawSubevent)) {
+         index.emplace_back();
+         SubeventInfo &info = index.back();
+         DecodeSubevent(ptr, contend - ptr, info);
+         info.offset = ptr - begin;
+         if ((info.size < sizeof(hadaq::RawSubevent)) || (info.GetPaddedSize() > contend - ptr)) {
+            index.clear();
+            return false;
+         }
+         ptr += info.GetPaddedSize();
+      }
+
+      if (single) break;
+      ptr = contend;
+   }
+
+   return true;
+}
+
 unsigned hadaq::ReadIterator::NumEvents(const dabc::Buffer& buf)
 {
    ReadIterator iter(buf);
@@ -270,7 +492,12 @@ hadaq::WriteIterator::WriteIterator() :
    fBuffer(),
    fEvPtr(),
    fSubPtr(),
-   fFullSize(0)
+   fFullSize(0),
+   fHdrBuf(),
+   fMaxSubevents(0),
+   fEvSize(0),
+   fRefBytes(0),
+   fCopyBytes(0)
 {
 }
 
@@ -278,7 +505,12 @@ hadaq::WriteIterator::WriteIterator(const dabc::Buffer& buf) :
    fBuffer(),
    fEvPtr(),
    fSubPtr(),
-   fFullSize(0)
+   fFullSize(0),
+   fHdrBuf(),
+   fMaxSubevents(0),
+   fEvSize(0),
+   fRefBytes(0),
+   fCopyBytes(0)
 {
    Reset(buf);
 }
@@ -291,6 +523,7 @@ hadaq::WriteIterator::~WriteIterator()
 bool hadaq::WriteIterator::Reset(const dabc::Buffer& buf)
 {
    fBuffer.Release();
+   fHdrBuf.Release();
    fEvPtr.reset();
    fSubPtr.reset();
    fFullSize = 0;
@@ -306,11 +539,28 @@ bool hadaq::WriteIterator::Reset(const dabc::Buffer& buf)
    return true;
 }
 
+bool hadaq::WriteIterator::ResetZeroCopy(const dabc::Buffer& hdrbuf, unsigned maxsegments, unsigned maxsubevents)
+{
+   if (!Reset(hdrbuf)) return false;
+
+   // headers buffer is kept separately, output gets only segments list
+   fHdrBuf << fBuffer;
+   fBuffer.MakeEmpty(maxsegments);
+   fBuffer.SetTypeId(mbt_HadaqEvents);
+   fMaxSubevents = maxsubevents;
+
+   fEvPtr = fHdrBuf;
+
+   return true;
+}
+
 dabc::Buffer hadaq::WriteIterator::Close()
 {
    fEvPtr.reset();
    fSubPtr.reset();
-   if ((fFullSize>0) && (fBuffer.GetTotalSize() >= fFullSize))
+   if (!fHdrBuf.null())
+      fHdrBuf.Release(); // data remain referenced by the segments
+   else if ((fFullSize>0) && (fBuffer.GetTotalSize() >= fFullSize))
       fBuffer.SetTotalSize(fFullSize);
    fFullSize = 0;
 
@@ -321,6 +571,13 @@ dabc::Buffer hadaq::WriteIterator::Close()
 
 bool hadaq::WriteIterator::IsPlaceForEvent(uint32_t subeventssize)
 {
+   if (IsZeroCopy()) {
+      // header and possible padding should fit into list of segments,
+      // also complete event size is limited by headers buffer - then any subevent can be copied
+      if (fBuffer.NumSegments() + fMaxSubevents + 2 > fBuffer.SegmentsCapacity()) return false;
+      return fFullSize + sizeof(hadaq::RawEvent) + subeventssize + 8 <= fHdrBuf.GetTotalSize();
+   }
+
    dabc::BufferSize_t availible = 0;
 
    if (!fEvPtr.null()) availible = fEvPtr.fullsize();
@@ -336,6 +593,19 @@ bool  hadaq::WriteIterator::NewEvent(uint32_t evtSeqNr, uint32_t runNr, uint32_t
    // TODO: add arguments to set other event header fields
    if (fBuffer.null()) return false;
 
+   if (IsZeroCopy()) {
+      if (fEvPtr.fullsize() < sizeof(hadaq::RawEvent) + 8) return false;
+
+      evnt()->Init(evtSeqNr, runNr);
+
+      // header referenced at once to preserve order of segments
+      if (!fBuffer.AppendRef(fEvPtr, sizeof(hadaq::RawEvent))) return false;
+
+      fSubPtr.reset(fEvPtr, sizeof(hadaq::RawEvent));
+      fEvSize = sizeof(hadaq::RawEvent);
+      return true;
+   }
+
    if (fEvPtr.null())  fEvPtr = fBuffer;
 
    fSubPtr.reset();
@@ -352,7 +622,8 @@ bool  hadaq::WriteIterator::NewEvent(uint32_t evtSeqNr, uint32_t runNr, uint32_t
 
 bool hadaq::WriteIterator::NewSubevent(uint32_t minrawsize, uint32_t trigger)
 {
-   if (fEvPtr.null()) return false;
+   // subevents cannot be filled in zero-copy mode
+   if (fEvPtr.null() || IsZeroCopy()) return false;
 
    if (fSubPtr.null())
       fSubPtr.reset(fEvPtr, sizeof(hadaq::RawEvent));
@@ -366,7 +637,7 @@ bool hadaq::WriteIterator::NewSubevent(uint32_t minrawsize, uint32_t trigger)
 
 bool hadaq::WriteIterator::FinishSubEvent(uint32_t rawdatasz)
 {
-   if (fSubPtr.null()) return false;
+   if (fSubPtr.null() || IsZeroCopy()) return false;
 
    if (rawdatasz > maxrawdatasize()) return false;
 
@@ -377,8 +648,62 @@ bool hadaq::WriteIterator::FinishSubEvent(uint32_t rawdatasz)
    return true;
 }
 
+bool hadaq::WriteIterator::AddZeroCopyData(const dabc::Pointer* source, const void* ptr, unsigned len, bool ref)
+{
+   if (fSubPtr.null()) return false;
+
+   if (ref && source && fBuffer.AppendRef(*source, len)) {
+      fRefBytes += len;
+   } else {
+      // data copied after the header, reference merged with header segment
+      if (fSubPtr.fullsize() < len) return false;
+      if (source)
+         fSubPtr.copyfrom(*source, len);
+      else
+         fSubPtr.copyfrom(ptr, len);
+      if (!fBuffer.AppendRef(fSubPtr, len)) return false;
+      fSubPtr.shift(len);
+      fCopyBytes += len;
+   }
+
+   fEvSize += len;
+   return true;
+}
+
+bool hadaq::WriteIterator::AddSubeventRef(const dabc::Pointer& source, unsigned len)
+{
+   if (IsZeroCopy()) return AddZeroCopyData(&source, nullptr, len, true);
+
+   if (fEvPtr.null()) return false;
+
+   if (fSubPtr.null())
+      fSubPtr.reset(fEvPtr, sizeof(hadaq::RawEvent));
+
+   if (fSubPtr.fullsize() < len) return false;
+
+   fSubPtr.copyfrom(source, len);
+
+   fSubPtr.shift(len);
+
+   return true;
+}
+
+bool hadaq::WriteIterator::AddEventRef(const dabc::Pointer& source, unsigned len)
+{
+   // only between events, consecutive events from same buffer merged into single segment
+   if (!IsZeroCopy() || !fSubPtr.null()) return false;
+
+   if (!fBuffer.AppendRef(source, len)) return false;
+
+   fFullSize += len;
+   fRefBytes += len;
+   return true;
+}
+
 bool hadaq::WriteIterator::AddSubevent(const dabc::Pointer& source)
 {
+   if (IsZeroCopy()) return AddZeroCopyData(&source, nullptr, source.fullsize(), false);
+
    if (fEvPtr.null()) return false;
 
    if (fSubPtr.null())
@@ -395,6 +720,8 @@ bool hadaq::WriteIterator::AddSubevent(const dabc::Pointer& source)
 
 bool hadaq::WriteIterator::AddSubevent(const void *ptr, unsigned len)
 {
+   if (IsZeroCopy()) return AddZeroCopyData(nullptr, ptr, len, false);
+
    if (fEvPtr.null()) return false;
 
    if (fSubPtr.null())
@@ -414,6 +741,22 @@ bool hadaq::WriteIterator::FinishEvent()
 {
    if (fEvPtr.null()) return false;
 
+   if (IsZeroCopy()) {
+      if (fSubPtr.null()) return false;
+      evnt()->SetSize(fEvSize);
+      dabc::BufferSize_t pad = evnt()->GetPaddedSize() - fEvSize;
+      if (pad > 0) {
+         memset(fSubPtr(), 0, pad);
+         fBuffer.AppendRef(fSubPtr, pad);
+         fSubPtr.shift(pad);
+      }
+      fFullSize += fEvSize + pad;
+      // next header placed after data, copied into headers buffer
+      fEvPtr = fSubPtr;
+      fSubPtr.reset();
+      return true;
+   }
+
    dabc::BufferSize_t dist = sizeof(hadaq::RawEvent);
    if (!fSubPtr.null()) dist = fEvPtr.distance_to(fSubPtr);
    evnt()->SetSize(dist);
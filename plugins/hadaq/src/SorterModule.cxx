@@ -27,9 +27,13 @@ hadaq::SorterModule::SorterModule(const std::string &name, dabc::Command cmd) :
    fLastRet(0),
    fNextBufIndx(0),
    fReadyBufIndx(0),
+   fFirstBufId(0),
    fSubs(),
+   fBufSubs(),
+   fScan(),
    fOutBuf(),
-   fOutPtr()
+   fOutPtr(),
+   fIter()
 {
    // we need at least one input and one output port
    EnsurePorts(1, 1, dabc::xmlWorkPool);
@@ -42,74 +46,55 @@ hadaq::SorterModule::SorterModule(const std::string &name, dabc::Command cmd) :
    fTriggersRange = Cfg(hadaq::xmlHadaqTrignumRange, cmd).AsUInt(0x1000000);
    fLastTrigger = 0xffffffff;
 
+   // size of the ring used for sorting, should be larger than expected disorder of triggers
+   unsigned window = Cfg("SortWindow", cmd).AsUInt(1024);
+   if (window > fTriggersRange/2) window = fTriggersRange/2;
+
+   fSubs.SetRange(fTriggersRange);
+   fSubs.SetWindow(window);
+
+   // all subevents headers of the buffer decoded at once
+   fIter.SetIndexing();
+
    fSubs.reserve(1024);
+   fScan.reserve(1024);
 }
 
 void hadaq::SorterModule::DecremntInputIndex(unsigned cnt)
 {
    // remove *cnt* buffers from the input queue
-   // all references should be removed
+   // buffers should not have any subevents in the queue
 
    if (fNextBufIndx>cnt) fNextBufIndx-=cnt; else fNextBufIndx = 0;
    if (fReadyBufIndx>cnt) fReadyBufIndx-=cnt; else fReadyBufIndx = 0;
 
-   unsigned tgt(0);
+   fBufSubs.erase(fBufSubs.begin(), fBufSubs.begin() + std::min(cnt, (unsigned) fBufSubs.size()));
 
-   for (unsigned n=0;n<fSubs.size();n++) {
-      if (fSubs[n].buf<cnt) continue;
-      fSubs[n].buf-=cnt;
-      if (n!=tgt) fSubs[tgt] = fSubs[n];
-      tgt++;
-   }
-
-   fSubs.resize(tgt);
+   fFirstBufId += cnt;
 }
 
-bool hadaq::SorterModule::RemoveUsedSubevents(unsigned num)
+bool hadaq::SorterModule::RemoveUsedSubevents()
 {
-   // remove used entries from subs list
-   // return true if any buffer from inp
-
-   if (num==0) return false;
+   // skip scanned input buffers, which subevents are all used
+   // return true if any buffer was removed from input queue
 
-   if (num >= fSubs.size()) {
-      // this is full clear of indexed data
-      unsigned maxbuf(0);
-      for (unsigned n=0;n<fSubs.size();n++)
-         if (fSubs[n].buf>maxbuf) maxbuf = fSubs[n].buf;
-
-      fSubs.clear();
-
-      DecremntInputIndex(maxbuf+1);
-
-      SkipInputBuffers(0, maxbuf+1);
-
-      return true;
-   }
+   if (fReadyBufIndx > 0) return false;
 
-   unsigned minbuf(0xffffffff);
+   unsigned cnt = 0;
+   while ((cnt < fNextBufIndx) && (fBufSubs[cnt] == 0)) cnt++;
 
-   // first check indexes of buffer which are removed
-   for (unsigned n=num;n<fSubs.size();n++) {
-      if (fSubs[n].buf<minbuf) minbuf = fSubs[n].buf;
-      fSubs[n-num] = fSubs[n];
-   }
-   fSubs.resize(fSubs.size() - num);
+   if (cnt == 0) return false;
 
-   if (minbuf>0) {
-      // we skip at least one buffer
-      DecremntInputIndex(minbuf);
-      SkipInputBuffers(0, minbuf);
-      return true; // indicate that buffers were removed
-   }
+   DecremntInputIndex(cnt);
+   SkipInputBuffers(0, cnt);
 
-   return false; // no buffers removed
+   return true;
 }
 
 
 bool hadaq::SorterModule::retransmit()
 {
-   bool new_data = false, full_recv_queue = RecvQueueFull(), flush_data = false;
+   bool full_recv_queue = RecvQueueFull(), flush_data = false;
 
    while (fNextBufIndx < NumCanRecv()) {
 
@@ -134,53 +119,57 @@ bool hadaq::SorterModule::retransmit()
          break;
       }
 
-      hadaq::ReadIterator iter(buf);
+      fIter.Reset(buf);
       fBufCnt++;
-      bool was_empty = fSubs.size() == 0;
+      fScan.clear();
 
       // scan buffer
-      while (iter.NextSubeventsBlock())
-         while (iter.NextSubEvent()) {
+      while (fIter.NextSubeventsBlock())
+         while (fIter.NextSubEvent()) {
+            const hadaq::SubeventInfo &info = fIter.subevnt_info();
             SubsRec rec;
-            rec.subevnt = iter.subevnt();
-            rec.buf = fNextBufIndx;
-            rec.trig = (iter.subevnt()->GetTrigNr() >> 8) & (fTriggersRange-1);
-            rec.sz = iter.subevnt()->GetPaddedSize();
+            rec.subevnt = info.subevnt;
+            rec.buf = fFirstBufId + fNextBufIndx;
+            rec.trig = (info.trignr >> 8) & (fTriggersRange-1);
+            rec.sz = info.GetPaddedSize();
 
             // DOUT1("Event 0x%06x size %3u", rec.trig, rec.sz);
 
-            fSubs.push_back(rec);
-            new_data = true;
+            fScan.push_back(rec);
          }
 
+      fIter.Close();
+
       // check if buffer can be used as is
       // all ids are in the order and corresponds to previous values
-      if ((fReadyBufIndx == fNextBufIndx) && was_empty) {
+      bool ok = (fReadyBufIndx == fNextBufIndx) && fSubs.empty();
+      if (ok) {
          uint32_t prev = fLastTrigger;
-         bool ok(true);
-         for (unsigned n=0;n<fSubs.size();n++) {
+         for (unsigned n=0;n<fScan.size();n++) {
             if (prev!=0xffffffff) {
-               ok = Diff(prev, fSubs[n].trig)==1;
+               ok = Diff(prev, fScan[n].trig)==1;
                if (!ok) break;
             }
-            prev = fSubs[n].trig;
+            prev = fScan[n].trig;
          }
 
          if (ok) {
             fLastTrigger = prev;
             fReadyBufIndx++;
-            fSubs.clear(); // no need to keep array
-            new_data = false;
+            if (prev != 0xffffffff) fSubs.SetNext((prev + 1) & (fTriggersRange-1));
          }
       }
 
+      // otherwise subevents are placed into the queue
+      if (!ok)
+         for (unsigned n=0;n<fScan.size();n++)
+            fSubs.push(fScan[n]);
+
+      fBufSubs.push_back(ok ? 0 : fScan.size());
+
       fNextBufIndx++;
    }
 
-   // sort current array
-   if (new_data)
-      std::sort(fSubs.begin(), fSubs.end(), SubsComp(this));
-
    // simple case - retransmit buffer from input to output
    if ((fReadyBufIndx>0) && CanSend() && CanRecv()) {
       dabc::Buffer buf = Recv();
@@ -202,38 +191,40 @@ bool hadaq::SorterModule::retransmit()
    }
 
    // one could allow gaps in the trigger IDs if more than 2 items in the input queue
-   unsigned cnt = 0;
-   while (cnt < fSubs.size()) {
+   while (!fSubs.empty()) {
+      const SubsRec &rec = fSubs.top();
+
       int diff = 1;
       if (fLastTrigger!=0xffffffff)
-         diff = Diff(fLastTrigger, fSubs[cnt].trig);
+         diff = Diff(fLastTrigger, rec.trig);
 
       if (diff!=1) {
 
          if (diff<0) {
             EOUT("Buf:%3d problem in sorting - older events appeared. Most probably, flush time has wrong value", fBufCnt);
-            cnt++; // skip subevent
+            UseSubevent(rec); // skip subevent
             continue;
          }
 
          // if buffer for such subevents in two last buffers, wait for next data
          // if EOF buffer was seen before, flush subevents immediately
-         if ((fSubs[cnt].buf + 2 > fNextBufIndx) && !full_recv_queue && !flush_data) break;
+         if ((rec.buf - fFirstBufId + 2 > fNextBufIndx) && !full_recv_queue && !flush_data) break;
 
-         DOUT3("Buf:%3d  Saw difference %d with trigger 0x%06x cnt:%u", fBufCnt, diff, fSubs[cnt].trig, fOutPtr.distance_to_ownbuf());
+         DOUT3("Buf:%3d  Saw difference %d with trigger 0x%06x cnt:%u", fBufCnt, diff, rec.trig, fOutPtr.distance_to_ownbuf());
 
-         DOUT3("Allow gap full:%s numcanrecv:%u indx:%u nextbufind:%u", DBOOL(full_recv_queue), NumCanRecv(), fSubs[cnt].buf, fNextBufIndx);
+         DOUT3("Allow gap full:%s numcanrecv:%u indx:%u nextbufind:%u", DBOOL(full_recv_queue), NumCanRecv(), rec.buf - fFirstBufId, fNextBufIndx);
 
          // even after the gap, event taken into output buffer
       }
 
       // check if output buffer has enough space
-      if (fOutPtr.fullsize() < fSubs[cnt].sz) { flush_data = true; break; }
+      if (fOutPtr.fullsize() < rec.sz) { flush_data = true; break; }
 
-      memcpy(fOutPtr(), fSubs[cnt].subevnt,  fSubs[cnt].sz);
-      fOutPtr.shift(fSubs[cnt].sz);
+      memcpy(fOutPtr(), rec.subevnt, rec.sz);
+      fOutPtr.shift(rec.sz);
 
-      fLastTrigger = fSubs[cnt++].trig;
+      fLastTrigger = rec.trig;
+      UseSubevent(rec);
    }
 
    if (full_recv_queue) flush_data = true;
@@ -246,7 +237,7 @@ bool hadaq::SorterModule::retransmit()
    }
 
    // if buffers were removed from input queue, call retransmit again
-   if (RemoveUsedSubevents(cnt)) flush_data = true;
+   if (RemoveUsedSubevents()) flush_data = true;
 
    fLastRet = flush_data ? 60 : 70;
 
@@ -260,6 +251,10 @@ void hadaq::SorterModule::ProcessTimerEvent(unsigned)
    // if after 3 timer events no data was send, any data filled into output buffer will be send
    // if nothing happened after 6 timer events, any indexed data will be placed into output buffer and send
 
+   // input produces no new events while scanned buffers are kept in the queue
+   // therefore check here if new buffers arrived
+   if (NumCanRecv() > fNextBufIndx) ActivateInput();
+
    if (!CanSend()) return; // first of all, check if we can send data
 
    if (--fFlushCnt > 2) return;
@@ -143,6 +143,7 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
          unsigned nlines = comb->fCfg.size() + 4;
          if (fServPort>=0) nlines++;
          if (fFilePort>=0) nlines++;
+         if (comb->fWorkers.size() > 0) nlines += comb->fWorkers.size() + 1;
          for (unsigned n=0;n<nlines;n++)
             fputs("\033[A\033[2K",stdout);
          rewind(stdout);
@@ -154,6 +155,7 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
                         "  err32 - 32-byte header does not match with 32-bytes footer\n"
                         "  errbits - error bits not 0 and not 1\n"
                         "  bufs  - number of produced buffers\n"
+                        "  batch - average number of packets per recvmmsg call (when batch mode enabled)\n"
                         "  qu    - input queue of combiner module\n"
                         "  drop  - dropped subevents (received by combiner but not useful)\n"
                         "  lost  - lost subevents (never seen by combiner)\n"
@@ -230,7 +232,7 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
         }
       }
 
-   s += "inp port     pkt      data    MB/s   disc  err32   bufs  qu errbits drop  lost";
+   s += "inp port     pkt      data    MB/s   disc  err32   bufs batch  qu errbits drop  lost";
    if (istdccal) s += "    TRB         TDC               progr   state";
    if (fRingSize>0) s += "   triggers";
    s += "\n";
@@ -247,7 +249,7 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
    ditem.SetField("LostEventsRate", rate3);
    ditem.SetField("LostDataRate", rate4);
 
-   std::vector<int64_t> ports, recvbytes, inperrbits, inpdrop, inplost;
+   std::vector<int64_t> ports, recvbytes, inperrbits, inpdrop, inplost, inpbatches, inpbatchpkts, inpbatchmax;
    std::vector<double> inprates;
 
    for (unsigned n=0;n<comb->fCfg.size();n++) {
@@ -259,25 +261,29 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
       hadaq::TransportInfo *info = (hadaq::TransportInfo *) cfg.fInfo;
 
       if (info==0) {
-         sbuf.append("  missing transport-info                             ");
+         sbuf.append("  missing transport-info                                   ");
          fCalibr[n].lastrecv = 0;
       } else {
 
          double rate = (info->fTotalRecvBytes > fCalibr[n].lastrecv) ? (info->fTotalRecvBytes - fCalibr[n].lastrecv) * delta : 0.;
 
-         sbuf.append(dabc::format(" %5d %7s %9s %7.3f %6s %6s %6s",
+         sbuf.append(dabc::format(" %5d %7s %9s %7.3f %6s %6s %6s %5s",
                info->fNPort,
                dabc::number_to_str(info->fTotalRecvPacket,1).c_str(),
                dabc::size_to_str(info->fTotalRecvBytes).c_str(),
                rate/1024./1024.,
                info->GetDiscardString().c_str(),
                info->GetDiscard32String().c_str(),
-               dabc::number_to_str(info->fTotalProducedBuffers).c_str()));
+               dabc::number_to_str(info->fTotalProducedBuffers).c_str(),
+               info->GetBatchString().c_str()));
          fCalibr[n].lastrecv = info->fTotalRecvBytes;
 
          ports.push_back(info->fNPort);
          recvbytes.push_back(info->fTotalRecvBytes);
          inprates.push_back(rate);
+         inpbatches.push_back(info->fTotalBatches);
+         inpbatchpkts.push_back(info->fTotalBatchPackets);
+         inpbatchmax.push_back(info->fMaxBatchPackets);
       }
 
       sbuf.append(dabc::format(" %3d %6s %5s %5s",
@@ -315,6 +321,27 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
       s += "\n";
    }
 
+   if (comb->fWorkers.size() != fWorkersEvents.size())
+      fWorkersEvents.assign(comb->fWorkers.size(), 0);
+
+   if (comb->fWorkers.size() > 0)
+      s += "wrk    events         rate      data   disc  merged  qu\n";
+
+   for (unsigned nw = 0; nw < comb->fWorkers.size(); nw++) {
+      hadaq::CombinerModule::WorkerCfg &wrk = comb->fWorkers[nw];
+
+      double rate = (wrk.fBuildEvents > fWorkersEvents[nw]) ? (wrk.fBuildEvents - fWorkersEvents[nw]) * delta : 0.;
+      fWorkersEvents[nw] = wrk.fBuildEvents;
+
+      s += dabc::format("%2u %9s %12s %9s %6s %7s %3d\n", nw,
+                        dabc::number_to_str(wrk.fBuildEvents, 1).c_str(),
+                        rate_to_str(rate).c_str(),
+                        dabc::size_to_str(wrk.fBuildData).c_str(),
+                        dabc::number_to_str(wrk.fDiscEvents, 0).c_str(),
+                        dabc::number_to_str(wrk.fMergedEvents, 1).c_str(),
+                        wrk.fInpQueue);
+   }
+
    if (fDoShow)
       fprintf(stdout, "%s", s.c_str());
 
@@ -326,6 +353,9 @@ void hadaq::TerminalModule::ProcessTimerEvent(unsigned timer)
    ditem.SetField("inperrbits", inperrbits);
    ditem.SetField("inpdrop", inpdrop);
    ditem.SetField("inplost", inplost);
+   ditem.SetField("inpbatches", inpbatches);
+   ditem.SetField("inpbatchpkts", inpbatchpkts);
+   ditem.SetField("inpbatchmax", inpbatchmax);
 
    if (!fFileReqRunning && (fFilePort>=0)) {
       dabc::Command cmd("GetTransportStatistic");
@@ -32,7 +32,7 @@
 // according to specification maximal UDP packet is 65,507 or 0xFFE3
 #define DEFAULT_MTU 0xFFF0
 
-hadaq::NewAddon::NewAddon(int fd, int nport, int mtu, bool debug, int maxloop, double reduce, double lost) :
+hadaq::NewAddon::NewAddon(int fd, int nport, int mtu, bool debug, int maxloop, double reduce, double lost, int batch, double batchtm) :
    dabc::SocketAddon(fd),
    TransportInfo(nport),
    fTgtPtr(),
@@ -46,14 +46,32 @@ hadaq::NewAddon::NewAddon(int fd, int nport, int mtu, bool debug, int maxloop, d
    fLostCnt(lost>0 ? 1 : -1),
    fDebug(debug),
    fRunning(false),
-   fMaxProcDist(0.)
+   fMaxProcDist(0.),
+   fBatchSize(batch > 1 ? batch : 0),
+   fBatchTmout(batchtm),
+   fBatchMsgs(nullptr),
+   fBatchIOV(nullptr)
 {
    fMtuBuffer = std::malloc(fMTU);
+
+#if defined(__linux__)
+   if (fBatchSize > 0) {
+      fBatchMsgs = (struct mmsghdr *) std::calloc(fBatchSize, sizeof(struct mmsghdr));
+      fBatchIOV = (struct iovec *) std::calloc(fBatchSize, sizeof(struct iovec));
+   }
+#else
+   if (fBatchSize > 0) {
+      EOUT("UDP:%d recvmmsg not supported on this platform, batch mode disabled", fNPort);
+      fBatchSize = 0;
+   }
+#endif
 }
 
 hadaq::NewAddon::~NewAddon()
 {
    std::free(fMtuBuffer);
+   std::free(fBatchMsgs);
+   std::free(fBatchIOV);
 }
 
 void hadaq::NewAddon::ProcessEvent(const dabc::EventId& evnt)
@@ -132,6 +150,8 @@ bool hadaq::NewAddon::ReadUdp()
          return false;
       }
       fSkipCnt = 0;
+
+      if (fBatchSize > 0) return ReadUdpBatch(tr);
    }
 
    int cnt = fMaxLoopCnt;
@@ -154,7 +174,7 @@ bool hadaq::NewAddon::ReadUdp()
       if (res < 0) {
          // socket do not have data, one should enable event processing
          // otherwise we need to poll for the new data
-         if (errno == EAGAIN) break;
+         if (errno == EAGAIN) { SocketWouldBlock(true); break; }
          EOUT("Socket error");
          return false;
       }
@@ -168,38 +188,9 @@ bool hadaq::NewAddon::ReadUdp()
       }
 
       hadaq::HadTu* hadTu = (hadaq::HadTu*) tgt;
-      int msgsize = hadTu->GetPaddedSize() + 32; // trb sender adds a 32 byte control trailer identical to event header
 
-      std::string errmsg;
-
-      if (res != msgsize) {
-         errmsg = dabc::format("Send buffer %ld differ from message size %d - ignore it", (long) res, msgsize);
-      } else
-      if (memcmp((char*) hadTu + hadTu->GetPaddedSize(), (char*) hadTu, 32) != 0) {
-         fTotalDiscard32Packet++;
-         errmsg = "Trailing 32 bytes do not match to header - ignore packet";
-      }
-
-      if (!errmsg.empty()) {
-         DOUT3("UDP:%d %s", fNPort, errmsg.c_str());
-         if (fDebug && (dabc::lgr()->GetDebugLevel()>2)) {
-            errmsg = dabc::format("   Packet length %ld", (long) res);
-            uint32_t* ptr = (uint32_t*) hadTu;
-            for (unsigned n=0;n<res/4;n++) {
-               if (n%8 == 0) {
-                  printf("   %s\n", errmsg.c_str());
-                  errmsg = dabc::format("0x%04x:", n*4);
-               }
-
-               errmsg.append(dabc::format(" 0x%08x", (unsigned) ptr[n]));
-            }
-            printf("   %s\n",errmsg.c_str());
-         }
-
-         fTotalDiscardPacket++;
-         fTotalDiscardBytes+=res;
-         continue;
-      }
+      unsigned padded_size = CheckPacket(hadTu, res);
+      if (padded_size == 0) continue;
 
       if (tgt == fMtuBuffer) {
          // skip single MTU
@@ -211,7 +202,7 @@ bool hadaq::NewAddon::ReadUdp()
       fTotalRecvPacket++;
       fTotalRecvBytes += res;
 
-      fTgtPtr.shift(hadTu->GetPaddedSize());
+      fTgtPtr.shift(padded_size);
 
       // when rest size is smaller that mtu, one should close buffer
       if ((fTgtPtr.rawsize() < fMTU) || (fTgtPtr.consumed_size() > fReduce)) {
@@ -224,6 +215,132 @@ bool hadaq::NewAddon::ReadUdp()
    return true; // indicate that buffer reading will be finished by callback
 }
 
+unsigned hadaq::NewAddon::CheckPacket(hadaq::HadTu* hadTu, ssize_t res)
+{
+   int msgsize = hadTu->GetPaddedSize() + 32; // trb sender adds a 32 byte control trailer identical to event header
+
+   std::string errmsg;
+
+   if (res != msgsize) {
+      errmsg = dabc::format("Send buffer %ld differ from message size %d - ignore it", (long) res, msgsize);
+   } else
+   if (memcmp((char*) hadTu + hadTu->GetPaddedSize(), (char*) hadTu, 32) != 0) {
+      fTotalDiscard32Packet++;
+      errmsg = "Trailing 32 bytes do not match to header - ignore packet";
+   }
+
+   if (errmsg.empty()) return hadTu->GetPaddedSize();
+
+   DOUT3("UDP:%d %s", fNPort, errmsg.c_str());
+   if (fDebug && (dabc::lgr()->GetDebugLevel()>2)) {
+      errmsg = dabc::format("   Packet length %ld", (long) res);
+      uint32_t* ptr = (uint32_t*) hadTu;
+      for (unsigned n=0;n<res/4;n++) {
+         if (n%8 == 0) {
+            printf("   %s\n", errmsg.c_str());
+            errmsg = dabc::format("0x%04x:", n*4);
+         }
+
+         errmsg.append(dabc::format(" 0x%08x", (unsigned) ptr[n]));
+      }
+      printf("   %s\n",errmsg.c_str());
+   }
+
+   fTotalDiscardPacket++;
+   fTotalDiscardBytes+=res;
+   return 0;
+}
+
+bool hadaq::NewAddon::ReadUdpBatch(hadaq::NewTransport* tr)
+{
+#if defined(__linux__)
+   int cnt = fMaxLoopCnt;
+
+   dabc::TimeStamp start;
+   if (fBatchTmout > 0) start.GetNow();
+
+   while (cnt > 0) {
+
+      // packets are scattered into MTU-sized slots of the current buffer
+      unsigned nslots = fTgtPtr.rawsize() / fMTU;
+      if (nslots > fBatchSize) nslots = fBatchSize;
+      if (nslots > (unsigned) cnt) nslots = cnt;
+
+      char *slots = (char *) fTgtPtr.ptr();
+
+      for (unsigned n = 0; n < nslots; n++) {
+         fBatchIOV[n].iov_base = slots + n*fMTU;
+         fBatchIOV[n].iov_len = fMTU;
+         memset(&fBatchMsgs[n].msg_hdr, 0, sizeof(fBatchMsgs[n].msg_hdr));
+         fBatchMsgs[n].msg_hdr.msg_iov = &fBatchIOV[n];
+         fBatchMsgs[n].msg_hdr.msg_iovlen = 1;
+         fBatchMsgs[n].msg_len = 0;
+      }
+
+      int res = recvmmsg(Socket(), fBatchMsgs, nslots, MSG_DONTWAIT, nullptr);
+
+      if (res < 0) {
+         // socket do not have data, one should enable event processing
+         if (errno == EAGAIN) { SocketWouldBlock(true); break; }
+         EOUT("Socket error");
+         return false;
+      }
+
+      if (res == 0) break;
+
+      fTotalBatches++;
+      fTotalBatchPackets += res;
+      if ((unsigned) res > fMaxBatchPackets) fMaxBatchPackets = res;
+
+      cnt -= res;
+
+      // validate packets and compact them in place, only padded HadTu are kept
+      char *tgt = slots;
+
+      for (int n = 0; n < res; n++) {
+         char *src = slots + n*fMTU;
+         ssize_t len = fBatchMsgs[n].msg_len;
+
+         if ((fLostCnt > 0) && (--fLostCnt == 0)) {
+            // artificial drop of received UDP packet
+            fLostCnt = (int) (1 / fLostRate * (0.5 + 1.* rand() / RAND_MAX));
+            if (fLostCnt < 3) fLostCnt = 3;
+            fTotalArtificialLosts++;
+            continue;
+         }
+
+         unsigned padded_size = CheckPacket((hadaq::HadTu*) src, len);
+         if (padded_size == 0) continue;
+
+         if (tgt != src) memmove(tgt, src, padded_size);
+         tgt += padded_size;
+
+         fTotalRecvPacket++;
+         fTotalRecvBytes += len;
+      }
+
+      fTgtPtr.shift(tgt - slots);
+
+      // when rest size is smaller that mtu, one should close buffer
+      if ((fTgtPtr.rawsize() < fMTU) || (fTgtPtr.consumed_size() > fReduce)) {
+         CloseBuffer();
+         tr->BufferReady();
+         if (!tr->AssignNewBuffer(0,this)) return false;
+      }
+
+      // less packets than requested - socket is empty
+      if ((unsigned) res < nslots) break;
+
+      if ((fBatchTmout > 0) && start.Expired(fBatchTmout)) break;
+   }
+
+   return true;
+#else
+   (void) tr;
+   return false;
+#endif
+}
+
 int hadaq::NewAddon::OpenUdp(const std::string &host, int nport, int rcvbuflen)
 {
    int fd = socket(PF_INET, SOCK_DGRAM, 0);
@@ -166,6 +166,19 @@ namespace mbs {
          }
 
 
+         bool WriteBuffers(const void* const* ptrs, const size_t* sizes, unsigned num)
+         {
+            if (!isWriting() || (ptrs==0) || (sizes==0)) return false;
+
+            if (!io->fwritev(ptrs, sizes, num, fd)) {
+               fprintf(stderr, "fail to write %u buffers to lmd file\n", num);
+               Close();
+               return false;
+            }
+
+            return true;
+         }
+
          /** Reads buffer with several MBS events */
          bool ReadBuffer(void* ptr, uint64_t* sz, bool onlyevent = false)
          {
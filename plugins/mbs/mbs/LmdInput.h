@@ -24,17 +24,31 @@
 #include "mbs/LmdFile.h"
 #endif
 
+#ifndef DABC_MappedFile
+#include "dabc/MappedFile.h"
+#endif
+
 namespace mbs {
 
-   /** \brief Input for LMD files (lmd:) */
+   /** \brief Input for LMD files (lmd:)
+    *
+    * With url option mmap=<MB> file is memory-mapped in windows of specified size
+    * and produced buffers point directly into the mapped memory */
 
    class LmdInput : public dabc::FileInput {
        protected:
 
           mbs::LmdFile      fFile;
 
+          dabc::MappedFile  fMapped;      ///< memory-mapped file, used when fMapWindow>0
+          uint64_t          fMapWindow;   ///< size of mapped window
+
           bool CloseFile();
 
+          bool isReading() const { return fMapWindow ? fMapped.isOpened() : fFile.isReading(); }
+
+          unsigned ReadMapped(dabc::Buffer& buf);
+
           bool OpenNextFile();
 
           virtual std::string GetListFileExtension() { return ".lml"; }
@@ -28,6 +28,10 @@
 #include "dabc/DataIO.h"
 #endif
 
+#ifndef DABC_BuffersQueue
+#include "dabc/BuffersQueue.h"
+#endif
+
 #ifndef DABC_eventsapi
 #include "dabc/eventsapi.h"
 #endif
@@ -101,11 +105,33 @@ namespace mbs {
 
    // ===============================================================================
 
-   /** \brief Server transport for different kinds of MBS server */
+   /** \brief Server transport for different kinds of MBS server
+    *
+    * Received buffers are kept in the ring, shared by all clients.
+    * Every client has own read cursor in the ring, buffer released when all clients get it.
+    * When client lags behind producer more than specified limit, policy is applied:
+    * drop oldest buffers for the client, skip all pending buffers or close connection.
+    * With deliverall option producer waits for the slowest client. */
 
    class ServerTransport : public dabc::Transport {
       protected:
 
+         /** \brief Policy for clients, which lag behind producer */
+         enum ELagPolicy {
+            lagDrop,   ///< drop oldest buffers for the client, keeping lag within limit
+            lagSkip,   ///< skip all pending buffers, client continues with newest one
+            lagClose   ///< close connection with the client
+         };
+
+         /** \brief Read cursor and statistic of single client */
+         struct ClientRec {
+            uint64_t cursor;    ///< sequence number of next ring buffer for the client
+            uint64_t sent;      ///< number of buffers delivered to the client
+            uint64_t dropped;   ///< number of buffers dropped for the client
+            unsigned maxlag;    ///< lag limit of the client
+            ClientRec() : cursor(0), sent(0), dropped(0), maxlag(0) {}
+         };
+
          int fKind;             ///< kind: stream or transport
          int fPortNum;          ///< used port number (only for info)
          int fSlaveQueueLength; ///< queue length, used for slaves connections
@@ -115,6 +141,12 @@ namespace mbs {
          bool fDeliverAll;      ///< if true, server will try deliver all events when clients are there (default for transport)
          std::string fIterKind; ///< iterator kind when non-mbs events should be delivered to clients
          uint32_t fSubevId;     ///< subevent id when non-MBS events are used
+         unsigned fZeroCopy;    ///< minimal buffer size for zero-copy send to clients, 0 - disabled
+         dabc::BuffersQueue fRing; ///< buffers shared by all clients
+         uint64_t fRingFirst;   ///< sequence number of first buffer in the ring
+         unsigned fLagLimit;    ///< lag limit for new clients
+         int fLagPolicy;        ///< policy for lagging clients, see ELagPolicy
+         std::vector<ClientRec> fClients; ///< clients records, index is output number
 
          virtual bool StartTransport();
          virtual bool StopTransport();
@@ -127,6 +159,25 @@ namespace mbs {
 
          bool SendNextBuffer();
 
+         /** \brief Sequence number of next buffer which will be put into ring */
+         uint64_t RingEnd() const { return fRingFirst + fRing.Size(); }
+
+         /** \brief Send buffers from the ring to all clients which can accept them */
+         void DeliverToClients();
+
+         /** \brief Apply lag policy to clients, if ringfull is specified clients which need oldest buffer are treated */
+         void CheckClientsLag(bool ringfull);
+
+         /** \brief Remove from the ring buffers which are delivered to all clients */
+         void ReleaseRingBuffers();
+
+         /** \brief Provide clients statistic in hierarchy */
+         void UpdateClientsInfo();
+
+         virtual void ProcessTimerEvent(unsigned timer);
+
+         virtual void TransportCleanup();
+
          void ProcessConnectionActivated(const std::string &name, bool on);
 
       public:
@@ -24,9 +24,13 @@
 
 mbs::LmdInput::LmdInput(const dabc::Url& url) :
    dabc::FileInput(url),
-   fFile()
+   fFile(),
+   fMapped(),
+   fMapWindow(0)
 {
-   if (url.HasOption("rfio"))
+   if (url.HasOption("mmap"))
+      fMapWindow = ((uint64_t) url.GetOptionInt("mmap", 64)) * 1024 * 1024;
+   else if (url.HasOption("rfio"))
       fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("rfio::FileInterface"), true);
    else if (url.HasOption("ltsm"))
 	  fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("ltsm::FileInterface"), true);
@@ -51,6 +55,25 @@ bool mbs::LmdInput::OpenNextFile()
 
    if (!TakeNextFileName()) return false;
 
+   if (fMapWindow > 0) {
+      const mbs::FileHeader* hdr = nullptr;
+      if (fMapped.Open(CurrentFileName().c_str(), fMapWindow))
+         hdr = (const mbs::FileHeader*) fMapped.Map(sizeof(mbs::FileHeader));
+
+      // only LMD files created by DABC are supported, same as in mbs::LmdFile
+      if (!hdr || (hdr->iEndian != 1) || !hdr->isTypePair(0x65, 0x1) ||
+          (hdr->FullSize() != 0xfffffff0) || (hdr->iOffsetSize != 8)) {
+         EOUT("File %s is not supported LMD file", CurrentFileName().c_str());
+         fMapped.Close();
+         return false;
+      }
+
+      fMapped.Skip(sizeof(mbs::FileHeader));
+
+      DOUT1("Map lmd file %s for reading", CurrentFileName().c_str());
+      return true;
+   }
+
    if (!fFile.OpenReading(CurrentFileName().c_str())) {
       EOUT("Cannot open file %s for reading", CurrentFileName().c_str());
       return false;
@@ -65,6 +88,7 @@ bool mbs::LmdInput::OpenNextFile()
 bool mbs::LmdInput::CloseFile()
 {
    fFile.Close();
+   fMapped.Close();
    ClearCurrentFileName();
    return true;
 }
@@ -73,14 +97,54 @@ unsigned mbs::LmdInput::Read_Size()
 {
    // get size of the buffer which should be read from the file
 
-   if (!fFile.isReading())
+   if (!isReading() || (fMapWindow && fMapped.eof()))
       if (!OpenNextFile()) return dabc::di_EndOfStream;
 
    return dabc::di_DfltBufSize;
 }
 
+unsigned mbs::LmdInput::ReadMapped(dabc::Buffer& buf)
+{
+   // buffer from the pool only defines maximal size of produced buffer
+   uint64_t maxsize = ((uint64_t) (buf.SegmentSize(0) * fReduce))/8*8, size = 0;
+
+   while (size < maxsize) {
+      // events are collected only in same window, Map() creates new window when event crosses its boundary
+      const char* ptr = fMapped.Map(size + sizeof(mbs::Header));
+      if (!ptr) break;
+
+      uint64_t evsize = ((const mbs::Header*) (ptr + size))->FullSize();
+
+      if (size + evsize > maxsize) {
+         if (size > 0) break;
+         EOUT("Buffer %u too small to read next event %u from lmd file", (unsigned) maxsize, (unsigned) evsize);
+         return dabc::di_Error;
+      }
+
+      if (!fMapped.Map(size + evsize)) {
+         EOUT("Event of size %u truncated in file %s", (unsigned) evsize, CurrentFileName().c_str());
+         break;
+      }
+
+      size += evsize;
+   }
+
+   if (size == 0) {
+      DOUT3("File %s has no more events", CurrentFileName().c_str());
+      fMapped.Close();
+      return dabc::di_SkipBuffer;
+   }
+
+   buf = fMapped.Take(size);
+   buf.SetTypeId(mbs::mbt_MbsEvents);
+
+   return dabc::di_Ok;
+}
+
 unsigned mbs::LmdInput::Read_Complete(dabc::Buffer& buf)
 {
+   if (fMapWindow > 0) return ReadMapped(buf);
+
    uint64_t bufsize = 0;
 
    while (true) {
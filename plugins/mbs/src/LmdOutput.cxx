@@ -41,6 +41,9 @@ mbs::LmdOutput::LmdOutput(const dabc::Url& url) :
       fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("rfio::FileInterface"), true);
    else if (url.HasOption("ltsm"))
    	  fFile.SetIO((dabc::FileInterface*) dabc::mgr.CreateAny("ltsm::FileInterface"), true);
+   else if (url.HasOption("direct") || url.HasOption("prealloc") || url.HasOption("posix"))
+      // preallocation portion specified in MB
+      fFile.SetIO(new dabc::PosixFileInterface(url.HasOption("direct"), ((uint64_t) url.GetOptionInt("prealloc", 0)) << 20), true);
 }
 
 mbs::LmdOutput::~LmdOutput()
@@ -109,11 +112,17 @@ unsigned mbs::LmdOutput::Write_Buffer(dabc::Buffer& buf)
 
    unsigned numevents = mbs::ReadIterator::NumEvents(buf);
 
-   for (unsigned n=0;n<buf.NumSegments();n++)
-      if (!fFile.WriteBuffer(buf.SegmentPtr(n), buf.SegmentSize(n))) {
-         EOUT("lmd write error");
-         return dabc::do_Error;
-      }
+   std::vector<const void*> ptrs(buf.NumSegments());
+   std::vector<size_t> sizes(buf.NumSegments());
+   for (unsigned n=0;n<buf.NumSegments();n++) {
+      ptrs[n] = buf.SegmentPtr(n);
+      sizes[n] = buf.SegmentSize(n);
+   }
+
+   if (!fFile.WriteBuffers(ptrs.data(), sizes.data(), ptrs.size())) {
+      EOUT("lmd write error");
+      return dabc::do_Error;
+   }
 
    AccountBuffer(buf.GetTotalSize(), numevents);
 
@@ -16,6 +16,7 @@
 #include "mbs/ServerTransport.h"
 
 #include <unistd.h>
+#include <algorithm>
 
 #include "dabc/Manager.h"
 #include "dabc/DataTransport.h"
@@ -319,7 +320,13 @@ mbs::ServerTransport::ServerTransport(dabc::Command cmd, const dabc::PortRef& ou
    fBlocking(false),
    fDeliverAll(false),
    fIterKind(),
-   fSubevId(0x1f)
+   fSubevId(0x1f),
+   fZeroCopy(0),
+   fRing(std::max(1, url.GetOptionInt("ring", 4))),
+   fRingFirst(0),
+   fLagLimit(0),
+   fLagPolicy(lagDrop),
+   fClients()
 {
    // this addon handles connection
    AssignAddon(connaddon);
@@ -349,11 +356,37 @@ mbs::ServerTransport::ServerTransport(dabc::Command cmd, const dabc::PortRef& ou
 
    if (url.HasOption("deliverall")) fDeliverAll = true;
 
+   // zero-copy send of big buffers, value is minimal buffer size
+   if (url.HasOption("zerocopy")) {
+      int minsize = url.GetOptionInt("zerocopy", 0x100000);
+      fZeroCopy = minsize > 0 ? (unsigned) minsize : 0;
+   }
+
    DOUT0("Create MBS server fd:%d kind:%s port:%d limit:%d blocking:%s deliverall:%s",
          connaddon->Socket(), mbs::ServerKindToStr(fKind), fPortNum, fClientsLimit, DBOOL(fBlocking), DBOOL(fDeliverAll));
 
    if (fClientsLimit>0) DOUT0("Set client limit for MBS server to %d", fClientsLimit);
 
+   if (fZeroCopy>0) DOUT0("Use zero-copy send for MBS server buffers bigger than %u", fZeroCopy);
+
+   // maximal number of buffers, which client may lag behind producer
+   fLagLimit = fRing.Capacity();
+   if (url.HasOption("lag")) {
+      int lag = url.GetOptionInt("lag", fLagLimit);
+      if ((lag > 0) && ((unsigned) lag < fLagLimit)) fLagLimit = lag;
+   }
+
+   std::string policy = url.GetOptionStr("lagpolicy", "drop");
+   if (policy == "skip") fLagPolicy = lagSkip; else
+   if (policy == "close") fLagPolicy = lagClose; else
+   if (policy != "drop") EOUT("Unknown lag policy %s, use drop", policy.c_str());
+
+   if (!fDeliverAll)
+      DOUT0("MBS server ring size %u lag limit %u policy %s", fRing.Capacity(), fLagLimit, policy.c_str());
+
+   CreatePar("Clients").SetFld("lag", std::vector<int64_t>()).SetValue(0);
+   CreateTimer("ClientsTimer", 1.);
+
 //   DOUT0("mbs::ServerTransport   isinp=%s", DBOOL(connaddon->IsDoingInput()));
 }
 
@@ -361,6 +394,13 @@ mbs::ServerTransport::~ServerTransport()
 {
 }
 
+void mbs::ServerTransport::TransportCleanup()
+{
+   fRing.Cleanup();
+   fClients.clear();
+   dabc::Transport::TransportCleanup();
+}
+
 bool mbs::ServerTransport::StartTransport()
 {
    return dabc::Transport::StartTransport();
@@ -412,8 +452,16 @@ int mbs::ServerTransport::ExecuteCommand(dabc::Command cmd)
       // FIXME: should we configure buffer size or could one ignore it???
       addon->FillServInfo(0x400000, true);
 
+      if (fZeroCopy > 0) addon->SetZeroCopy(fZeroCopy);
+
       if (portindx<0) portindx = CreateOutput(dabc::format("Slave%u",NumOutputs()), fSlaveQueueLength);
 
+      // new client gets only buffers which will be received after connection
+      if (fClients.size() < NumOutputs()) fClients.resize(NumOutputs());
+      fClients[portindx] = ClientRec();
+      fClients[portindx].cursor = RingEnd();
+      fClients[portindx].maxlag = fLagLimit;
+
       dabc::TransportRef tr = new dabc::OutputTransport(dabc::Command(), FindPort(OutputName(portindx)), addon, true);
 
       tr()->AssignToThread(thread(), true);
@@ -444,6 +492,15 @@ int mbs::ServerTransport::ExecuteCommand(dabc::Command cmd)
       if (cnt>1) cmd.SetField("NumCanSend", cansend); else
       cmd.SetField("NumCanSend", 0);
 
+      std::vector<int64_t> lag, dropped;
+      for (unsigned n = 0; (n < NumOutputs()) && (n < fClients.size()); n++)
+         if (IsOutputConnected(n)) {
+            lag.push_back(RingEnd() - fClients[n].cursor);
+            dropped.push_back(fClients[n].dropped);
+         }
+      cmd.SetField("ClientLag", lag);
+      cmd.SetField("ClientDropped", dropped);
+
       cmd.SetStr("MbsKind", mbs::ServerKindToStr(fKind));
       cmd.SetInt("MbsPort", fPortNum);
       cmd.SetStr("MbsInfo", dabc::format("%s:%d NumClients:%d", mbs::ServerKindToStr(fKind), fPortNum, cnt));
@@ -454,40 +511,135 @@ int mbs::ServerTransport::ExecuteCommand(dabc::Command cmd)
    return dabc::Transport::ExecuteCommand(cmd);
 }
 
-bool mbs::ServerTransport::SendNextBuffer()
+void mbs::ServerTransport::DeliverToClients()
 {
-   if (!CanRecv()) return false;
+   uint64_t end = RingEnd();
 
-   // unconnected transport server will block until any connection is established
-   if ((NumOutputs()==0) && fBlocking /*&& (fKind == mbs::TransportServer) */) return false;
+   for (unsigned n = 0; (n < NumOutputs()) && (n < fClients.size()); n++) {
+      if (!IsOutputConnected(n)) continue;
 
-   bool allcansend = CanSendToAllOutputs(true);
+      ClientRec &rec = fClients[n];
 
-//   if (!allcansend)
-//      DOUT1("mbs::ServerTransport::ProcessRecv  numout:%u cansend:%s numwork:%u", NumOutputs(), DBOOL(allcansend), numoutputs);
+      // ring keeps buffer reference, client gets duplicate with same memory
+      while ((rec.cursor < end) && CanSend(n)) {
+         dabc::Buffer buf = fRing.Item(rec.cursor - fRingFirst).Duplicate();
+         Send(n, buf);
+         rec.cursor++;
+         rec.sent++;
+      }
+   }
+}
 
-   // in case of transport buffer all outputs should be
-   // ready to get next buffer. Otherwise input port will be blocked
-   if (!allcansend) {
-      // if server must deliver all events, than wait (default for transport, can be enabled for stream)
-      if (fDeliverAll) return false;
-      // if server do not blocks, first wait until input queue will be filled
-      if (!RecvQueueFull()) {
-         // DOUT0("mbs::ServerTransport::SendNextBuffer %s let input queue to be filled name size:%u", GetName(), NumCanRecv());
-         // dabc::SetDebugLevel(1);
-         SignalRecvWhenFull();
-         return false;
+void mbs::ServerTransport::CheckClientsLag(bool ringfull)
+{
+   // with deliverall producer waits for the slowest client
+   if (fDeliverAll) return;
+
+   uint64_t end = RingEnd();
+
+   for (unsigned n = 0; (n < NumOutputs()) && (n < fClients.size()); n++) {
+      if (!IsOutputConnected(n)) continue;
+
+      ClientRec &rec = fClients[n];
+
+      uint64_t lag = end - rec.cursor, maxlag = rec.maxlag;
+      // when ring is full, oldest buffer should be released
+      if (ringfull && (maxlag >= fRing.Capacity())) maxlag = fRing.Capacity() - 1;
+
+      if (lag <= maxlag) continue;
+
+      switch (fLagPolicy) {
+         case lagSkip:
+            rec.dropped += lag;
+            rec.cursor = end;
+            break;
+         case lagClose:
+            DOUT0("Close MBS client %s which lags %u buffers", OutputName(n).c_str(), (unsigned) lag);
+            rec.dropped += lag;
+            rec.cursor = end;
+            FindPort(OutputName(n)).Disconnect();
+            break;
+         default:
+            rec.dropped += lag - maxlag;
+            rec.cursor = end - maxlag;
+            break;
       }
-      // DOUT0("TRY TO SEND EVEN WHEN NOT POSSIBLE");
    }
+}
+
+void mbs::ServerTransport::ReleaseRingBuffers()
+{
+   // without connected clients min cursor is ring end and all buffers are released
+   uint64_t mincursor = RingEnd();
+
+   for (unsigned n = 0; (n < NumOutputs()) && (n < fClients.size()); n++)
+      if (IsOutputConnected(n) && (fClients[n].cursor < mincursor))
+         mincursor = fClients[n].cursor;
+
+   dabc::Buffer buf;
+   while (fRingFirst < mincursor) {
+      fRing.PopBuffer(buf);
+      buf.Release();
+      fRingFirst++;
+   }
+}
+
+void mbs::ServerTransport::UpdateClientsInfo()
+{
+   std::vector<std::string> names;
+   std::vector<int64_t> lag, queued, sent, dropped;
+
+   for (unsigned n = 0; (n < NumOutputs()) && (n < fClients.size()); n++) {
+      if (!IsOutputConnected(n)) continue;
+      names.push_back(OutputName(n));
+      lag.push_back(RingEnd() - fClients[n].cursor);
+      queued.push_back(OutputQueueCapacity(n) - NumCanSend(n));
+      sent.push_back(fClients[n].sent);
+      dropped.push_back(fClients[n].dropped);
+   }
+
+   dabc::Parameter par = Par("Clients");
+   par.SetField("names", names);
+   par.SetField("lag", lag);
+   par.SetField("queued", queued);
+   par.SetField("sent", sent);
+   par.SetField("dropped", dropped);
+   par.SetValue((int) names.size());
+}
+
+void mbs::ServerTransport::ProcessTimerEvent(unsigned timer)
+{
+   if (TimerName(timer) == "ClientsTimer")
+      UpdateClientsInfo();
+}
+
+bool mbs::ServerTransport::SendNextBuffer()
+{
+   DeliverToClients();
+   ReleaseRingBuffers();
+
+   if (!CanRecv() || (fDoingClose > 0)) return false;
 
-   // this is normal situation when buffer can be send to all outputs
+   // unconnected transport server will block until any connection is established
+   if ((NumOutputs()==0) && fBlocking /*&& (fKind == mbs::TransportServer) */) return false;
+
+   if (fRing.Full()) {
+      // apply lag policy to clients which still need oldest buffer
+      CheckClientsLag(true);
+      ReleaseRingBuffers();
+      // if server must deliver all events, than wait (default for transport, can be enabled for stream)
+      if (fRing.Full()) return false;
+   }
 
    dabc::Buffer buf = Recv();
 
    bool iseof = (buf.GetTypeId() == dabc::mbt_EOF);
 
-   SendToAllOutputs(buf);
+   fRing.PushBuffer(buf);
+
+   CheckClientsLag(false);
+   DeliverToClients();
+   ReleaseRingBuffers();
 
    if (iseof) {
       DOUT2("Server transport saw EOF buffer");
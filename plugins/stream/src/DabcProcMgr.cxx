@@ -32,12 +32,19 @@ stream::DabcProcMgr::DabcProcMgr() :
    fStore(),
    fStoreInfo("no store created"),
    fSortOrder(true),
-   fDefaultFill(3)
+   fDefaultFill(3),
+   fLocalBins(false),
+   fAccum(),
+   fAccumItems(),
+   fAccumHandles()
 {
 }
 
 stream::DabcProcMgr::~DabcProcMgr()
 {
+   for (unsigned n = 0; n < fAccum.size(); ++n)
+      delete fAccum[n];
+   fAccum.clear();
 }
 
 void stream::DabcProcMgr::SetTop(dabc::Hierarchy& top, bool withcmds)
@@ -87,6 +94,8 @@ void stream::DabcProcMgr::SetTop(dabc::Hierarchy& top, bool withcmds)
 
 void stream::DabcProcMgr::AddRunLog(const char *msg)
 {
+   // hierarchy may be shared with other managers
+   dabc::LockGuard lock(fTop.GetHMutex());
    dabc::Hierarchy h = fTop.GetHChild("Control/RunLog");
    h.SetField("value", msg);
    h.MarkChangedItems();
@@ -94,6 +103,7 @@ void stream::DabcProcMgr::AddRunLog(const char *msg)
 
 void stream::DabcProcMgr::AddErrLog(const char *msg)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    dabc::Hierarchy h = fTop.GetHChild("Control/ErrLog");
    h.SetField("value", msg);
    h.MarkChangedItems();
@@ -133,8 +143,10 @@ base::H1handle stream::DabcProcMgr::MakeH1(const char* name, const char* title,
    dabc::LockGuard lock(fTop.GetHMutex());
 
    dabc::Hierarchy h = fTop.GetHChild(name);
-   if (!h.null() && reuse && h.GetFieldPtr("bins"))
-      return (base::H1handle) h.GetFieldPtr("bins")->GetDoubleArr();
+   if (!h.null() && h.GetFieldPtr("bins")) {
+      if (reuse || (fLocalBins && h.HasField("_dabc_hist") && (h.GetFieldPtr("bins")->GetArraySize() == (int64_t) nbins + 5)))
+         return (base::H1handle) GetHandle(h, 3, false);
+   }
 
    if (!h) {
       std::string sname = name;
@@ -172,7 +184,7 @@ base::H1handle stream::DabcProcMgr::MakeH1(const char* name, const char* title,
 
    fTop.MarkChangedItems();
 
-   return (base::H1handle) h.GetFieldPtr("bins")->GetDoubleArr();
+   return (base::H1handle) GetHandle(h, 3, true);
 }
 
 base::H2handle stream::DabcProcMgr::MakeH2(const char* name, const char* title, int nbins1, double left1, double right1, int nbins2, double left2, double right2, const char* options)
@@ -206,8 +218,10 @@ base::H2handle stream::DabcProcMgr::MakeH2(const char* name, const char* title,
    dabc::LockGuard lock(fTop.GetHMutex());
 
    dabc::Hierarchy h = fTop.GetHChild(name);
-   if (!h.null() && reuse && h.GetFieldPtr("bins"))
-      return (base::H1handle) h.GetFieldPtr("bins")->GetDoubleArr();
+   if (!h.null() && h.GetFieldPtr("bins")) {
+      if (reuse || (fLocalBins && h.HasField("_dabc_hist") && (h.GetFieldPtr("bins")->GetArraySize() == 6 + (int64_t) (nbins1+2)*(nbins2+2))))
+         return (base::H2handle) GetHandle(h, 6, false);
+   }
 
    if (!h) {
       std::string sname = name;
@@ -253,13 +267,82 @@ base::H2handle stream::DabcProcMgr::MakeH2(const char* name, const char* title,
 
    fTop.MarkChangedItems();
 
-   return (base::H2handle) h.GetFieldPtr("bins")->GetDoubleArr();
+   return (base::H2handle) GetHandle(h, 6, true);
+}
+
+double *stream::DabcProcMgr::GetHandle(dabc::Hierarchy &h, unsigned first, bool reset)
+{
+   // returns handle for histogram - either published bins or private bins
+   // must be called with locked hierarchy mutex
+
+   auto fld = h.GetFieldPtr("bins");
+   if (!fld) return nullptr;
+
+   if (!fLocalBins) return fld->GetDoubleArr();
+
+   HistAccum *acc = nullptr;
+
+   auto iter = fAccumItems.find(h());
+   if (iter != fAccumItems.end()) {
+      acc = iter->second;
+      if (!reset && (acc->bins.size() == (unsigned) fld->GetArraySize()))
+         return acc->bins.data();
+      fAccumHandles.erase(acc->bins.data());
+   } else {
+      acc = new HistAccum;
+      acc->item = h;
+      fAccum.push_back(acc);
+      fAccumItems[h()] = acc;
+   }
+
+   // private bins start with content of published histogram
+   double *arr = fld->GetDoubleArr();
+   acc->first = first;
+   acc->bins.assign(arr, arr + fld->GetArraySize());
+   acc->synced = acc->bins;
+
+   fAccumHandles[acc->bins.data()] = acc;
+
+   return acc->bins.data();
+}
+
+void stream::DabcProcMgr::SyncHistograms()
+{
+   // add changes of private bins to published histograms
+   // private bins are only read here, therefore filling continues without locking
+
+   if (fAccum.empty()) return;
+
+   dabc::LockGuard lock(fTop.GetHMutex());
+
+   for (unsigned n = 0; n < fAccum.size(); ++n) {
+      HistAccum *acc = fAccum[n];
+      auto fld = acc->item.GetFieldPtr("bins");
+      if (!fld || (acc->bins.size() != (unsigned) fld->GetArraySize())) continue;
+
+      double *arr = fld->GetDoubleArr(), *bins = acc->bins.data(), *synced = acc->synced.data();
+      unsigned len = acc->bins.size();
+
+      for (unsigned k = acc->first; k < len; ++k) {
+         double v = bins[k];
+         if (v != synced[k]) {
+            arr[k] += v - synced[k];
+            synced[k] = v;
+         }
+      }
+   }
 }
 
 dabc::Hierarchy stream::DabcProcMgr::FindHistogram(void *handle)
 {
+   // must be called with locked hierarchy mutex
+
    if (!handle) return nullptr;
 
+   auto acc = fAccumHandles.find(handle);
+   if (acc != fAccumHandles.end())
+      return acc->second->item;
+
    dabc::Iterator iter(fTop);
    while (iter.next()) {
       dabc::Hierarchy item = iter.ref();
@@ -273,6 +356,7 @@ dabc::Hierarchy stream::DabcProcMgr::FindHistogram(void *handle)
 
 void stream::DabcProcMgr::SetH1Title(base::H1handle h1, const char *title)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    auto item = FindHistogram(h1);
    if (!item.null())
       item.SetField("_title", title);
@@ -280,6 +364,7 @@ void stream::DabcProcMgr::SetH1Title(base::H1handle h1, const char *title)
 
 void stream::DabcProcMgr::TagH1Time(base::H1handle h1)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    auto item = FindHistogram(h1);
    if (!item.null()) {
       auto now = dabc::DateTime().GetNow();
@@ -290,6 +375,7 @@ void stream::DabcProcMgr::TagH1Time(base::H1handle h1)
 
 void stream::DabcProcMgr::SetH2Title(base::H2handle h2, const char *title)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    auto item = FindHistogram(h2);
    if (!item.null())
       item.SetField("_title", title);
@@ -297,6 +383,7 @@ void stream::DabcProcMgr::SetH2Title(base::H2handle h2, const char *title)
 
 void stream::DabcProcMgr::TagH2Time(base::H2handle h2)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    auto item = FindHistogram(h2);
    if (!item.null()) {
       auto now = dabc::DateTime().GetNow();
@@ -308,12 +395,28 @@ void stream::DabcProcMgr::TagH2Time(base::H2handle h2)
 
 bool stream::DabcProcMgr::ClearHistogram(dabc::Hierarchy &item)
 {
+   // published bins also filled by SyncHistograms() of other managers and read by http thread
+   dabc::LockGuard lock(fTop.GetHMutex());
+   return _ClearHistogram(item);
+}
+
+bool stream::DabcProcMgr::_ClearHistogram(dabc::Hierarchy &item)
+{
+   // must be called with locked hierarchy mutex
+
    if (!item.HasField("_dabc_hist") || (item.GetFieldPtr("bins") == nullptr)) return false;
 
    if (item.HasField("_no_reset")) return true;
 
    int indx = item.GetField("_kind").AsStr()=="ROOT.TH1D" ? 3 : 6;
 
+   auto iter = fAccumItems.find(item());
+   if (iter != fAccumItems.end()) {
+      HistAccum *acc = iter->second;
+      for (unsigned k = indx; k < acc->bins.size(); ++k)
+         acc->bins[k] = acc->synced[k] = 0.;
+   }
+
    double* arr = item.GetFieldPtr("bins")->GetDoubleArr();
    int len = item.GetFieldPtr("bins")->GetArraySize();
    while (indx<len) arr[indx++]=0.;
@@ -327,17 +430,20 @@ void stream::DabcProcMgr::ClearAllHistograms()
 
 bool stream::DabcProcMgr::ClearAllDabcHistograms(dabc::Hierarchy &folder)
 {
+   dabc::LockGuard lock(fTop.GetHMutex());
    dabc::Iterator iter(folder);
    bool isany = true;
    while (iter.next()) {
       dabc::Hierarchy item = iter.ref();
-      if (ClearHistogram(item)) isany = true;
+      if (_ClearHistogram(item)) isany = true;
    }
    return isany;
 }
 
 bool stream::DabcProcMgr::SaveAllHistograms(dabc::Hierarchy &folder)
 {
+   SyncHistograms();
+
    dabc::Buffer buf = folder.SaveToBuffer();
 
    if (buf.GetTotalSize()==0) return false;
@@ -380,6 +486,9 @@ bool stream::DabcProcMgr::ExecuteHCommand(dabc::Command cmd)
 
    if ((name.find("HCMD_")!=0) && (name!="ROOTCMD")) return false;
 
+   // ensure that published histograms are up to date
+   SyncHistograms();
+
    dabc::Hierarchy item = cmd.GetRef("item");
    if (item.null()) return false;
    std::string res = "null";
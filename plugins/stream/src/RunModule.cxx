@@ -50,12 +50,20 @@ stream::RunModule::RunModule(const std::string &name, dabc::Command cmd) :
    fDidMerge(false),
    fTotalSize(0),
    fTotalEvnts(0),
-   fTotalOutEvnts(0)
+   fTotalOutEvnts(0),
+   fLocalBins(false),
+   fSharedHierarchy()
 {
    fParallel = Cfg("parallel", cmd).AsInt(0);
 
    fDefaultFill = Cfg("fillcolor", cmd).AsInt(3);
 
+   // histograms filled in private bins, published hierarchy updated with timer
+   fLocalBins = Cfg("localbins", cmd).AsBool(false);
+
+   // parallel workers fill histograms of main module
+   if (fParallel < 0) fSharedHierarchy = cmd.GetRef("hierarchy");
+
    // we need one input and no outputs
    EnsurePorts(1, fParallel<0 ? 0 : fParallel);
 
@@ -199,7 +207,11 @@ void stream::RunModule::OnThreadAssigned()
 
       fProcMgr = new DabcProcMgr;
       fProcMgr->SetDefaultFill(fDefaultFill);
-      fProcMgr->SetTop(fWorkerHierarchy, fParallel==0);
+      fProcMgr->SetLocalBins(fLocalBins);
+      if (!fSharedHierarchy.null())
+         fProcMgr->SetTop(fSharedHierarchy, false);
+      else
+         fProcMgr->SetTop(fWorkerHierarchy, fParallel==0);
 
       std::string src = "Source: ";
       src += FindPort(InputName(0)).Cfg("url").AsStr();
@@ -241,6 +253,8 @@ void stream::RunModule::OnThreadAssigned()
          dabc::CmdCreateModule cmd("stream::RunModule", mname);
          cmd.SetPtr("initfunc", fInitFunc);
          cmd.SetInt("parallel", -1);
+         cmd.SetBool("localbins", fLocalBins);
+         if (fLocalBins) cmd.SetRef("hierarchy", fWorkerHierarchy);
 
          DOUT0("Create module %s", mname.c_str());
 
@@ -265,6 +279,21 @@ void stream::RunModule::ProduceMergedHierarchy()
 
    fDidMerge = true;
 
+   if (fLocalBins) {
+      // workers fill histograms directly in hierarchy of this module
+      // when stopped, workers add remaining data to the histograms
+      for (int n=0;n<fParallel;n++) {
+         dabc::ModuleRef m = dabc::mgr.FindModule(dabc::format("%s%03d", GetName(), n));
+         m.Stop();
+      }
+
+      DOUT0("Histograms of %d workers filled in common hierarchy", fParallel);
+
+      if (fAsf.length()>0)
+         SaveHierarchy(fWorkerHierarchy.SaveToBuffer());
+      return;
+   }
+
    dabc::PublisherRef publ = GetPublisher();
 
    dabc::Hierarchy main;
@@ -415,7 +444,10 @@ void stream::RunModule::SaveHierarchy(dabc::Buffer buf)
 
 void stream::RunModule::AfterModuleStop()
 {
-   if (fProcMgr) fProcMgr->UserPostLoop();
+   if (fProcMgr) {
+      fProcMgr->UserPostLoop();
+      fProcMgr->SyncHistograms();
+   }
 
    // DOUT0("!!!! thread on start %s  !!!!!", thread().GetName());
 
@@ -599,6 +631,7 @@ void stream::RunModule::ProcessTimerEvent(unsigned timer)
       return;
    }
 
+   if (fProcMgr) fProcMgr->SyncHistograms();
 
    hadaq::HldProcessor *hld = dynamic_cast<hadaq::HldProcessor*> (fProcMgr->FindProc("HLD"));
    if (!hld) return;
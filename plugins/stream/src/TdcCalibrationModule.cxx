@@ -91,6 +91,7 @@ stream::TdcCalibrationModule::TdcCalibrationModule(const std::string &name, dabc
       fOwnProcMgr = true;
       fProcMgr = new stream::DabcProcMgr();
       fProcMgr->SetHistFilling(hfill); // set default for newly created processes
+      fProcMgr->SetLocalBins(Cfg("LocalBins", cmd).AsBool(false)); // histograms filled without locking
       fProcMgr->SetTop(fWorkerHierarchy);
    }
 
@@ -195,6 +196,10 @@ stream::TdcCalibrationModule::TdcCalibrationModule(const std::string &name, dabc
    if (fAutoTdcMode > 0)
       CreateTimer("RecheckTimer", 5.);
 
+   // update published histograms
+   if (fOwnProcMgr && fProcMgr->IsLocalBins())
+      CreateTimer("HistTimer", 1.);
+
    DOUT0("TdcCalibrationModule dummy %s autotdc %d histfill %d replace %s", DBOOL(fDummy), fAutoCalibr, hfill, DBOOL(fReplace));
 }
 
@@ -210,8 +215,13 @@ stream::TdcCalibrationModule::~TdcCalibrationModule()
    fProcMgr = nullptr;
 }
 
-void stream::TdcCalibrationModule::ProcessTimerEvent(unsigned)
+void stream::TdcCalibrationModule::ProcessTimerEvent(unsigned timer)
 {
+   if (TimerName(timer) == "HistTimer") {
+      fProcMgr->SyncHistograms();
+      return;
+   }
+
    fRecheckTdcs = (fAutoTdcMode > 0);
    if (fWarningCnt >= 0) fWarningCnt--;
 }
@@ -826,6 +836,8 @@ void stream::TdcCalibrationModule::BeforeModuleStart()
 
 void stream::TdcCalibrationModule::AfterModuleStop()
 {
+   if (fOwnProcMgr) fProcMgr->SyncHistograms();
+
    //fProfiler.MakeStatistic();
    //DOUT0("PROFILER %s", fProfiler.Format().c_str());
 
@@ -22,11 +22,23 @@
 #include "dabc/Command.h"
 #include "dabc/Worker.h"
 
+#include <map>
+#include <vector>
+
 namespace stream {
 
    class DabcProcMgr : public base::ProcMgr {
       protected:
 
+         /** Private bins of histogram, filled by analysis without any locking.
+          * Changes are added to published "bins" field in SyncHistograms() */
+         struct HistAccum {
+            dabc::Hierarchy item;        ///<! published histogram item
+            unsigned first;              ///<! first content index, before only binning information
+            std::vector<double> bins;    ///<! private bins, pointer used as histogram handle
+            std::vector<double> synced;  ///<! bins content already added to published item
+         };
+
          dabc::Hierarchy fTop;
          bool fWorkingFlag;
 
@@ -35,7 +47,15 @@ namespace stream {
          bool fSortOrder;          ///<! sorting order
          int  fDefaultFill;        ///<! default fill color
 
+         bool fLocalBins;          ///<! when true, histograms filled in private bins
+         std::vector<HistAccum*> fAccum;                     ///<! all private bins
+         std::map<const void*, HistAccum*> fAccumItems;     ///<! private bins for hierarchy item
+         std::map<const void*, HistAccum*> fAccumHandles;   ///<! private bins for histogram handle
+
+         double *GetHandle(dabc::Hierarchy &h, unsigned first, bool reset);
+
          bool ClearHistogram(dabc::Hierarchy& item);
+         bool _ClearHistogram(dabc::Hierarchy& item);
 
          dabc::Hierarchy FindHistogram(void *handle);
 
@@ -50,6 +70,14 @@ namespace stream {
 
          void SetDefaultFill(int fillcol = 3) { fDefaultFill = fillcol; }
 
+         /** Enable filling of histograms in private bins, must be set before histograms are created.
+          * Existing histogram with same binning is reused, therefore several managers
+          * can fill same histograms in common hierarchy */
+         void SetLocalBins(bool on = true) { fLocalBins = on; }
+         bool IsLocalBins() const { return fLocalBins; }
+
+         void SyncHistograms();
+
          bool IsWorking() const { return fWorkingFlag; }
 
          // redefine only make procedure, fill and clear should work
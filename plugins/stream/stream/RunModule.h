@@ -47,6 +47,8 @@ namespace stream {
       long unsigned fTotalEvnts;
       long unsigned fTotalOutEvnts;
       int           fDefaultFill;   ///<! default fill color for 1-D histograms
+      bool          fLocalBins;     ///<! histograms filled in private bins of DabcProcMgr
+      dabc::Hierarchy fSharedHierarchy; ///<! hierarchy of main module, where parallel workers fill histograms
 
       virtual int ExecuteCommand(dabc::Command cmd);
 
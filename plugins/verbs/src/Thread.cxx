@@ -231,6 +231,7 @@ void verbs::Thread::_Fire(const dabc::EventId& evnt, int nq)
 
 bool verbs::Thread::WaitEvent(dabc::EventId& evid, double tmout_sec)
 {
+   if (TakeDrainedEvent(evid)) return true;
 
 //   if (tmout_sec>=0) EOUT("Non-empty timeout");
 